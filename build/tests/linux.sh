@@ -3,3 +3,5 @@ cc -o executables/echo_args executables/echo_args.c
 cc -o executables/echo_stdin executables/echo_stdin.c
 cc -I../include -o executables/addsub.so -fPIC -shared executables/addsub.c ../lib/libbs.so
 cc -I../include -o executables/invalid.so -fPIC -shared executables/invalid.c ../lib/libbs.so
+../bin/bs --emit-c aot/main.bs > executables/aot.c
+cc -I../include -o executables/aot executables/aot.c ../lib/libbs.a -lm
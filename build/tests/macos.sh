@@ -3,3 +3,5 @@ cc -o executables/echo_args executables/echo_args.c
 cc -o executables/echo_stdin executables/echo_stdin.c
 cc -I../include -o executables/addsub.dylib -fPIC -shared executables/addsub.c ../lib/libbs.dylib
 cc -I../include -o executables/invalid.dylib -fPIC -shared executables/invalid.c ../lib/libbs.dylib
+../bin/bs --emit-c aot/main.bs > executables/aot.c
+cc -I../include -o executables/aot executables/aot.c ../lib/libbs.a -lm
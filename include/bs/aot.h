@@ -0,0 +1,105 @@
+#ifndef BS_AOT_H
+#define BS_AOT_H
+
+#include "jit.h"
+
+// Ahead of time compilation
+//
+// `bs --emit-c script.bs` compiles a script and writes its chunks out as C data, along with a
+// main() which loads them straight into a fresh VM. Linked against libbs, this gives an executable
+// which needs neither the source file nor the compiler at startup. The source is still embedded,
+// since errors quote the offending line
+//
+// Each function also gets translated into a C function, op by op, which takes the place of the
+// machine code of the JIT and follows the same contract as bs_jit_run(). This covers the ops the
+// JIT has templates for: the stack and local variable ops, constants, arithmetic and comparisons
+// on numbers, jumps, conditions and numeric for loops. Every other op, as well as any of these
+// whose operands are not numbers, hands control back to the interpreter, which carries on from
+// there and enters the C code again at the next call, return or loop back edge. So calls, method
+// invocations, containers, strings and everything else run at the speed of the interpreter,
+// while tight numeric code runs natively on every platform, not just where the JIT is available.
+// The C code is used even with `--no-jit`, and the JIT never compiles these functions on top
+//
+// Modules imported at runtime are compiled as they are imported, and run in the interpreter and
+// the JIT as usual
+typedef enum {
+    BS_AOT_NIL,
+    BS_AOT_NUM,
+    BS_AOT_BOOL,
+    BS_AOT_STR,
+    BS_AOT_FN,
+    BS_AOT_TABLE,
+} Bs_Aot_Kind;
+
+typedef struct {
+    Bs_Aot_Kind kind;
+    union {
+        double      number;
+        bool        boolean;
+        const char *data;
+        size_t      index; // Into the functions or the tables of the module
+    };
+    size_t size;
+} Bs_Aot_Value;
+
+typedef struct {
+    size_t index;
+    size_t row;
+    size_t col;
+
+    // Into the source of the module
+    size_t line;
+    size_t line_size;
+} Bs_Aot_Loc;
+
+typedef struct {
+    const char *name;
+    size_t      name_size;
+
+    size_t arity;
+    bool   variadic;
+    bool   variadic_view;
+    size_t upvalues;
+    size_t stack_size;
+
+    const uint8_t *code;
+    size_t         code_size;
+
+    const Bs_Aot_Value *constants;
+    size_t              constants_count;
+
+    const Bs_Aot_Loc *locations;
+    size_t            locations_count;
+
+    // NULL if none of the ops could be translated
+    Bs_Jit_Native native;
+} Bs_Aot_Fn;
+
+// Keys and values, one after the other
+typedef struct {
+    const Bs_Aot_Value *entries;
+    size_t              count;
+} Bs_Aot_Table;
+
+typedef struct {
+    const char *path;
+    const char *source;
+
+    // The first one is the module itself
+    const Bs_Aot_Fn *fns;
+    size_t           fns_count;
+
+    const Bs_Aot_Table *tables;
+    size_t              tables_count;
+} Bs_Aot_Module;
+
+// Used by the generated code, see bs_value_is_falsey()
+#define bs_aot_falsey(v)                                                                           \
+    ((v).type == BS_VALUE_NIL || ((v).type == BS_VALUE_BOOL && !(v).as.boolean))
+
+bool bs_aot_emit(Bs *bs, Bs_Writer *w, Bs_Sv path, Bs_Sv input);
+
+Bs_Fn *bs_aot_load(Bs *bs, const Bs_Aot_Module *module);
+int    bs_aot_main(const Bs_Aot_Module *module, int argc, char **argv);
+
+#endif // BS_AOT_H
@@ -23,6 +23,7 @@ Bs_Sv bs_sv_split(Bs_Sv *s, char ch);
 
 bool bs_sv_eq(Bs_Sv a, Bs_Sv b);
 bool bs_sv_find(Bs_Sv s, char ch, size_t *index);
+bool bs_sv_find_sv(Bs_Sv s, Bs_Sv pattern, size_t *index);
 bool bs_sv_prefix(Bs_Sv a, Bs_Sv b);
 bool bs_sv_suffix(Bs_Sv a, Bs_Sv b);
 
@@ -0,0 +1,44 @@
+#ifndef BS_JIT_H
+#define BS_JIT_H
+
+#include "object.h"
+
+// Baseline JIT
+//
+// Translates the chunk of a hot function into machine code by stitching together a template for
+// each op. The code works directly on the frame and the stack of the interpreter, and hands control
+// back to it at the first op which has no template or whose guard fails, so the interpreter can
+// always carry on from where the code left off. Only available on x86-64 Linux, everywhere else
+// compilation simply fails and everything keeps being interpreted
+#define BS_JIT_THRESHOLD 1000
+
+// Code compiled ahead of time with the same contract as bs_jit_run(), given the constants of the
+// chunk. See aot.h
+typedef size_t (*Bs_Jit_Native)(
+    const Bs_Value *constants, size_t offset, Bs_Value *base, Bs_Value **top);
+
+struct Bs_Jit {
+    uint8_t *code;
+    size_t   size;
+
+    // Set instead of the code for the functions which were compiled ahead of time
+    Bs_Jit_Native   native;
+    const Bs_Value *constants;
+
+    // The offset into the code of each op in the chunk, or BS_JIT_NONE for the ops which have no
+    // template and the bytes in between
+    uint32_t *entries;
+    size_t    count;
+};
+
+#define BS_JIT_NONE UINT32_MAX
+
+Bs_Jit *bs_jit_compile(Bs *bs, const Bs_Fn *fn);
+Bs_Jit *bs_jit_native(Bs *bs, Bs_Jit_Native native, const Bs_Value *constants);
+void    bs_jit_free(Bs *bs, Bs_Jit *jit);
+
+// Runs the code from the op at `offset`, where `*top` points right past the top of the stack.
+// Returns the offset of the op to continue interpreting from, and updates `*top`
+size_t bs_jit_run(const Bs_Jit *jit, size_t offset, Bs_Value *base, Bs_Value **top);
+
+#endif // BS_JIT_H
@@ -0,0 +1,28 @@
+#ifndef BS_JSON_H
+#define BS_JSON_H
+
+#include "vm.h"
+
+// JSON
+//
+// Objects map to tables, arrays to arrays and null to nil. Both directions must run inside a native
+// call, as the values being built or walked are kept alive as handles
+//
+// The parser works straight off the input, which is length delimited. Strings without escapes are
+// scanned 16 bytes at a time where SSE2 is available and interned as is, members are gathered on a
+// scratch stack first so that every array and table is allocated at its final size
+#define BS_JSON_MAX_DEPTH 1024
+
+typedef struct {
+    size_t      offset;
+    const char *message;
+} Bs_Json_Error;
+
+// Parses a single value, surrounded by nothing but whitespace
+bool bs_json_parse(Bs *bs, Bs_Sv input, Bs_Value *value, Bs_Json_Error *error);
+
+// Writes the value in compact form if `indent` is 0, one member per line otherwise. Raises an error
+// for values which have no JSON representation
+void bs_json_write(Bs *bs, Bs_Writer *writer, Bs_Value value, size_t indent);
+
+#endif // BS_JSON_H
@@ -28,6 +28,9 @@ bool bs_map_remove(Bs *bs, Bs_Map *map, Bs_Value key);
 bool bs_map_get(Bs *bs, Bs_Map *map, Bs_Value key, Bs_Value *value);
 bool bs_map_set(Bs *bs, Bs_Map *map, Bs_Value key, Bs_Value value);
 
+// Makes room for `count` more entries, so that inserting them never rehashes
+void bs_map_reserve(Bs *bs, Bs_Map *map, size_t count);
+
 void bs_map_copy(Bs *bs, Bs_Map *dst, const Bs_Map *src);
 
 #endif // BS_MAP_H
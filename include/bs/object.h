@@ -46,12 +46,18 @@ void bs_chunk_push_op_loc(Bs *bs, Bs_Chunk *c, Bs_Loc loc);
 void bs_chunk_push_op_int(Bs *bs, Bs_Chunk *chunk, Bs_Op op, size_t value);
 void bs_chunk_push_op_value(Bs *bs, Bs_Chunk *chunk, Bs_Op op, Bs_Value value);
 
+// The size of the op at `offset` along with its operands
+size_t bs_chunk_op_size(const Bs_Chunk *chunk, size_t offset);
+
 struct Bs_Object {
     Bs_Object_Type type;
     Bs_Object *next;
     bool marked;
 };
 
+// See jit.h
+typedef struct Bs_Jit Bs_Jit;
+
 struct Bs_Fn {
     Bs_Object meta;
 
@@ -63,6 +69,19 @@ struct Bs_Fn {
     bool variadic;
     size_t upvalues;
 
+    // The variadic arguments never outlive a call, so they are passed as a view into the stack
+    bool variadic_view;
+
+    // The most stack slots a call can use, including the receiver and the arguments
+    size_t stack_size;
+
+    // A function which captures nothing always evaluates to this same closure
+    Bs_Closure *closure;
+
+    // Machine code for the function once it has been entered or looped in often enough
+    Bs_Jit *jit;
+    size_t  hotness;
+
     // In case the function was compiled at runtime using meta.compile() or meta.eval()
     Bs_Str *source;
 
@@ -102,21 +121,13 @@ bool bs_table_remove(Bs *bs, Bs_Table *table, Bs_Value key);
 bool bs_table_get(Bs *bs, Bs_Table *table, Bs_Value key, Bs_Value *value);
 bool bs_table_set(Bs *bs, Bs_Table *table, Bs_Value key, Bs_Value value);
 
-typedef struct {
-    Bs_Closure **data;
-    size_t count;
-    size_t capacity;
-} Bs_Defers;
-
 struct Bs_Closure {
     Bs_Object meta;
     Bs_Fn *fn;
 
-    Bs_Defers defers; // Owned
-    bool defer_started;
-
+    // Either upvalues, or the values themselves for the locals which are never assigned
     size_t upvalues;
-    Bs_Upvalue *data[];
+    Bs_Value data[];
 };
 
 Bs_Closure *bs_closure_new(Bs *bs, Bs_Fn *fn);
@@ -153,6 +164,15 @@ typedef void (*Bs_C_Class_Free)(void *userdata, void *instance_data);
 typedef void (*Bs_C_Class_Mark)(Bs *bs, void *instance_data);
 typedef void (*Bs_C_Class_Show)(Bs_Pretty_Printer *printer, const void *instance_data);
 
+// Makes the instances iterable with a for loop. Returns false once there are no more values
+typedef bool (*Bs_C_Class_Next)(Bs *bs, void *instance_data, Bs_Value *value);
+
+// Makes the instances indexable with numbers, which also gives them len() and for loops. The index
+// is already checked to be less than the count when get and set are called
+typedef size_t (*Bs_C_Class_Count)(const void *instance_data);
+typedef Bs_Value (*Bs_C_Class_Get)(Bs *bs, const void *instance_data, size_t index);
+typedef void (*Bs_C_Class_Set)(Bs *bs, void *instance_data, size_t index, Bs_Value value);
+
 struct Bs_C_Class {
     Bs_Object meta;
     Bs_Sv name;
@@ -163,6 +183,15 @@ struct Bs_C_Class {
     Bs_C_Class_Free free;
     Bs_C_Class_Mark mark;
     Bs_C_Class_Show show;
+    Bs_C_Class_Next next;
+
+    Bs_C_Class_Count count;
+    Bs_C_Class_Get get;
+    Bs_C_Class_Set set;
+
+    // Whatever the native code wants to keep per class rather than per instance. Marked along with
+    // the class
+    Bs_Value shared;
 
     bool can_fail;
 };
@@ -4,7 +4,9 @@
 typedef enum {
     BS_OP_RET,
     BS_OP_CALL,
+    BS_OP_TAIL_CALL,
     BS_OP_DEFER,
+    BS_OP_DEFER_INVOKE,
     BS_OP_SPREAD,
     BS_OP_CLOSURE,
     BS_OP_CALL_INIT,
@@ -95,13 +97,69 @@ typedef enum {
     BS_OP_THEN,
     BS_OP_MATCH,
     BS_OP_MATCH_IF,
+    BS_OP_MATCH_TABLE,
 
     BS_OP_ITER,
     BS_OP_RANGE,
     BS_OP_IRANGE,
+    BS_OP_RANGE_INIT,
+
+    // Quickened variants, rewritten in place by the interpreter after observing the operand
+    // types of their generic counterparts. Each one has the exact same encoding as its generic
+    // op and falls back to it when its guard fails
+    BS_OP_ADD_NUM,
+    BS_OP_SUB_NUM,
+    BS_OP_MUL_NUM,
+    BS_OP_DIV_NUM,
+
+    BS_OP_GT_NUM,
+    BS_OP_GE_NUM,
+    BS_OP_LT_NUM,
+    BS_OP_LE_NUM,
+
+    BS_OP_IGET_ARRAY_INDEX,
+    BS_OP_ITER_ARRAY,
+    BS_OP_ITER_STR,
+    BS_OP_ITER_MAP,
+    BS_OP_INVOKE_INSTANCE,
+
+    // Superinstructions, written by the compiler over the first op of a matching sequence once
+    // a function has been compiled. The rest of the sequence is left intact, so it still works as
+    // a jump target, as the source of error locations, and as the fallback when a guard fails
+    BS_OP_LGET_LGET_ADD,
+    BS_OP_LGET_CONST_LT_ELSE,
+    BS_OP_LGET_IGET_CONST,
+    BS_OP_INCR_LOCAL,
+
+    // Register forms, laid over the stack code in the same way as the superinstructions. They are
+    // three-address ops which read their operands from the frame or the constants, and write the
+    // result back to the frame instead of going through the stack. The binary operator is the one
+    // in the original sequence
+    BS_OP_REG_BINARY,      // LGET a; LGET|CONST b; <binary>
+    BS_OP_REG_BINARY_SET,  // LGET a; LGET|CONST b; <binary>; LSET c; DROP
+    BS_OP_REG_BINARY_ELSE, // LGET a; LGET|CONST b; <binary>; ELSE; DROP
+    BS_OP_REG_TOP,         // LGET b; <binary>
+    BS_OP_REG_TOP_SET,     // LGET b; <binary>; LSET c; DROP
+    BS_OP_REG_MOVE,        // LGET a; LSET c; DROP
+    BS_OP_REG_LOAD,        // CONST k; LSET c; DROP
     BS_COUNT_OPS,
 } Bs_Op;
 
+// The loop variables of BS_OP_ITER which are referenced by the body. Unused ones are left as nil
+typedef enum {
+    BS_ITER_KEY = 1 << 0,
+    BS_ITER_VALUE = 1 << 1,
+} Bs_Iter_Bindings;
+
+// The captures which follow BS_OP_CLOSURE, each one a kind and an index
+typedef enum {
+    BS_CAPTURE_UPVALUE, // An upvalue of the enclosing function
+    BS_CAPTURE_LOCAL,   // A local of the enclosing function, shared through an upvalue
+    BS_CAPTURE_VALUE,   // A local of the enclosing function which is never assigned, copied
+} Bs_Capture;
+
 Bs_Op bs_op_get_to_set(Bs_Op op);
+Bs_Op bs_op_generic(Bs_Op op);
+const char *bs_op_name(Bs_Op op);
 
 #endif // BS_OP_H
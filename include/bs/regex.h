@@ -0,0 +1,41 @@
+#ifndef BS_REGEX_H
+#define BS_REGEX_H
+
+#include "vm.h"
+
+// Regular Expressions
+//
+// POSIX extended syntax, plus the \w \W \s \S \d \D classes and the \b \B \< \> word assertions.
+// Patterns are compiled to a small NFA program and matched without backtracking
+//
+// A search first runs a lazy DFA, which is built one state at a time as the text demands it and
+// kept around for later searches. It answers whether there is a match at all, which is the common
+// case when filtering lines, and narrows down where the first one lies. Only that stretch of the
+// text is then run through a Pike VM, which finds the exact match and the positions of the groups.
+// The match is the leftmost-longest one, like in POSIX. The groups are not: they come from the
+// thread with the highest priority among those that produce that match, which is the order a
+// backtracking engine tries things in. A group inside a repetition holds its last iteration
+//
+// The text is length delimited. The search can start at an offset into it, `^` still only matches
+// at the very beginning
+typedef struct Bs_Regex Bs_Regex;
+
+typedef struct {
+    size_t begin;
+    size_t end;
+} Bs_Regex_Span;
+
+// The span of a group which did not take part in the match
+#define BS_REGEX_NONE SIZE_MAX
+
+// Returns NULL if the pattern is invalid
+Bs_Regex *bs_regex_new(Bs *bs, Bs_Sv pattern);
+void      bs_regex_free(Bs_Regex *regex);
+
+// The number of groups, counting the whole match as the 0th
+size_t bs_regex_groups(const Bs_Regex *regex);
+
+// Finds the first match at or after `offset`, and writes the spans of the first `count` groups
+bool bs_regex_find(Bs_Regex *regex, Bs_Sv text, size_t offset, Bs_Regex_Span *spans, size_t count);
+
+#endif // BS_REGEX_H
@@ -0,0 +1,28 @@
+#ifndef BS_SERIAL_H
+#define BS_SERIAL_H
+
+#include "vm.h"
+
+// Binary Serialization
+//
+// Covers nil, booleans, numbers, strings, arrays and tables. Both directions must run inside a
+// native call, as the values being built or walked are kept alive as handles
+//
+// The data starts with a header, the distinct strings and the number of arrays and tables, so that
+// the reader can intern every string and size its tables up front. The value follows as a tree of
+// tagged items. An array or table which was already written is referred to by the order in which
+// it first appeared, so shared and cyclic values come back with the same shape
+//
+// Nesting is walked with an explicit stack, there is no depth limit
+typedef struct {
+    size_t      offset;
+    const char *message;
+} Bs_Serial_Error;
+
+// Raises an error for values which cannot be serialized
+void bs_serialize(Bs *bs, Bs_Writer *writer, Bs_Value value);
+
+// Reads a single value, which must span the whole input
+bool bs_deserialize(Bs *bs, Bs_Sv input, Bs_Value *value, Bs_Serial_Error *error);
+
+#endif // BS_SERIAL_H
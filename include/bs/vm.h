@@ -9,8 +9,14 @@
 #include "lexer.h"
 #include "value.h"
 
-#define BS_STACK_CAPACITY  (128 * 1024)
-#define BS_FRAMES_CAPACITY (8 * 1024)
+// The maximum sizes of the stacks. Only address space is reserved for these, the memory itself is
+// committed BS_STACK_COMMIT_BYTES at a time and doubled as needed
+#define BS_STACK_CAPACITY     (1024 * 1024)
+#define BS_FRAMES_CAPACITY    (32 * 1024)
+#define BS_STACK_COMMIT_BYTES (16 * 1024)
+
+// The maximum nesting of bs_call(), as every level of it also consumes the native C stack
+#define BS_CALLS_CAPACITY (4 * 1024)
 
 // Interface
 typedef struct Bs Bs;
@@ -19,6 +25,7 @@ typedef Bs_Value (*Bs_C_Fn_Ptr)(Bs *bs, Bs_Value *args, size_t arity);
 Bs   *bs_new(int argc, char **argv);
 void  bs_free(Bs *bs);
 void  bs_mark(Bs *bs, Bs_Object *object);
+void  bs_mark_value(Bs *bs, Bs_Value value);
 void *bs_realloc(Bs *bs, void *ptr, size_t old_size, size_t new_size);
 
 Bs_Str    *bs_str_new(Bs *bs, Bs_Sv sv);
@@ -55,6 +62,9 @@ typedef struct {
     size_t stack_count;
     size_t bases_count;
     size_t frames_count;
+    size_t views_count;
+    size_t defers_count;
+    size_t calls;
 
     jmp_buf point;
 } Bs_Unwind;
@@ -73,6 +83,9 @@ typedef struct {
 
     Bs_Unwind unwind;
 
+    // Compile hot functions to machine code where supported. See jit.h
+    bool jit;
+
     bool showed_const_correctness_warning_repl;
 } Bs_Config;
 
@@ -211,8 +224,26 @@ typedef struct {
 const Bs_Closure *bs_compile_module(Bs *bs, Bs_Sv path, Bs_Sv input, bool is_main, bool is_repl);
 
 Bs_Result bs_run(Bs *bs, Bs_Sv path, Bs_Sv input, bool is_repl);
+
+// Runs a module which is already compiled, with `path` as the path it was compiled from. See aot.h
+Bs_Result bs_run_fn(Bs *bs, Bs_Sv path, Bs_Fn *fn);
 Bs_Value  bs_call(Bs *bs, Bs_Value fn, const Bs_Value *args, size_t arity);
 
+// A call which a native makes over and over again with the same function and arity. The callee is
+// resolved once, and a closure (or a method bound to one) then gets its frame pushed directly on
+// every invocation instead of going through the generic call path. Anything else simply falls back
+// to bs_call(). The function must stay reachable for as long as the call is used
+typedef struct {
+    Bs         *bs;
+    Bs_Value    fn;
+    size_t      arity;
+    Bs_Value    this;
+    Bs_Closure *closure;
+} Bs_Call;
+
+Bs_Call  bs_call_prepare(Bs *bs, Bs_Value fn, size_t arity);
+Bs_Value bs_call_invoke(const Bs_Call *call, const Bs_Value *args);
+
 // Dynamic Array
 #define BS_DA_INIT_CAP 128
 
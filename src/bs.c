@@ -13,6 +13,7 @@
 #    define PATH_SEPARATOR '/'
 #endif
 
+#include "bs/aot.h"
 #include "bs/vm.h"
 
 static bool error_was_standalone;
@@ -171,8 +172,42 @@ static void bs_history_path(char *buffer, size_t size) {
 int main(int argc, char **argv) {
     crossline_prompt_color_set(CROSSLINE_FGCOLOR_BLUE);
 
+    bool jit = true;
+    if (argc >= 2 && !strcmp(argv[1], "--no-jit")) {
+        jit = false;
+        argc--;
+        argv++;
+    }
+
+    bool emit_c = false;
+    if (argc >= 3 && !strcmp(argv[1], "--emit-c")) {
+        emit_c = true;
+        argc--;
+        argv++;
+    }
+
     Bs *bs = bs_new(argc - 1, argv + 1);
     bs_config(bs)->error.write = bs_error_write_colors;
+    bs_config(bs)->jit = jit;
+
+    if (emit_c) {
+        const char *path = argv[1];
+
+        size_t size = 0;
+        char  *contents = bs_read_file(path, &size, false);
+        if (!contents) {
+            bs_error_standalone(bs, "could not read file '%s'", path);
+            bs_free(bs);
+            return 1;
+        }
+
+        Bs_Writer  w = bs_file_writer(stdout);
+        const bool ok = bs_aot_emit(bs, &w, bs_sv_from_cstr(path), Bs_Sv(contents, size));
+        free(contents);
+
+        bs_free(bs);
+        return !ok;
+    }
 
     if (argc < 2 || !strcmp(argv[1], "-")) {
         Bs_Result result = {0};
@@ -0,0 +1,653 @@
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include "bs/aot.h"
+
+typedef struct {
+    const Bs_Fn **data;
+    size_t        count;
+    size_t        capacity;
+} Bs_Aot_Fns;
+
+typedef struct {
+    const Bs_Table **data;
+    size_t           count;
+    size_t           capacity;
+} Bs_Aot_Tables;
+
+typedef struct {
+    Bs        *bs;
+    Bs_Writer *w;
+    Bs_Sv      source;
+
+    Bs_Aot_Fns    fns;
+    Bs_Aot_Tables tables;
+
+    // Whether each function got translated to C, see bs_aot_native()
+    bool *natives;
+} Bs_Aot;
+
+static size_t bs_aot_fn_index(Bs_Aot *a, const Bs_Fn *fn) {
+    for (size_t i = 0; i < a->fns.count; i++) {
+        if (a->fns.data[i] == fn) {
+            return i;
+        }
+    }
+
+    assert(false && "unreachable");
+    return 0;
+}
+
+static size_t bs_aot_table_index(Bs_Aot *a, const Bs_Table *table) {
+    for (size_t i = 0; i < a->tables.count; i++) {
+        if (a->tables.data[i] == table) {
+            return i;
+        }
+    }
+
+    assert(false && "unreachable");
+    return 0;
+}
+
+// Numbers the functions in the order they are found, and the tables along with them
+static void bs_aot_collect(Bs_Aot *a, const Bs_Fn *fn) {
+    bs_da_push(a->bs, &a->fns, fn);
+
+    for (size_t i = 0; i < fn->chunk.constants.count; i++) {
+        const Bs_Value value = fn->chunk.constants.data[i];
+        if (value.type != BS_VALUE_OBJECT) {
+            continue;
+        }
+
+        if (value.as.object->type == BS_OBJECT_FN) {
+            bs_aot_collect(a, (const Bs_Fn *) value.as.object);
+        } else if (value.as.object->type == BS_OBJECT_TABLE) {
+            bs_da_push(a->bs, &a->tables, (const Bs_Table *) value.as.object);
+        }
+    }
+}
+
+static void bs_aot_str(Bs_Aot *a, Bs_Sv sv) {
+    bs_fmt(a->w, "\"");
+    for (size_t i = 0; i < sv.size; i++) {
+        const unsigned char ch = sv.data[i];
+        if (ch == '\n') {
+            // Keep the embedded source readable
+            bs_fmt(a->w, "\\n\"\n    \"");
+        } else if (ch == '"' || ch == '\\') {
+            bs_fmt(a->w, "\\%c", ch);
+        } else if (ch >= ' ' && ch <= '~' && ch != '?') {
+            bs_fmt(a->w, "%c", ch);
+        } else {
+            // Always three digits, so that a digit right after does not get eaten
+            bs_fmt(a->w, "\\%03o", ch);
+        }
+    }
+    bs_fmt(a->w, "\"");
+}
+
+static void bs_aot_number(Bs_Writer *w, double number) {
+    if (isnan(number)) {
+        bs_fmt(w, "NAN");
+    } else if (isinf(number)) {
+        bs_fmt(w, "%sINFINITY", number < 0 ? "-" : "");
+    } else {
+        bs_fmt(w, "%a", number);
+    }
+}
+
+static_assert(BS_COUNT_OBJECTS == 13, "Update bs_aot_value()");
+static void bs_aot_value(Bs_Aot *a, Bs_Value value) {
+    switch (value.type) {
+    case BS_VALUE_NIL:
+        bs_fmt(a->w, "{BS_AOT_NIL}");
+        break;
+
+    case BS_VALUE_NUM:
+        bs_fmt(a->w, "{BS_AOT_NUM, .number = ");
+        bs_aot_number(a->w, value.as.number);
+        bs_fmt(a->w, "}");
+        break;
+
+    case BS_VALUE_BOOL:
+        bs_fmt(a->w, "{BS_AOT_BOOL, .boolean = %s}", value.as.boolean ? "true" : "false");
+        break;
+
+    case BS_VALUE_OBJECT:
+        switch (value.as.object->type) {
+        case BS_OBJECT_STR: {
+            const Bs_Str *str = (const Bs_Str *) value.as.object;
+            bs_fmt(a->w, "{BS_AOT_STR, .data = ");
+            bs_aot_str(a, Bs_Sv(str->data, str->size));
+            bs_fmt(a->w, ", .size = %zu}", str->size);
+        } break;
+
+        case BS_OBJECT_FN:
+            bs_fmt(
+                a->w,
+                "{BS_AOT_FN, .index = %zu}",
+                bs_aot_fn_index(a, (const Bs_Fn *) value.as.object));
+            break;
+
+        case BS_OBJECT_TABLE:
+            bs_fmt(
+                a->w,
+                "{BS_AOT_TABLE, .index = %zu}",
+                bs_aot_table_index(a, (const Bs_Table *) value.as.object));
+            break;
+
+        default:
+            // The compiler does not produce any other constants
+            assert(false && "unreachable");
+        }
+        break;
+    }
+}
+
+static void bs_aot_fn(Bs_Aot *a, size_t index) {
+    const Bs_Fn    *fn = a->fns.data[index];
+    const Bs_Chunk *c = &fn->chunk;
+
+    bs_fmt(a->w, "static const uint8_t bs_aot_code_%zu[] = {", index);
+    for (size_t i = 0; i < c->count; i++) {
+        bs_fmt(a->w, "%s0x%02x,", i % 16 ? " " : "\n    ", c->data[i]);
+    }
+    bs_fmt(a->w, "\n};\n\n");
+
+    if (c->constants.count) {
+        bs_fmt(a->w, "static const Bs_Aot_Value bs_aot_constants_%zu[] = {\n", index);
+        for (size_t i = 0; i < c->constants.count; i++) {
+            bs_fmt(a->w, "    ");
+            bs_aot_value(a, c->constants.data[i]);
+            bs_fmt(a->w, ",\n");
+        }
+        bs_fmt(a->w, "};\n\n");
+    }
+
+    if (c->locations.count) {
+        bs_fmt(a->w, "static const Bs_Aot_Loc bs_aot_locations_%zu[] = {\n", index);
+        for (size_t i = 0; i < c->locations.count; i++) {
+            const Bs_Op_Loc *l = &c->locations.data[i];
+            bs_fmt(
+                a->w,
+                "    {%zu, %zu, %zu, %zu, %zu},\n",
+                l->index,
+                l->loc.row,
+                l->loc.col,
+                (size_t) (l->loc.line.data - a->source.data),
+                l->loc.line.size);
+        }
+        bs_fmt(a->w, "};\n\n");
+    }
+}
+
+// Gives up on the op at `addr` unless the `count` values on the top are numbers
+static void bs_aot_guard_nums(Bs_Writer *w, size_t addr, size_t count) {
+    bs_fmt(w, "    if (");
+    for (size_t i = count; i > 0; i--) {
+        bs_fmt(w, "%ssp[-%zu].type != BS_VALUE_NUM", i == count ? "" : " || ", i);
+    }
+    bs_fmt(w, ") {\n        *top = sp;\n        return %zu;\n    }\n", addr);
+}
+
+static void bs_aot_arithmetic(Bs_Writer *w, size_t addr, const char *op) {
+    bs_aot_guard_nums(w, addr, 2);
+    bs_fmt(w, "    sp[-2].as.number %s= sp[-1].as.number;\n", op);
+    bs_fmt(w, "    sp--;\n");
+}
+
+// Only numbers, like the templates in jit.c. NaN compares the same in C as in bs_value_equal()
+static void bs_aot_compare(Bs_Writer *w, size_t addr, const char *op) {
+    bs_aot_guard_nums(w, addr, 2);
+    bs_fmt(w, "    sp[-2] = bs_value_bool(sp[-2].as.number %s sp[-1].as.number);\n", op);
+    bs_fmt(w, "    sp--;\n");
+}
+
+// Translates the ops which have a template in jit.c, with the same guards. Returns false for the
+// rest, which are left to the interpreter
+static_assert(BS_COUNT_OPS == 105, "Update bs_aot_op()");
+static bool
+bs_aot_op(Bs_Writer *w, const Bs_Chunk *c, size_t addr, size_t next, bool *labeled) {
+    size_t value = 0;
+    if (next - addr > sizeof(size_t)) {
+        memcpy(&value, &c->data[addr + 1], sizeof(value));
+    }
+
+    switch (bs_op_generic(c->data[addr])) {
+    case BS_OP_DUP:
+        bs_fmt(w, "    sp[0] = sp[-%d];\n", c->data[addr + 1] + 1);
+        bs_fmt(w, "    sp++;\n");
+        break;
+
+    case BS_OP_DROP:
+        bs_fmt(w, "    sp--;\n");
+        break;
+
+    case BS_OP_NIL:
+        bs_fmt(w, "    *sp++ = bs_value_nil;\n");
+        break;
+
+    case BS_OP_TRUE:
+        bs_fmt(w, "    *sp++ = bs_value_bool(true);\n");
+        break;
+
+    case BS_OP_FALSE:
+        bs_fmt(w, "    *sp++ = bs_value_bool(false);\n");
+        break;
+
+    case BS_OP_CONST:
+        if (c->constants.data[value].type == BS_VALUE_NUM) {
+            bs_fmt(w, "    *sp++ = bs_value_num(");
+            bs_aot_number(w, c->constants.data[value].as.number);
+            bs_fmt(w, ");\n");
+        } else {
+            bs_fmt(w, "    *sp++ = constants[%zu];\n", value);
+        }
+        break;
+
+    case BS_OP_ADD:
+        bs_aot_arithmetic(w, addr, "+");
+        break;
+
+    case BS_OP_SUB:
+        bs_aot_arithmetic(w, addr, "-");
+        break;
+
+    case BS_OP_MUL:
+        bs_aot_arithmetic(w, addr, "*");
+        break;
+
+    case BS_OP_DIV:
+        bs_aot_arithmetic(w, addr, "/");
+        break;
+
+    case BS_OP_NEG:
+        bs_aot_guard_nums(w, addr, 1);
+        bs_fmt(w, "    sp[-1].as.number = -sp[-1].as.number;\n");
+        break;
+
+    case BS_OP_LNOT:
+        bs_fmt(w, "    sp[-1] = bs_value_bool(bs_aot_falsey(sp[-1]));\n");
+        break;
+
+    case BS_OP_GT:
+        bs_aot_compare(w, addr, ">");
+        break;
+
+    case BS_OP_GE:
+        bs_aot_compare(w, addr, ">=");
+        break;
+
+    case BS_OP_LT:
+        bs_aot_compare(w, addr, "<");
+        break;
+
+    case BS_OP_LE:
+        bs_aot_compare(w, addr, "<=");
+        break;
+
+    case BS_OP_EQ:
+        bs_aot_compare(w, addr, "==");
+        break;
+
+    case BS_OP_NE:
+        bs_aot_compare(w, addr, "!=");
+        break;
+
+    case BS_OP_LGET:
+        bs_fmt(w, "    *sp++ = base[%zu];\n", value);
+        break;
+
+    case BS_OP_LSET:
+        bs_fmt(w, "    base[%zu] = sp[-1];\n", value);
+        break;
+
+    case BS_OP_JUMP:
+        bs_fmt(w, "    goto op_%zu;\n", next + value);
+        labeled[next + value] = true;
+        break;
+
+    case BS_OP_ELSE:
+        bs_fmt(w, "    if (bs_aot_falsey(sp[-1])) {\n        goto op_%zu;\n    }\n", next + value);
+        labeled[next + value] = true;
+        break;
+
+    case BS_OP_THEN:
+        bs_fmt(w, "    if (!bs_aot_falsey(sp[-1])) {\n        goto op_%zu;\n    }\n", next + value);
+        labeled[next + value] = true;
+        break;
+
+    // Only the ranges with a precomputed count, like in jit.c. The count is on the top, then the
+    // step, the end and the start
+    case BS_OP_RANGE:
+    case BS_OP_IRANGE:
+        bs_aot_guard_nums(w, addr, 1);
+        bs_fmt(w, "    if (sp[-1].as.number-- == 0) {\n        goto op_%zu;\n    }\n", next + value);
+        bs_fmt(w, "    sp[0] = sp[-4];\n");
+        bs_fmt(w, "    sp[-4].as.number += sp[-2].as.number;\n");
+        bs_fmt(w, "    sp++;\n");
+        labeled[next + value] = true;
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+// Writes the C function for a chunk, which can be entered at any op that was translated and
+// returns at the first one which was not
+static bool bs_aot_native(Bs_Aot *a, size_t index) {
+    Bs             *bs = a->bs;
+    const Bs_Chunk *c = &a->fns.data[index]->chunk;
+
+    // The code of each op goes into one buffer first, so that only the ops which get jumped to or
+    // entered at end up with a label
+    Bs_Buffer b = {.bs = bs};
+    Bs_Writer w = bs_buffer_writer(&b);
+
+    size_t *starts = bs_realloc(bs, NULL, 0, (c->count + 1) * sizeof(*starts));
+    bool   *translated = bs_realloc(bs, NULL, 0, c->count * sizeof(*translated));
+    bool   *labeled = bs_realloc(bs, NULL, 0, c->count * sizeof(*labeled));
+    memset(starts, 0xFF, (c->count + 1) * sizeof(*starts));
+    memset(labeled, 0, c->count * sizeof(*labeled));
+
+    bool any = false;
+    for (size_t addr = 0, next; addr < c->count; addr = next) {
+        next = addr + bs_chunk_op_size(c, addr);
+        starts[addr] = b.count;
+        translated[addr] = bs_aot_op(&w, c, addr, next, labeled);
+        any |= translated[addr];
+    }
+    starts[c->count] = b.count;
+
+    if (any) {
+        bs_fmt(
+            a->w,
+            "static size_t bs_aot_native_%zu(\n"
+            "    const Bs_Value *constants, size_t offset, Bs_Value *base, Bs_Value **top) {\n"
+            "    Bs_Value *sp = *top;\n"
+            "    switch (offset) {\n",
+            index);
+
+        for (size_t addr = 0; addr < c->count; addr++) {
+            if (starts[addr] != SIZE_MAX && translated[addr]) {
+                bs_fmt(a->w, "    case %zu:\n        goto op_%zu;\n", addr, addr);
+                labeled[addr] = true;
+            }
+        }
+        bs_fmt(a->w, "    default:\n        return offset;\n    }\n");
+
+        // An op which was not translated is only reachable by falling through or jumping to it
+        bool reachable = false;
+        for (size_t addr = 0; addr < c->count; addr++) {
+            if (starts[addr] == SIZE_MAX) {
+                continue;
+            }
+
+            size_t end = addr + 1;
+            while (starts[end] == SIZE_MAX) {
+                end++;
+            }
+
+            if (labeled[addr]) {
+                bs_fmt(a->w, "\nop_%zu: // %s\n", addr, bs_op_name(bs_op_generic(c->data[addr])));
+            }
+
+            if (translated[addr]) {
+                bs_fmt(a->w, Bs_Sv_Fmt, (int) (starts[end] - starts[addr]), &b.data[starts[addr]]);
+                reachable = true;
+            } else if (reachable || labeled[addr]) {
+                bs_fmt(a->w, "    *top = sp;\n    return %zu;\n", addr);
+                reachable = false;
+            }
+        }
+        bs_fmt(a->w, "}\n\n");
+    }
+
+    bs_realloc(bs, starts, (c->count + 1) * sizeof(*starts), 0);
+    bs_realloc(bs, translated, c->count * sizeof(*translated), 0);
+    bs_realloc(bs, labeled, c->count * sizeof(*labeled), 0);
+    bs_da_free(bs, &b);
+    return any;
+}
+
+static void bs_aot_fn_entry(Bs_Aot *a, size_t index) {
+    const Bs_Fn    *fn = a->fns.data[index];
+    const Bs_Chunk *c = &fn->chunk;
+
+    bs_fmt(a->w, "    {\n");
+    if (fn->name) {
+        bs_fmt(a->w, "        .name = ");
+        bs_aot_str(a, Bs_Sv(fn->name->data, fn->name->size));
+        bs_fmt(a->w, ",\n        .name_size = %zu,\n", fn->name->size);
+    }
+
+    bs_fmt(a->w, "        .arity = %zu,\n", fn->arity);
+    bs_fmt(a->w, "        .variadic = %s,\n", fn->variadic ? "true" : "false");
+    bs_fmt(a->w, "        .variadic_view = %s,\n", fn->variadic_view ? "true" : "false");
+    bs_fmt(a->w, "        .upvalues = %zu,\n", fn->upvalues);
+    bs_fmt(a->w, "        .stack_size = %zu,\n", fn->stack_size);
+    bs_fmt(a->w, "        .code = bs_aot_code_%zu,\n", index);
+    bs_fmt(a->w, "        .code_size = %zu,\n", c->count);
+
+    if (c->constants.count) {
+        bs_fmt(a->w, "        .constants = bs_aot_constants_%zu,\n", index);
+        bs_fmt(a->w, "        .constants_count = %zu,\n", c->constants.count);
+    }
+
+    if (c->locations.count) {
+        bs_fmt(a->w, "        .locations = bs_aot_locations_%zu,\n", index);
+        bs_fmt(a->w, "        .locations_count = %zu,\n", c->locations.count);
+    }
+
+    if (a->natives[index]) {
+        bs_fmt(a->w, "        .native = bs_aot_native_%zu,\n", index);
+    }
+    bs_fmt(a->w, "    },\n");
+}
+
+static void bs_aot_table(Bs_Aot *a, size_t index) {
+    const Bs_Map *map = &a->tables.data[index]->map;
+
+    bs_fmt(a->w, "static const Bs_Aot_Value bs_aot_table_%zu[] = {\n", index);
+    for (size_t i = 0; i < map->capacity; i++) {
+        const Bs_Entry *entry = &map->data[i];
+        if (entry->key.type != BS_VALUE_NIL) {
+            bs_fmt(a->w, "    ");
+            bs_aot_value(a, entry->key);
+            bs_fmt(a->w, ", ");
+            bs_aot_value(a, entry->value);
+            bs_fmt(a->w, ",\n");
+        }
+    }
+    bs_fmt(a->w, "};\n\n");
+}
+
+bool bs_aot_emit(Bs *bs, Bs_Writer *w, Bs_Sv path, Bs_Sv input) {
+    Bs_Buffer   *b = &bs_config(bs)->buffer;
+    const size_t start = b->count;
+
+    bs_buffer_absolute_path(b, path, (Bs_Sv) {0});
+
+    const Bs_Closure *closure =
+        bs_compile_module(bs, bs_buffer_reset(b, start), input, true, false);
+    if (!closure) {
+        return false;
+    }
+
+    Bs_Aot a = {.bs = bs, .w = w, .source = input};
+    bs_aot_collect(&a, closure->fn);
+
+    const Bs_Str *name = closure->fn->name;
+    bs_fmt(w, "// Generated by `bs --emit-c " Bs_Sv_Fmt "`. Build with:\n", Bs_Sv_Arg(path));
+    bs_fmt(w, "//\n");
+    bs_fmt(w, "//   cc -I<bs>/include -o <name> <this file> <bs>/lib/libbs.a -lm\n");
+    bs_fmt(w, "#include <math.h>\n\n");
+    bs_fmt(w, "#include \"bs/aot.h\"\n\n");
+
+    bs_fmt(w, "static const char bs_aot_source[] =\n    ");
+    bs_aot_str(&a, input);
+    bs_fmt(w, ";\n\n");
+
+    a.natives = bs_realloc(bs, NULL, 0, a.fns.count * sizeof(*a.natives));
+    for (size_t i = 0; i < a.fns.count; i++) {
+        bs_aot_fn(&a, i);
+        a.natives[i] = bs_aot_native(&a, i);
+    }
+
+    for (size_t i = 0; i < a.tables.count; i++) {
+        bs_aot_table(&a, i);
+    }
+
+    bs_fmt(w, "static const Bs_Aot_Fn bs_aot_fns[] = {\n");
+    for (size_t i = 0; i < a.fns.count; i++) {
+        bs_aot_fn_entry(&a, i);
+    }
+    bs_fmt(w, "};\n\n");
+
+    if (a.tables.count) {
+        bs_fmt(w, "static const Bs_Aot_Table bs_aot_tables[] = {\n");
+        for (size_t i = 0; i < a.tables.count; i++) {
+            bs_fmt(
+                w,
+                "    {bs_aot_table_%zu, %zu},\n",
+                i,
+                a.tables.data[i]->map.length);
+        }
+        bs_fmt(w, "};\n\n");
+    }
+
+    bs_fmt(w, "static const Bs_Aot_Module bs_aot_module = {\n");
+    bs_fmt(w, "    .path = ");
+    bs_aot_str(&a, Bs_Sv(name->data, name->size));
+    bs_fmt(w, ",\n");
+    bs_fmt(w, "    .source = bs_aot_source,\n");
+    bs_fmt(w, "    .fns = bs_aot_fns,\n");
+    bs_fmt(w, "    .fns_count = %zu,\n", a.fns.count);
+    if (a.tables.count) {
+        bs_fmt(w, "    .tables = bs_aot_tables,\n");
+        bs_fmt(w, "    .tables_count = %zu,\n", a.tables.count);
+    }
+    bs_fmt(w, "};\n\n");
+
+    bs_fmt(w, "int main(int argc, char **argv) {\n");
+    bs_fmt(w, "    return bs_aot_main(&bs_aot_module, argc, argv);\n");
+    bs_fmt(w, "}\n");
+
+    bs_realloc(bs, a.natives, a.fns.count * sizeof(*a.natives), 0);
+    bs_da_free(bs, &a.fns);
+    bs_da_free(bs, &a.tables);
+    return true;
+}
+
+static Bs_Value
+bs_aot_load_value(Bs *bs, const Bs_Aot_Module *m, Bs_Fn **fns, Bs_Table **tables, Bs_Aot_Value v) {
+    switch (v.kind) {
+    case BS_AOT_NIL:
+        return bs_value_nil;
+
+    case BS_AOT_NUM:
+        return bs_value_num(v.number);
+
+    case BS_AOT_BOOL:
+        return bs_value_bool(v.boolean);
+
+    case BS_AOT_STR:
+        return bs_value_object(bs_str_new(bs, Bs_Sv(v.data, v.size)));
+
+    case BS_AOT_FN:
+        assert(v.index < m->fns_count);
+        return bs_value_object(fns[v.index]);
+
+    case BS_AOT_TABLE:
+        assert(v.index < m->tables_count);
+        return bs_value_object(tables[v.index]);
+    }
+
+    assert(false && "unreachable");
+    return bs_value_nil;
+}
+
+// The collector must be off, since nothing here is reachable until the module starts running
+Bs_Fn *bs_aot_load(Bs *bs, const Bs_Aot_Module *m) {
+    Bs_Fn    **fns = bs_realloc(bs, NULL, 0, m->fns_count * sizeof(*fns));
+    Bs_Table **tables = bs_realloc(bs, NULL, 0, m->tables_count * sizeof(*tables));
+
+    for (size_t i = 0; i < m->fns_count; i++) {
+        fns[i] = bs_fn_new(bs);
+    }
+
+    for (size_t i = 0; i < m->tables_count; i++) {
+        tables[i] = bs_table_new(bs);
+    }
+
+    for (size_t i = 0; i < m->tables_count; i++) {
+        const Bs_Aot_Table *t = &m->tables[i];
+        for (size_t j = 0; j < t->count; j++) {
+            bs_map_set(
+                bs,
+                &tables[i]->map,
+                bs_aot_load_value(bs, m, fns, tables, t->entries[2 * j]),
+                bs_aot_load_value(bs, m, fns, tables, t->entries[2 * j + 1]));
+        }
+    }
+
+    const Bs_Sv path = bs_sv_from_cstr(m->path);
+    for (size_t i = 0; i < m->fns_count; i++) {
+        const Bs_Aot_Fn *f = &m->fns[i];
+        Bs_Fn           *fn = fns[i];
+
+        if (f->name) {
+            fn->name = bs_str_new(bs, Bs_Sv(f->name, f->name_size));
+        }
+
+        fn->arity = f->arity;
+        fn->variadic = f->variadic;
+        fn->variadic_view = f->variadic_view;
+        fn->upvalues = f->upvalues;
+        fn->stack_size = f->stack_size;
+
+        Bs_Chunk *c = &fn->chunk;
+        bs_da_push_many(bs, c, f->code, f->code_size);
+
+        for (size_t j = 0; j < f->constants_count; j++) {
+            bs_values_push(
+                bs, &c->constants, bs_aot_load_value(bs, m, fns, tables, f->constants[j]));
+        }
+
+        for (size_t j = 0; j < f->locations_count; j++) {
+            const Bs_Aot_Loc *l = &f->locations[j];
+            const Bs_Op_Loc   loc = {
+                  .loc =
+                    {
+                        .path = path,
+                        .line = Bs_Sv(m->source + l->line, l->line_size),
+                        .row = l->row,
+                        .col = l->col,
+                    },
+                  .index = l->index,
+            };
+            bs_op_locs_push(bs, &c->locations, loc);
+        }
+
+        if (f->native) {
+            fn->jit = bs_jit_native(bs, f->native, c->constants.data);
+        }
+    }
+
+    Bs_Fn *fn = fns[0];
+    bs_realloc(bs, fns, m->fns_count * sizeof(*fns), 0);
+    bs_realloc(bs, tables, m->tables_count * sizeof(*tables), 0);
+    return fn;
+}
+
+int bs_aot_main(const Bs_Aot_Module *m, int argc, char **argv) {
+    Bs *bs = bs_new(argc, argv);
+
+    const Bs_Result result = bs_run_fn(bs, bs_sv_from_cstr(m->path), bs_aot_load(bs, m));
+    bs_free(bs);
+    return result.exit == -1 ? !result.ok : result.exit;
+}
@@ -2,6 +2,10 @@
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef __SSE2__
+#    include <emmintrin.h>
+#endif // __SSE2__
+
 #include "bs/basic.h"
 
 Bs_Sv bs_sv_from_cstr(const char *data) {
@@ -59,6 +63,77 @@ bool bs_sv_find(Bs_Sv s, char ch, size_t *index) {
     return true;
 }
 
+// Substring search
+//
+// Candidates are the positions where both the first and the last byte of the pattern match, which
+// rules out nearly every false start before the rest of the pattern is compared. With SSE2 the
+// candidates of 16 positions are found at once, everywhere else memchr() finds the first byte
+
+static const char *bs_sv_find_pair(Bs_Sv s, Bs_Sv pattern) {
+    const size_t m = pattern.size;
+    const char   first = pattern.data[0];
+    const char   last = pattern.data[m - 1];
+
+    const char *p = s.data;
+    const char *end = s.data + s.size - m + 1; // Past the last position the pattern fits at
+
+#ifdef __SSE2__
+    const __m128i firsts = _mm_set1_epi8(first);
+    const __m128i lasts = _mm_set1_epi8(last);
+    for (; end - p >= 16; p += 16) {
+        const __m128i a = _mm_loadu_si128((const __m128i *) p);
+        const __m128i b = _mm_loadu_si128((const __m128i *) (p + m - 1));
+
+        unsigned mask =
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, firsts), _mm_cmpeq_epi8(b, lasts)));
+
+        while (mask) {
+            const unsigned bit = __builtin_ctz(mask);
+            if (!memcmp(p + bit + 1, pattern.data + 1, m - 2)) {
+                return p + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif // __SSE2__
+
+    while (p < end) {
+        p = memchr(p, first, end - p);
+        if (!p) {
+            return NULL;
+        }
+
+        if (p[m - 1] == last && !memcmp(p + 1, pattern.data + 1, m - 2)) {
+            return p;
+        }
+        p++;
+    }
+
+    return NULL;
+}
+
+bool bs_sv_find_sv(Bs_Sv s, Bs_Sv pattern, size_t *index) {
+    if (pattern.size > s.size) {
+        return false;
+    }
+
+    const char *p = s.data;
+    if (pattern.size == 1) {
+        p = memchr(s.data, *pattern.data, s.size);
+    } else if (pattern.size > 1) {
+        p = bs_sv_find_pair(s, pattern);
+    }
+
+    if (!p) {
+        return false;
+    }
+
+    if (index) {
+        *index = p - s.data;
+    }
+    return true;
+}
+
 bool bs_sv_prefix(Bs_Sv a, Bs_Sv b) {
     return a.size >= b.size && !memcmp(a.data, b.data, b.size);
 }
@@ -130,11 +130,41 @@ typedef struct {
 #define bs_jumps_free bs_da_free
 #define bs_jumps_push bs_da_push
 
+typedef struct {
+    size_t constant;
+    size_t body;
+} Bs_Match_Case;
+
+typedef struct {
+    Bs_Match_Case *data;
+    size_t         count;
+    size_t         capacity;
+} Bs_Match_Cases;
+
+#define bs_match_cases_free bs_da_free
+
+typedef struct {
+    size_t *data;
+    size_t  count;
+    size_t  capacity;
+} Bs_Depths;
+
+#define bs_depths_free bs_da_free
+#define bs_depths_push bs_da_push
+#define bs_match_cases_push bs_da_push
+
 typedef struct {
     Bs_Sv  name;
     size_t depth;
+    bool   used;
     bool   captured;
     bool   constant;
+
+    // Whether the local is ever assigned after its definition, which decides how it is captured
+    bool assigned;
+
+    // A local function can refer to itself before its closure exists
+    bool defining;
 } Bs_Local;
 
 typedef struct {
@@ -152,6 +182,22 @@ typedef struct {
 #define bs_uplocals_free bs_da_free
 #define bs_uplocals_push bs_da_push
 
+// A capture of a local, which is copied rather than shared if the local turns out to never be
+// assigned by the time it goes out of scope. The offset is that of the capture kind in the chunk
+typedef struct {
+    size_t local;
+    size_t offset;
+} Bs_Capture_Site;
+
+typedef struct {
+    Bs_Capture_Site *data;
+    size_t           count;
+    size_t           capacity;
+} Bs_Capture_Sites;
+
+#define bs_capture_sites_free bs_da_free
+#define bs_capture_sites_push bs_da_push
+
 typedef struct Bs_Class_Compiler Bs_Class_Compiler;
 
 struct Bs_Class_Compiler {
@@ -177,8 +223,9 @@ struct Bs_Lambda {
     size_t    depth;
     size_t    capacity;
 
-    Bs_Fn      *fn;
-    Bs_Uplocals uplocals;
+    Bs_Fn           *fn;
+    Bs_Uplocals      uplocals;
+    Bs_Capture_Sites captures;
 
     bool is_repl;
     bool is_meta;
@@ -191,6 +238,7 @@ struct Bs_Lambda {
 static void bs_lambda_free(Bs *bs, Bs_Lambda *l) {
     if (l) {
         bs_uplocals_free(bs, &l->uplocals);
+        bs_capture_sites_free(bs, &l->captures);
         bs_da_free(bs, l);
         free(l);
     }
@@ -208,6 +256,7 @@ static Bs_Lambda *bs_lambda_new(Bs_Lambda_Type type, bool is_repl, bool is_meta)
 static bool bs_lambda_find_local(Bs_Lambda *l, Bs_Sv name, size_t *index) {
     for (size_t i = l->count; i > 0; i--) {
         if (bs_sv_eq(l->data[i - 1].name, name)) {
+            l->data[i - 1].used = true;
             *index = i - 1;
             return true;
         }
@@ -235,6 +284,16 @@ static void bs_lambda_add_upvalue(Bs *bs, Bs_Lambda *l, size_t *index, bool loca
     *index = l->fn->upvalues++;
 }
 
+// The local which an upvalue refers to, however many functions up it is
+static Bs_Local *bs_lambda_upvalue_local(Bs_Lambda *l, size_t index) {
+    while (!l->uplocals.data[index].local) {
+        index = l->uplocals.data[index].index;
+        l = l->outer;
+    }
+
+    return &l->outer->data[l->uplocals.data[index].index];
+}
+
 static bool bs_lambda_find_upvalue(Bs *bs, Bs_Lambda *l, Bs_Sv name, size_t *index) {
     if (!l->outer) {
         return false;
@@ -268,6 +327,14 @@ typedef struct {
     Bs_Jumps   matches;
     Bs_Op_Locs locations;
 
+    // Constant cases of the match statements being compiled
+    Bs_Match_Cases cases;
+
+    // Scratch space for computing the stack size of a function
+    Bs_Depths depths;
+    Bs_Depths bases;
+    Bs_Depths pending;
+
     size_t module;
 
     bool is_main;
@@ -292,6 +359,14 @@ static void bs_compile_jump_direct(Bs_Compiler *c, Bs_Op op, size_t addr) {
     bs_chunk_push_op_int(c->bs, c->chunk, op, addr - c->chunk->count - 1 - sizeof(size_t));
 }
 
+// Called right before returning the value of the expression that was just compiled. If that was
+// a call then it is in tail position, regardless of any jumps which skip past it
+static void bs_compile_tail_call(Bs_Compiler *c) {
+    if (c->chunk->data[c->chunk->last] == BS_OP_CALL) {
+        c->chunk->data[c->chunk->last] = BS_OP_TAIL_CALL;
+    }
+}
+
 static void bs_compile_error_unexpected(Bs_Compiler *c, const Bs_Token *token) {
     bs_lexer_error(&c->lexer, token->loc, "unexpected %s", bs_token_type_name(token->type));
 }
@@ -412,10 +487,12 @@ static void bs_compile_assignment(Bs_Compiler *c, const Bs_Token *token, Bs_Op a
             if (c->lambda->data[index].constant) {
                 bs_lexer_error(&c->lexer, locs[0], "cannot assign to constant");
             }
+            c->lambda->data[index].assigned = true;
         } else if (assign_op == BS_OP_USET) {
             if (c->lambda->uplocals.data[index].constant) {
                 bs_lexer_error(&c->lexer, locs[0], "cannot assign to constant");
             }
+            bs_lambda_upvalue_local(c->lambda, index)->assigned = true;
         }
     }
 
@@ -1176,8 +1253,28 @@ static size_t bs_compile_block_drop(Bs_Compiler *c, size_t depth) {
     return lambda_count;
 }
 
+// Copies the captures of the locals after the first `count` which were never assigned, now that
+// they are going out of scope
+static void bs_compile_captures_end(Bs_Compiler *c, size_t count) {
+    Bs_Capture_Sites *sites = &c->lambda->captures;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < sites->count; i++) {
+        const Bs_Capture_Site site = sites->data[i];
+        if (site.local < count) {
+            sites->data[kept++] = site;
+        } else if (!c->lambda->data[site.local].assigned) {
+            c->chunk->data[site.offset] = BS_CAPTURE_VALUE;
+        }
+    }
+
+    sites->count = kept;
+}
+
 static void bs_compile_block_end(Bs_Compiler *c) {
-    c->lambda->count = bs_compile_block_drop(c, --c->lambda->depth);
+    const size_t count = bs_compile_block_drop(c, --c->lambda->depth);
+    bs_compile_captures_end(c, count);
+    c->lambda->count = count;
 }
 
 static void bs_compile_lambda_init(Bs_Compiler *c, Bs_Lambda *lambda, Bs_Sv name) {
@@ -1199,6 +1296,348 @@ static void bs_compile_lambda_init(Bs_Compiler *c, Bs_Lambda *lambda, Bs_Sv name
     }
 }
 
+static bool bs_compile_match_op(const Bs_Chunk *c, size_t *offset, Bs_Op op, size_t *operand) {
+    if (*offset >= c->count || c->data[*offset] != op) {
+        return false;
+    }
+
+    if (operand) {
+        *operand = *(const size_t *) &c->data[*offset + 1];
+    }
+
+    *offset += bs_chunk_op_size(c, *offset);
+    return true;
+}
+
+static bool bs_compile_match_num(const Bs_Chunk *c, size_t *offset) {
+    size_t constant;
+    return bs_compile_match_op(c, offset, BS_OP_CONST, &constant) &&
+           c->constants.data[constant].type == BS_VALUE_NUM;
+}
+
+// The binary operators which have register forms
+static bool bs_compile_match_binary(const Bs_Chunk *c, size_t *offset) {
+    if (*offset >= c->count) {
+        return false;
+    }
+
+    switch (c->data[*offset]) {
+    case BS_OP_ADD:
+    case BS_OP_SUB:
+    case BS_OP_MUL:
+    case BS_OP_DIV:
+    case BS_OP_MOD:
+    case BS_OP_GT:
+    case BS_OP_GE:
+    case BS_OP_LT:
+    case BS_OP_LE:
+    case BS_OP_EQ:
+    case BS_OP_NE:
+        *offset += 1;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+// LSET c; DROP
+static bool bs_compile_match_store(const Bs_Chunk *c, size_t *offset) {
+    return bs_compile_match_op(c, offset, BS_OP_LSET, NULL) &&
+           bs_compile_match_op(c, offset, BS_OP_DROP, NULL);
+}
+
+// Superinstructions
+//
+// Done once the function is complete, since the compiler still rewrites the last op of an
+// expression while compiling (assignments, calls, delete). Only the opcode of the first op in a
+// matching sequence is replaced, hence no jump offsets or locations need to be relocated
+static Bs_Op bs_compile_superinstruction(const Bs_Chunk *c, size_t offset) {
+    // CONST k; LSET c; DROP
+    size_t end = offset;
+    if (bs_compile_match_op(c, &end, BS_OP_CONST, NULL) && bs_compile_match_store(c, &end)) {
+        return BS_OP_REG_LOAD;
+    }
+
+    size_t slot;
+    if (!bs_compile_match_op(c, &offset, BS_OP_LGET, &slot)) {
+        return BS_OP_RET;
+    }
+
+    // LGET a; CONST n; ADD; LSET a; DROP
+    size_t other;
+    end = offset;
+    if (bs_compile_match_num(c, &end) && bs_compile_match_op(c, &end, BS_OP_ADD, NULL) &&
+        bs_compile_match_op(c, &end, BS_OP_LSET, &other) && other == slot &&
+        bs_compile_match_op(c, &end, BS_OP_DROP, NULL)) {
+        return BS_OP_INCR_LOCAL;
+    }
+
+    // LGET a; CONST n; LT; ELSE
+    end = offset;
+    if (bs_compile_match_num(c, &end) && bs_compile_match_op(c, &end, BS_OP_LT, NULL) &&
+        bs_compile_match_op(c, &end, BS_OP_ELSE, NULL)) {
+        return BS_OP_LGET_CONST_LT_ELSE;
+    }
+
+    // LGET a; LGET|CONST b; <binary>; ...
+    end = offset;
+    if ((bs_compile_match_op(c, &end, BS_OP_LGET, NULL) ||
+         bs_compile_match_op(c, &end, BS_OP_CONST, NULL)) &&
+        bs_compile_match_binary(c, &end)) {
+        size_t rest = end;
+        if (bs_compile_match_store(c, &rest)) {
+            return BS_OP_REG_BINARY_SET;
+        }
+
+        rest = end;
+        if (bs_compile_match_op(c, &rest, BS_OP_ELSE, NULL) &&
+            bs_compile_match_op(c, &rest, BS_OP_DROP, NULL)) {
+            return BS_OP_REG_BINARY_ELSE;
+        }
+    }
+
+    // LGET a; LGET b; ADD
+    end = offset;
+    if (bs_compile_match_op(c, &end, BS_OP_LGET, NULL) &&
+        bs_compile_match_op(c, &end, BS_OP_ADD, NULL)) {
+        return BS_OP_LGET_LGET_ADD;
+    }
+
+    // LGET a; IGET_CONST k
+    end = offset;
+    if (bs_compile_match_op(c, &end, BS_OP_IGET_CONST, NULL)) {
+        return BS_OP_LGET_IGET_CONST;
+    }
+
+    // LGET a; LGET|CONST b; <binary>
+    end = offset;
+    if ((bs_compile_match_op(c, &end, BS_OP_LGET, NULL) ||
+         bs_compile_match_op(c, &end, BS_OP_CONST, NULL)) &&
+        bs_compile_match_binary(c, &end)) {
+        return BS_OP_REG_BINARY;
+    }
+
+    // LGET b; <binary>; ...
+    end = offset;
+    if (bs_compile_match_binary(c, &end)) {
+        return bs_compile_match_store(c, &end) ? BS_OP_REG_TOP_SET : BS_OP_REG_TOP;
+    }
+
+    // LGET a; LSET c; DROP
+    end = offset;
+    if (bs_compile_match_store(c, &end)) {
+        return BS_OP_REG_MOVE;
+    }
+
+    return BS_OP_RET;
+}
+
+static void bs_compile_superinstructions(Bs_Chunk *c) {
+    for (size_t offset = 0; offset < c->count; offset += bs_chunk_op_size(c, offset)) {
+        const Bs_Op op = bs_compile_superinstruction(c, offset);
+        if (op != BS_OP_RET) {
+            c->data[offset] = op;
+        }
+    }
+}
+
+// Stack size
+//
+// Once a function is complete, every path through it is walked to find the most stack slots it can
+// use, counting from its frame base. The interpreter reserves that much when the function is called
+// and pushes without any further checks. A call leaves the stack at the depth its CALL_INIT saw, and
+// since calls are never split across jumps, they are paired with those in order of appearance
+static void bs_compile_stack_visit(Bs_Compiler *c, size_t addr, size_t depth) {
+    if (c->depths.data[addr] == SIZE_MAX || c->depths.data[addr] < depth) {
+        c->depths.data[addr] = depth;
+        bs_depths_push(c->bs, &c->pending, addr);
+    }
+}
+
+static void bs_compile_stack_visit_table(Bs_Compiler *c, size_t base, Bs_Value table, size_t depth) {
+    if (table.as.object->type == BS_OBJECT_ARRAY) {
+        const Bs_Array *array = (const Bs_Array *) table.as.object;
+        for (size_t i = 0; i < array->count; i++) {
+            if (array->data[i].type == BS_VALUE_NUM) {
+                bs_compile_stack_visit(c, base + (size_t) array->data[i].as.number, depth);
+            }
+        }
+    } else {
+        const Bs_Map *map = &((const Bs_Table *) table.as.object)->map;
+        for (size_t i = 0; i < map->capacity; i++) {
+            if (map->data[i].key.type != BS_VALUE_NIL) {
+                bs_compile_stack_visit(c, base + (size_t) map->data[i].value.as.number, depth);
+            }
+        }
+    }
+}
+
+static_assert(BS_COUNT_OPS == 105, "Update bs_compile_stack_size()");
+static size_t bs_compile_stack_size(Bs_Compiler *c, const Bs_Chunk *chunk, size_t arity) {
+    c->depths.count = 0;
+    c->bases.count = 0;
+    c->pending.count = 0;
+    for (size_t i = 0; i < chunk->count; i++) {
+        bs_depths_push(c->bs, &c->depths, SIZE_MAX);
+        bs_depths_push(c->bs, &c->bases, SIZE_MAX);
+    }
+
+    // Pair every call with its CALL_INIT
+    for (size_t addr = 0; addr < chunk->count; addr += bs_chunk_op_size(chunk, addr)) {
+        switch (bs_op_generic(chunk->data[addr])) {
+        case BS_OP_CALL_INIT:
+            bs_depths_push(c->bs, &c->pending, addr);
+            break;
+
+        case BS_OP_CALL:
+        case BS_OP_TAIL_CALL:
+        case BS_OP_INVOKE:
+        case BS_OP_SUPER_INVOKE:
+            assert(c->pending.count);
+            c->bases.data[addr] = c->pending.data[--c->pending.count];
+            break;
+
+        default:
+            break;
+        }
+    }
+    assert(!c->pending.count);
+
+    // The receiver, followed by the arguments
+    size_t max = arity + 1;
+    bs_compile_stack_visit(c, 0, max);
+
+    while (c->pending.count) {
+        const size_t addr = c->pending.data[--c->pending.count];
+        const size_t depth = c->depths.data[addr];
+        const size_t next = addr + bs_chunk_op_size(chunk, addr);
+        const size_t operand =
+            next == addr + 1 + sizeof(size_t) ? *(const size_t *) &chunk->data[addr + 1] : 0;
+
+        // The depth the op leaves the stack at, and the most it pushes on the way
+        size_t after = depth;
+        size_t peak = depth;
+
+        switch (bs_op_generic(chunk->data[addr])) {
+        case BS_OP_RET:
+            peak = depth + 1; // Deferred calls
+            break;
+
+        case BS_OP_CALL:
+        case BS_OP_TAIL_CALL:
+        case BS_OP_INVOKE:
+        case BS_OP_SUPER_INVOKE:
+            after = c->depths.data[c->bases.data[addr]];
+            break;
+
+        case BS_OP_CALL_INIT:
+        case BS_OP_DEFER_INVOKE:
+        case BS_OP_GSET:
+        case BS_OP_LSET:
+        case BS_OP_USET:
+        case BS_OP_NEG:
+        case BS_OP_BNOT:
+        case BS_OP_LNOT:
+        case BS_OP_LEN:
+        case BS_OP_TOSTR:
+        case BS_OP_TYPEOF:
+        case BS_OP_CLASSOF:
+        case BS_OP_IMPORT:
+        case BS_OP_DELETE_CONST:
+        case BS_OP_IGET_CONST:
+        case BS_OP_JUMP:
+        case BS_OP_ELSE:
+        case BS_OP_THEN:
+        case BS_OP_MATCH_TABLE:
+        case BS_OP_ITER:
+        case BS_OP_RANGE:
+        case BS_OP_IRANGE:
+            break;
+
+        case BS_OP_DUP:
+        case BS_OP_CLOSURE:
+        case BS_OP_NIL:
+        case BS_OP_TRUE:
+        case BS_OP_FALSE:
+        case BS_OP_ARRAY:
+        case BS_OP_TABLE:
+        case BS_OP_CONST:
+        case BS_OP_CLASS:
+        case BS_OP_GGET:
+        case BS_OP_LGET:
+        case BS_OP_UGET:
+        case BS_OP_LRECEIVER:
+        case BS_OP_URECEIVER:
+        case BS_OP_RANGE_INIT:
+            after = peak = depth + 1;
+            break;
+
+        case BS_OP_ISET:
+        case BS_OP_ISET_CHAIN:
+            after = depth - 2;
+            break;
+
+        default:
+            // Everything else pops a single value, including binary ops which push their result
+            // right back, and SPREAD, which reserves the space for its values by itself
+            after = depth - 1;
+            break;
+        }
+
+        if (peak > max) {
+            max = peak;
+        }
+
+        switch (bs_op_generic(chunk->data[addr])) {
+        case BS_OP_RET:
+            break;
+
+        case BS_OP_JUMP:
+            bs_compile_stack_visit(c, next + operand, after);
+            break;
+
+        case BS_OP_ELSE:
+        case BS_OP_THEN:
+        case BS_OP_MATCH:
+        case BS_OP_MATCH_IF:
+            bs_compile_stack_visit(c, next + operand, after);
+            bs_compile_stack_visit(c, next, after);
+            break;
+
+        case BS_OP_MATCH_TABLE:
+            bs_compile_stack_visit_table(c, next, chunk->constants.data[operand], after);
+            bs_compile_stack_visit(c, next, after);
+            break;
+
+        case BS_OP_ITER: {
+            // The offset comes after the bindings byte
+            const size_t offset = *(const size_t *) &chunk->data[addr + 2];
+            bs_compile_stack_visit(c, next + offset, after);
+            bs_compile_stack_visit(c, next, after + 2);
+            if (after + 2 > max) {
+                max = after + 2;
+            }
+        } break;
+
+        case BS_OP_RANGE:
+        case BS_OP_IRANGE:
+            bs_compile_stack_visit(c, next + operand, after);
+            bs_compile_stack_visit(c, next, after + 1);
+            if (after + 1 > max) {
+                max = after + 1;
+            }
+            break;
+
+        default:
+            bs_compile_stack_visit(c, next, after);
+            break;
+        }
+    }
+
+    return max;
+}
+
 static Bs_Fn *bs_compile_lambda_end(Bs_Compiler *c) {
     if (c->lambda->type == BS_LAMBDA_INIT) {
         bs_chunk_push_op_int(c->bs, c->chunk, BS_OP_LRECEIVER, 0);
@@ -1206,7 +1645,11 @@ static Bs_Fn *bs_compile_lambda_end(Bs_Compiler *c) {
         bs_chunk_push_op(c->bs, c->chunk, BS_OP_NIL);
     }
     bs_chunk_push_op(c->bs, c->chunk, BS_OP_RET);
+    bs_compile_captures_end(c, 0);
+
     Bs_Fn *fn = c->lambda->fn;
+    fn->stack_size = bs_compile_stack_size(c, c->chunk, fn->arity);
+    bs_compile_superinstructions(c->chunk);
 
     Bs_Lambda *outer = c->lambda->outer;
     c->lambda = outer;
@@ -1220,20 +1663,102 @@ static Bs_Fn *bs_compile_lambda_end(Bs_Compiler *c) {
     return fn;
 }
 
+// Variadic arguments
+//
+// The variadic arguments of a function are only collected into a new array if that array could
+// outlive the call. When the parameter is only ever read from in place, the interpreter passes a
+// view of the arguments on the stack instead. Read in place means one of:
+//
+//   len(args)                      LGET; LEN
+//   ..args                         LGET; SPREAD
+//   for x in args                  LGET; CONST; ITER
+//   args[i], args[0]               LGET; LGET | CONST; IGET
+static bool bs_compile_variadic_view(const Bs_Fn *fn) {
+    const Bs_Chunk *c = &fn->chunk;
+    const size_t    slot = fn->arity;
+
+    for (size_t addr = 0; addr < c->count; addr += bs_chunk_op_size(c, addr)) {
+        const Bs_Op op = bs_op_generic(c->data[addr]);
+
+        if (op == BS_OP_CLOSURE) {
+            const size_t constant = *(const size_t *) &c->data[addr + 1];
+            const Bs_Fn *inner = (const Bs_Fn *) c->constants.data[constant].as.object;
+
+            const uint8_t *upvalue = &c->data[addr + 1 + sizeof(size_t)];
+            for (size_t i = 0; i < inner->upvalues; i++, upvalue += 1 + sizeof(size_t)) {
+                if (upvalue[0] != BS_CAPTURE_UPVALUE && *(const size_t *) &upvalue[1] == slot) {
+                    return false;
+                }
+            }
+            continue;
+        }
+
+        if (op != BS_OP_LGET && op != BS_OP_LSET) {
+            continue;
+        }
+
+        if (*(const size_t *) &c->data[addr + 1] != slot) {
+            continue;
+        }
+
+        if (op == BS_OP_LSET) {
+            return false;
+        }
+
+        size_t next = addr + bs_chunk_op_size(c, addr);
+        if (next >= c->count) {
+            return false;
+        }
+
+        switch (bs_op_generic(c->data[next])) {
+        case BS_OP_LEN:
+        case BS_OP_SPREAD:
+            break;
+
+        case BS_OP_CONST:
+        case BS_OP_LGET: {
+            next += bs_chunk_op_size(c, next);
+            const Bs_Op after = next < c->count ? bs_op_generic(c->data[next]) : BS_OP_RET;
+            if (after != BS_OP_IGET && after != BS_OP_ITER) {
+                return false;
+            }
+        } break;
+
+        default:
+            return false;
+        }
+    }
+
+    return true;
+}
+
 static void bs_compile_lambda_end_ops(Bs_Compiler *c, Bs_Lambda *lambda, bool variadic) {
     Bs_Fn *fn = bs_compile_lambda_end(c);
     fn->variadic = variadic;
+    fn->variadic_view = variadic && bs_compile_variadic_view(fn);
 
     bs_chunk_push_op_value(c->bs, c->chunk, BS_OP_CLOSURE, bs_value_object(fn));
+    const size_t closure_addr = c->chunk->last;
 
     for (size_t i = 0; i < lambda->fn->upvalues; i++) {
+        const Bs_Uplocal *uplocal = &lambda->uplocals.data[i];
+        if (uplocal->local && !c->lambda->data[uplocal->index].defining) {
+            bs_capture_sites_push(
+                c->bs,
+                &c->lambda->captures,
+                ((Bs_Capture_Site) {.local = uplocal->index, .offset = c->chunk->count}));
+        }
+
         bs_chunk_push_op_int(
             c->bs,
             c->chunk,
-            lambda->uplocals.data[i].local ? 1 : 0,
-            lambda->uplocals.data[i].index);
+            (Bs_Op) (uplocal->local ? BS_CAPTURE_LOCAL : BS_CAPTURE_UPVALUE),
+            uplocal->index);
     }
 
+    // The upvalue descriptors are not ops
+    c->chunk->last = closure_addr;
+
     bs_lambda_free(c->bs, lambda);
 }
 
@@ -1297,6 +1822,7 @@ static void bs_compile_lambda(Bs_Compiler *c, Bs_Lambda_Type type, const Bs_Toke
     } else {
         bs_lexer_unbuffer(&c->lexer);
         bs_compile_expr(c, BS_POWER_SET);
+        bs_compile_tail_call(c);
         bs_chunk_push_op(c->bs, c->chunk, BS_OP_RET);
     }
 
@@ -1410,8 +1936,16 @@ static void bs_compile_function(Bs_Compiler *c, bool public) {
         }
     }
 
+    if (!public && !field) {
+        c->lambda->data[c->lambda->count - 1].defining = true;
+    }
+
     bs_compile_lambda(c, BS_LAMBDA_FN, &token);
 
+    if (!public && !field) {
+        c->lambda->data[c->lambda->count - 1].defining = false;
+    }
+
     if (public) {
         bs_chunk_push_op_int(c->bs, c->chunk, BS_OP_GCONST, const_index);
         bs_chunk_push_op_loc(c->bs, c->chunk, token.loc);
@@ -1468,6 +2002,151 @@ static void bs_compile_jumps_reset(Bs_Compiler *c, Bs_Jumps save) {
     c->jumps.start = save.start;
 }
 
+// Match tables
+//
+// A match whose cases are all number or string constants dispatches with a single lookup instead
+// of trying every case in order. Since that is only known once the whole match has been compiled,
+// the first case (CONST; MATCH) is overwritten with a MATCH_TABLE followed by a JUMP to the default
+// branch. The table maps each case to the offset of its body, and is either an array indexed by
+// the case itself (for small non-negative integers), or a table
+#define BS_MATCH_TABLE_MIN 4
+
+static bool bs_compile_match_constant(Bs_Compiler *c, size_t addr, size_t *constant) {
+    if (c->chunk->count != addr + 1 + sizeof(size_t) || c->chunk->data[addr] != BS_OP_CONST) {
+        return false;
+    }
+
+    *constant = *(const size_t *) &c->chunk->data[addr + 1];
+
+    const Bs_Value value = c->chunk->constants.data[*constant];
+    return value.type == BS_VALUE_NUM ||
+           (value.type == BS_VALUE_OBJECT && value.as.object->type == BS_OBJECT_STR);
+}
+
+static void bs_compile_match_table(Bs_Compiler *c, size_t match_addr, size_t start) {
+    const Bs_Match_Case *cases = &c->cases.data[start];
+    const size_t         count = c->cases.count - start;
+    if (count < BS_MATCH_TABLE_MIN) {
+        return;
+    }
+
+    // Offsets are relative to the end of MATCH_TABLE
+    const size_t base = match_addr + 1 + sizeof(size_t);
+
+    bool dense = true;
+    for (size_t i = 0; i < count && dense; i++) {
+        const Bs_Value value = c->chunk->constants.data[cases[i].constant];
+        dense = value.type == BS_VALUE_NUM && value.as.number >= 0 &&
+                value.as.number < count * 4 && value.as.number == (size_t) value.as.number;
+    }
+
+    Bs_Value table;
+    if (dense) {
+        Bs_Array *array = bs_array_new(c->bs);
+        for (size_t i = 0; i < count; i++) {
+            const size_t index = c->chunk->constants.data[cases[i].constant].as.number;
+
+            // Earlier cases take priority, just like they would in the MATCH chain
+            Bs_Value existing;
+            if (!bs_array_get(c->bs, array, index, &existing) || existing.type == BS_VALUE_NIL) {
+                bs_array_set(c->bs, array, index, bs_value_num(cases[i].body - base));
+            }
+        }
+        table = bs_value_object(array);
+    } else {
+        Bs_Table *map = bs_table_new(c->bs);
+        for (size_t i = 0; i < count; i++) {
+            Bs_Value key = c->chunk->constants.data[cases[i].constant];
+            if (key.type == BS_VALUE_NUM && key.as.number == 0) {
+                key = bs_value_num(0); // Negative zero matches zero
+            }
+
+            Bs_Value existing;
+            if (!bs_map_get(c->bs, &map->map, key, &existing)) {
+                bs_map_set(c->bs, &map->map, key, bs_value_num(cases[i].body - base));
+            }
+        }
+        table = bs_value_object(map);
+    }
+
+    bs_values_push(c->bs, &c->chunk->constants, table);
+    const size_t constant = c->chunk->constants.count - 1;
+
+    // The default branch is the DROP right after the cases
+    const size_t jump = c->chunk->count - (base + 1 + sizeof(size_t));
+
+    c->chunk->data[match_addr] = BS_OP_MATCH_TABLE;
+    memcpy(&c->chunk->data[match_addr + 1], &constant, sizeof(constant));
+
+    c->chunk->data[base] = BS_OP_JUMP;
+    memcpy(&c->chunk->data[base + 1], &jump, sizeof(jump));
+}
+
+// Deferred method calls
+//
+// A defer of a method call on a local without arguments, like `defer file.close()`, is the most
+// common kind by far. Rather than creating a closure for it, the method name is kept around along
+// with the local, which is captured exactly like the closure would have: shared through an upvalue
+// if it gets assigned later, copied otherwise. The local may well be out of scope by the time the
+// function returns. The closure which was just compiled for it is thrown away if it has the exact
+// shape of:
+//
+//   UGET 0; CALL_INIT; INVOKE name; DROP; NIL; RET
+static bool bs_compile_defer_invoke(Bs_Compiler *c) {
+    const size_t closure_addr = c->chunk->last;
+    assert(c->chunk->data[closure_addr] == BS_OP_CLOSURE);
+
+    const size_t constant = *(const size_t *) &c->chunk->data[closure_addr + 1];
+    const Bs_Fn *fn = (const Bs_Fn *) c->chunk->constants.data[constant].as.object;
+    const Bs_Capture capture = c->chunk->data[closure_addr + 1 + sizeof(size_t)];
+    if (fn->upvalues != 1 || capture == BS_CAPTURE_UPVALUE) {
+        return false;
+    }
+
+    const Bs_Chunk *inner = &fn->chunk;
+
+    size_t offset = 0, upvalue, name, invoke_end;
+    if (!bs_compile_match_op(inner, &offset, BS_OP_UGET, &upvalue) || upvalue ||
+        !bs_compile_match_op(inner, &offset, BS_OP_CALL_INIT, NULL) ||
+        !bs_compile_match_op(inner, &offset, BS_OP_INVOKE, &name)) {
+        return false;
+    }
+
+    invoke_end = offset;
+    if (!bs_compile_match_op(inner, &offset, BS_OP_DROP, NULL) ||
+        !bs_compile_match_op(inner, &offset, BS_OP_NIL, NULL) ||
+        !bs_compile_match_op(inner, &offset, BS_OP_RET, NULL) || offset != inner->count) {
+        return false;
+    }
+
+    const size_t slot = *(const size_t *) &c->chunk->data[closure_addr + 2 + sizeof(size_t)];
+    const Bs_Value method = inner->constants.data[name];
+
+    // Forget the closure and its function
+    c->chunk->count = closure_addr;
+    c->chunk->constants.count--;
+
+    bs_chunk_push_op_value(c->bs, c->chunk, BS_OP_DEFER_INVOKE, method);
+
+    // The capture kind is still decided once the local goes out of scope
+    if (c->lambda->captures.count &&
+        c->lambda->captures.data[c->lambda->captures.count - 1].offset > closure_addr) {
+        c->lambda->captures.data[c->lambda->captures.count - 1].offset = c->chunk->count;
+    }
+
+    bs_da_push(c->bs, c->chunk, (uint8_t) capture);
+    bs_da_push_many(c->bs, c->chunk, &slot, sizeof(slot));
+
+    // The same locations as the INVOKE, so errors look exactly like they would in the closure
+    for (size_t i = 0; i < inner->locations.count; i++) {
+        if (inner->locations.data[i].index == invoke_end) {
+            bs_chunk_push_op_loc(c->bs, c->chunk, inner->locations.data[i].loc);
+        }
+    }
+
+    return true;
+}
+
 static_assert(BS_COUNT_TOKENS == 80, "Update bs_compile_stmt()");
 static void bs_compile_stmt(Bs_Compiler *c) {
     Bs_Token token = bs_lexer_next(&c->lexer);
@@ -1513,9 +2192,14 @@ static void bs_compile_stmt(Bs_Compiler *c) {
         bs_lexer_expect(&c->lexer, BS_TOKEN_LBRACE);
 
         const size_t matches_count_save = c->matches.count;
+        const size_t match_addr = c->chunk->count;
+
+        const size_t constant_cases_save = c->cases.count;
+        bool         constant_cases = true;
 
         while (!bs_lexer_read(&c->lexer, BS_TOKEN_RBRACE)) {
             const size_t cases_count_save = c->matches.count;
+            const size_t arm_cases_save = c->cases.count;
 
             do {
                 token = bs_lexer_peek(&c->lexer);
@@ -1524,8 +2208,20 @@ static void bs_compile_stmt(Bs_Compiler *c) {
                     bs_compile_expr(c, BS_POWER_SET);
                     bs_jumps_push(c->bs, &c->matches, c->chunk->count);
                     bs_chunk_push_op_int(c->bs, c->chunk, BS_OP_MATCH_IF, 0);
+
+                    constant_cases = false;
                 } else {
+                    const size_t case_addr = c->chunk->count;
                     bs_compile_expr(c, BS_POWER_SET);
+
+                    size_t constant;
+                    if (constant_cases && bs_compile_match_constant(c, case_addr, &constant)) {
+                        bs_match_cases_push(
+                            c->bs, &c->cases, ((Bs_Match_Case) {.constant = constant}));
+                    } else {
+                        constant_cases = false;
+                    }
+
                     bs_jumps_push(c->bs, &c->matches, c->chunk->count);
                     bs_chunk_push_op_int(c->bs, c->chunk, BS_OP_MATCH, 0);
                 }
@@ -1540,6 +2236,10 @@ static void bs_compile_stmt(Bs_Compiler *c) {
             }
             c->matches.count = cases_count_save;
 
+            for (size_t i = arm_cases_save; i < c->cases.count; i++) {
+                c->cases.data[i].body = c->chunk->count;
+            }
+
             bs_chunk_push_op(c->bs, c->chunk, BS_OP_DROP);
 
             token = bs_lexer_peek(&c->lexer);
@@ -1558,6 +2258,12 @@ static void bs_compile_stmt(Bs_Compiler *c) {
 
             bs_compile_jump_patch(c, skip_addr);
         }
+
+        if (constant_cases) {
+            bs_compile_match_table(c, match_addr, constant_cases_save);
+        }
+        c->cases.count = constant_cases_save;
+
         bs_chunk_push_op(c->bs, c->chunk, BS_OP_DROP);
 
         if (bs_lexer_read(&c->lexer, BS_TOKEN_ELSE)) {
@@ -1614,15 +2320,29 @@ static void bs_compile_stmt(Bs_Compiler *c) {
                 bs_chunk_push_op(c->bs, c->chunk, BS_OP_NIL);
             }
         } else {
-            // Iterator
-            bs_chunk_push_op(c->bs, c->chunk, BS_OP_NIL);
+            // Cursor
+            bs_chunk_push_op_value(c->bs, c->chunk, BS_OP_CONST, bs_value_num(0));
         }
         bs_lambda_push(c->bs, c->lambda, (Bs_Local) {.depth = c->lambda->depth});
 
+        if (b.type == BS_TOKEN_IN) {
+            // Count
+            bs_chunk_push_op(c->bs, c->chunk, BS_OP_RANGE_INIT);
+            bs_da_push(c->bs, c->chunk, inclusive);
+
+            bs_chunk_push_op_loc(c->bs, c->chunk, locs[0]);
+            bs_chunk_push_op_loc(c->bs, c->chunk, locs[1]);
+            if (locs[2].row) {
+                bs_chunk_push_op_loc(c->bs, c->chunk, locs[2]);
+            }
+            bs_lambda_push(c->bs, c->lambda, (Bs_Local) {.depth = c->lambda->depth});
+        }
+
         const Bs_Jumps jumps_save = bs_compile_jumps_save(c, c->chunk->count);
         bs_compile_block_init(c);
 
         // Key
+        const size_t key = c->lambda->count;
         bs_da_push(c->bs, c->lambda, ((Bs_Local) {.name = a.sv, .depth = c->lambda->depth}));
 
         if (b.type != BS_TOKEN_IN) {
@@ -1630,18 +2350,21 @@ static void bs_compile_stmt(Bs_Compiler *c) {
             bs_da_push(c->bs, c->lambda, ((Bs_Local) {.name = b.sv, .depth = c->lambda->depth}));
         }
 
-        Bs_Op op = BS_OP_ITER;
+        size_t loop_addr, exit_addr;
         if (b.type == BS_TOKEN_IN) {
-            op = inclusive ? BS_OP_IRANGE : BS_OP_RANGE;
-        }
-        const size_t loop_addr = bs_compile_jump_start(c, op);
+            loop_addr = bs_compile_jump_start(c, inclusive ? BS_OP_IRANGE : BS_OP_RANGE);
+            exit_addr = loop_addr;
+        } else {
+            // The bindings are patched in once the body has been compiled, and the jump offset
+            // comes right after them
+            const size_t offset = 0;
+            loop_addr = c->chunk->count;
+            exit_addr = loop_addr + 1;
 
-        bs_chunk_push_op_loc(c->bs, c->chunk, locs[0]);
-        if (b.type == BS_TOKEN_IN) {
-            bs_chunk_push_op_loc(c->bs, c->chunk, locs[1]);
-            if (locs[2].row) {
-                bs_chunk_push_op_loc(c->bs, c->chunk, locs[2]);
-            }
+            bs_chunk_push_op(c->bs, c->chunk, BS_OP_ITER);
+            bs_da_push(c->bs, c->chunk, 0);
+            bs_da_push_many(c->bs, c->chunk, &offset, sizeof(offset));
+            bs_chunk_push_op_loc(c->bs, c->chunk, locs[0]);
         }
 
         const bool inside_loop_save = c->lambda->inside_loop;
@@ -1652,10 +2375,23 @@ static void bs_compile_stmt(Bs_Compiler *c) {
 
         c->lambda->inside_loop = inside_loop_save;
 
+        if (b.type != BS_TOKEN_IN) {
+            Bs_Iter_Bindings bindings = 0;
+            if (c->lambda->data[key].used) {
+                bindings |= BS_ITER_KEY;
+            }
+
+            if (c->lambda->data[key + 1].used) {
+                bindings |= BS_ITER_VALUE;
+            }
+
+            c->chunk->data[loop_addr + 1] = bindings;
+        }
+
         bs_compile_block_end(c);
 
         bs_compile_jump_direct(c, BS_OP_JUMP, loop_addr);
-        bs_compile_jump_patch(c, loop_addr);
+        bs_compile_jump_patch(c, exit_addr);
 
         bs_compile_jumps_reset(c, jumps_save);
         bs_compile_block_end(c);
@@ -1797,6 +2533,7 @@ static void bs_compile_stmt(Bs_Compiler *c) {
                 bs_chunk_push_op(c->bs, c->chunk, BS_OP_NIL);
             } else {
                 bs_compile_expr(c, BS_POWER_SET);
+                bs_compile_tail_call(c);
             }
         } else {
             if (c->lambda->type == BS_LAMBDA_INIT) {
@@ -1822,7 +2559,10 @@ static void bs_compile_stmt(Bs_Compiler *c) {
         }
 
         bs_compile_lambda_end_ops(c, lambda, false);
-        bs_chunk_push_op(c->bs, c->chunk, BS_OP_DEFER);
+        if (!bs_compile_defer_invoke(c)) {
+            bs_chunk_push_op(c->bs, c->chunk, BS_OP_DEFER);
+            bs_chunk_push_op_loc(c->bs, c->chunk, token.loc);
+        }
     } break;
 
     default:
@@ -1869,6 +2609,10 @@ Bs_Closure *bs_compile(
 
         bs_jumps_free(compiler.bs, &compiler.jumps);
         bs_jumps_free(compiler.bs, &compiler.matches);
+        bs_match_cases_free(compiler.bs, &compiler.cases);
+        bs_depths_free(compiler.bs, &compiler.depths);
+        bs_depths_free(compiler.bs, &compiler.bases);
+        bs_depths_free(compiler.bs, &compiler.pending);
         bs_op_locs_free(compiler.bs, &compiler.locations);
         return NULL;
     }
@@ -1893,6 +2637,10 @@ Bs_Closure *bs_compile(
 
     bs_jumps_free(compiler.bs, &compiler.jumps);
     bs_jumps_free(compiler.bs, &compiler.matches);
+    bs_match_cases_free(compiler.bs, &compiler.cases);
+    bs_depths_free(compiler.bs, &compiler.depths);
+    bs_depths_free(compiler.bs, &compiler.bases);
+    bs_depths_free(compiler.bs, &compiler.pending);
     bs_op_locs_free(compiler.bs, &compiler.locations);
     return bs_closure_new(bs, fn);
 }
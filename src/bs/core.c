@@ -24,7 +24,9 @@
 
 #include "bs/compiler.h"
 #include "bs/core.h"
-#include "regex/regex.h"
+#include "bs/json.h"
+#include "bs/regex.h"
+#include "bs/serial.h"
 
 // IO
 typedef struct {
@@ -995,27 +997,66 @@ static Bs_Value bs_process_stdin(Bs *bs, Bs_Value *args, size_t arity) {
 
 // Regex
 typedef struct {
-    regex_t regex;
-} Bs_Regex;
+    Bs_Regex *regex;
+
+    // The instance the compiled pattern is borrowed from, see bs_regex_instance_init()
+    Bs_Value owner;
+} Bs_Regex_Instance;
 
 static Bs_C_Class *bs_regex_class;
 
-static void bs_regex_free(void *userdata, void *instance_data) {
-    regfree(&bs_flex_member_as(instance_data, regex_t));
+// The number of patterns kept compiled, after which the cache starts over
+#define BS_REGEX_CACHE_MAX 256
+
+static Bs_Regex *bs_regex_of(Bs_Value value) {
+    return bs_flex_member_as(((Bs_C_Instance *) value.as.object)->data, Bs_Regex_Instance).regex;
+}
+
+static void bs_regex_instance_free(void *userdata, void *instance_data) {
+    Bs_Regex_Instance *r = &bs_flex_member_as(instance_data, Bs_Regex_Instance);
+    if (r->regex && r->owner.type == BS_VALUE_NIL) {
+        bs_regex_free(r->regex);
+    }
+}
+
+static void bs_regex_instance_mark(Bs *bs, void *instance_data) {
+    bs_mark_value(bs, bs_flex_member_as(instance_data, Bs_Regex_Instance).owner);
 }
 
-static Bs_Value bs_regex_init(Bs *bs, Bs_Value *args, size_t arity) {
+static Bs_Value bs_regex_instance_init(Bs *bs, Bs_Value *args, size_t arity) {
     bs_check_arity(bs, arity, 1);
     bs_arg_check_object_type(bs, args, 0, BS_OBJECT_STR);
 
+    // Compiled patterns are cached in the class, so building the same Regex over and over again,
+    // say in a loop, compiles it once and keeps the DFA states it has built up
+    Bs_C_Class *class = ((Bs_C_Instance *) args[-1].as.object)->class;
+    if (class->shared.type == BS_VALUE_NIL) {
+        class->shared = bs_value_object(bs_table_new(bs));
+    }
+
+    Bs_Table          *cache = (Bs_Table *) class->shared.as.object;
+    Bs_Regex_Instance *r = &bs_this_c_instance_data_as(args, Bs_Regex_Instance);
+
+    Bs_Value cached;
+    if (bs_table_get(bs, cache, args[0], &cached)) {
+        r->regex = bs_regex_of(cached);
+        r->owner = cached;
+        return args[-1];
+    }
+
     const Bs_Str *pattern = (const Bs_Str *) args[0].as.object;
 
-    regex_t regex;
-    if (regcomp(&regex, pattern->data, REG_EXTENDED)) {
+    r->regex = bs_regex_new(bs, Bs_Sv(pattern->data, pattern->size));
+    if (!r->regex) {
         return bs_value_nil;
     }
 
-    bs_this_c_instance_data_as(args, regex_t) = regex;
+    if (cache->map.length >= BS_REGEX_CACHE_MAX) {
+        cache = bs_table_new(bs);
+        class->shared = bs_value_object(cache);
+    }
+
+    bs_table_set(bs, cache, args[0], args[-1]);
     return args[-1];
 }
 
@@ -1148,22 +1189,17 @@ static Bs_Value bs_str_find(Bs *bs, Bs_Value *args, size_t arity) {
             return bs_value_nil;
         }
 
-        if (str->size < pattern->size + offset) {
-            return bs_value_nil;
-        }
-
-        const Bs_Sv pattern_sv = Bs_Sv(pattern->data, pattern->size);
-        for (size_t i = offset; i + pattern->size <= str->size; i++) {
-            if (bs_sv_eq(Bs_Sv(str->data + i, pattern->size), pattern_sv)) {
-                return bs_value_num(i);
-            }
+        size_t index;
+        if (bs_sv_find_sv(
+                Bs_Sv(str->data + offset, str->size - offset),
+                Bs_Sv(pattern->data, pattern->size),
+                &index)) {
+            return bs_value_num(offset + index);
         }
     } else {
-        const regex_t regex = bs_flex_member_as(((Bs_C_Instance *) args[0].as.object)->data, regex_t);
-
-        regmatch_t match;
-        if (!regexec(&regex, str->data + offset, 1, &match, 0)) {
-            return bs_value_num(offset + match.rm_so);
+        Bs_Regex_Span match;
+        if (bs_regex_find(bs_regex_of(args[0]), Bs_Sv(str->data, str->size), offset, &match, 1)) {
+            return bs_value_num(match.begin);
         }
     }
 
@@ -1192,31 +1228,23 @@ static Bs_Value bs_str_split(Bs *bs, Bs_Value *args, size_t arity) {
         }
         const Bs_Sv pattern_sv = Bs_Sv(pattern->data, pattern->size);
 
-        size_t i = 0;
-        while (i + pattern->size <= str->size) {
-            if (bs_sv_eq(Bs_Sv(str->data + i, pattern->size), pattern_sv)) {
-                bs_array_set(bs, a, a->count, bs_value_object(bs_str_new(bs, Bs_Sv(str->data + j, i - j))));
-
-                i += pattern->size;
-                j = i;
-            } else {
-                i++;
-            }
+        size_t i;
+        while (bs_sv_find_sv(Bs_Sv(str->data + j, str->size - j), pattern_sv, &i)) {
+            bs_array_set(bs, a, a->count, bs_value_object(bs_str_new(bs, Bs_Sv(str->data + j, i))));
+            j += i + pattern->size;
         }
     } else {
-        const regex_t regex = bs_flex_member_as(((Bs_C_Instance *) args[0].as.object)->data, regex_t);
+        Bs_Regex *regex = bs_regex_of(args[0]);
 
-        int        eflags = 0;
-        regmatch_t match;
-        while (!regexec(&regex, str->data + j, 1, &match, eflags)) {
-            eflags = REG_NOTBOL;
-            if (match.rm_so == match.rm_eo) {
+        Bs_Regex_Span match;
+        while (bs_regex_find(regex, Bs_Sv(str->data, str->size), j, &match, 1)) {
+            if (match.begin == match.end) {
                 break;
             }
 
-            bs_array_set(bs, a, a->count, bs_value_object(bs_str_new(bs, Bs_Sv(str->data + j, match.rm_so))));
+            bs_array_set(bs, a, a->count, bs_value_object(bs_str_new(bs, Bs_Sv(str->data + j, match.begin - j))));
 
-            j += match.rm_eo;
+            j = match.end;
         }
     }
 
@@ -1246,59 +1274,56 @@ static Bs_Value bs_str_replace(Bs *bs, Bs_Value *args, size_t arity) {
             return bs_value_object(str);
         }
 
-        if (str->size < pattern->size) {
+        const Bs_Sv pattern_sv = Bs_Sv(pattern->data, pattern->size);
+
+        size_t i;
+        if (!bs_sv_find_sv(Bs_Sv(str->data, str->size), pattern_sv, &i)) {
             return bs_value_object(str);
         }
 
         Bs_Buffer   *b = &bs_config(bs)->buffer;
         const size_t start = b->count;
 
-        const Bs_Sv pattern_sv = Bs_Sv(pattern->data, pattern->size);
-        for (size_t i = 0; i + pattern->size <= str->size; i++) {
-            if (bs_sv_eq(Bs_Sv(str->data + i, pattern->size), pattern_sv)) {
-                bs_da_push_many(bs, b, replacement->data, replacement->size);
-                i += pattern->size - 1;
-            } else {
-                if (i + pattern->size >= str->size) {
-                    bs_da_push_many(bs, b, str->data + i, str->size - i);
-                    break;
-                } else {
-                    bs_da_push(bs, b, str->data[i]);
-                }
-            }
-        }
+        // Copy over everything in between the matches at once
+        size_t j = 0;
+        do {
+            bs_da_push_many(bs, b, str->data + j, i);
+            bs_da_push_many(bs, b, replacement->data, replacement->size);
+            j += i + pattern->size;
+        } while (bs_sv_find_sv(Bs_Sv(str->data + j, str->size - j), pattern_sv, &i));
+
+        bs_da_push_many(bs, b, str->data + j, str->size - j);
         return bs_value_object(bs_str_new(bs, bs_buffer_reset(b, start)));
     } else {
         Bs_Buffer   *b = &bs_config(bs)->buffer;
         const size_t start = b->count;
 
-        const char   *cursor = str->data;
-        const regex_t regex = bs_flex_member_as(((Bs_C_Instance *) args[0].as.object)->data, regex_t);
+        Bs_Regex   *regex = bs_regex_of(args[0]);
+        const Bs_Sv text = Bs_Sv(str->data, str->size);
 
-        int        eflags = 0;
-        regmatch_t matches[10];
-        while (!regexec(&regex, cursor, bs_c_array_size(matches), matches, eflags)) {
-            eflags = REG_NOTBOL;
-            if (matches[0].rm_so == matches[0].rm_eo) {
+        size_t        cursor = 0;
+        Bs_Regex_Span matches[10];
+        while (bs_regex_find(regex, text, cursor, matches, bs_c_array_size(matches))) {
+            if (matches[0].begin == matches[0].end) {
                 break;
             }
 
-            bs_da_push_many(bs, b, cursor, matches[0].rm_so);
+            bs_da_push_many(bs, b, str->data + cursor, matches[0].begin - cursor);
 
             for (size_t i = 0; i < replacement->size; i++) {
                 if (replacement->data[i] == '\\' && isdigit(replacement->data[i + 1])) {
-                    const size_t j = replacement->data[++i] - '0';
-                    if (j < bs_c_array_size(matches) && matches[j].rm_so != -1) {
-                        bs_da_push_many(bs, b, cursor + matches[j].rm_so, matches[j].rm_eo - matches[j].rm_so);
+                    const Bs_Regex_Span group = matches[replacement->data[++i] - '0'];
+                    if (group.begin != BS_REGEX_NONE) {
+                        bs_da_push_many(bs, b, str->data + group.begin, group.end - group.begin);
                     }
                 } else {
                     bs_da_push(bs, b, replacement->data[i]);
                 }
             }
 
-            cursor += matches[0].rm_eo;
+            cursor = matches[0].end;
         }
-        bs_da_push_many(bs, b, cursor, str->size - (cursor - str->data));
+        bs_da_push_many(bs, b, str->data + cursor, str->size - cursor);
 
         return bs_value_object(bs_str_new(bs, bs_buffer_reset(b, start)));
     }
@@ -1843,281 +1868,2296 @@ static Bs_Value bs_bytes_set(Bs *bs, Bs_Value *args, size_t arity) {
     return bs_value_nil;
 }
 
-// Array
-static Bs_Value bs_array_map(Bs *bs, Bs_Value *args, size_t arity) {
-    bs_check_arity(bs, arity, 1);
-    bs_arg_check_callable(bs, args, 0);
+// Binary Fields
+//
+// Formats follow the struct module of Python. Each code can be preceded by a repeat count, except
+// for `s` where the count is the length of the string. The byte order is little endian until it is
+// changed by `<`, `>` or `!`
+typedef struct {
+    const char *p;
+    const char *end;
+    bool        big;
+} Bs_Bytes_Format;
 
-    const Bs_Array *src = (const Bs_Array *) args[-1].as.object;
-    const Bs_Value  fn = args[0];
-    Bs_Array       *dst = bs_array_new(bs);
+static size_t bs_bytes_field_size(char code) {
+    switch (code) {
+    case 'x':
+    case 'b':
+    case 'B':
+    case 's':
+        return 1;
 
-    for (size_t i = 0; i < src->count; i++) {
-        const Bs_Value input = src->data[i];
-        const Bs_Value output = bs_call(bs, fn, &input, 1);
-        bs_array_set(bs, dst, i, output);
+    case 'h':
+    case 'H':
+        return 2;
+
+    case 'i':
+    case 'I':
+    case 'f':
+        return 4;
+
+    case 'q':
+    case 'Q':
+    case 'd':
+        return 8;
+
+    default:
+        return 0;
     }
+}
 
-    return bs_value_object(dst);
+static Bs_Bytes_Format bs_bytes_format(const Bs_Value *args, size_t index) {
+    const Bs_Str *str = (const Bs_Str *) args[index].as.object;
+    return (Bs_Bytes_Format) {.p = str->data, .end = str->data + str->size};
 }
 
-static Bs_Value bs_array_filter(Bs *bs, Bs_Value *args, size_t arity) {
-    bs_check_arity(bs, arity, 1);
-    bs_arg_check_callable(bs, args, 0);
+// Returns false at the end of the format
+static bool bs_bytes_format_next(Bs *bs, Bs_Bytes_Format *f, char *code, size_t *count) {
+    while (f->p < f->end) {
+        char c = *f->p++;
+        if (c == '<') {
+            f->big = false;
+            continue;
+        }
 
-    const Bs_Array *src = (const Bs_Array *) args[-1].as.object;
-    const Bs_Value  fn = args[0];
-    Bs_Array       *dst = bs_array_new(bs);
+        if (c == '>' || c == '!') {
+            f->big = true;
+            continue;
+        }
 
-    for (size_t i = 0; i < src->count; i++) {
-        const Bs_Value input = src->data[i];
-        const Bs_Value output = bs_call(bs, fn, &input, 1);
+        if (isspace((unsigned char) c)) {
+            continue;
+        }
 
-        if (!bs_value_is_falsey(output)) {
-            bs_array_set(bs, dst, dst->count, input);
+        *count = 1;
+        if (isdigit((unsigned char) c)) {
+            *count = c - '0';
+            while (f->p < f->end && isdigit((unsigned char) *f->p)) {
+                if (*count > (SIZE_MAX - 9) / 10) {
+                    bs_error_at(bs, 1, "format count is too large");
+                }
+                *count = *count * 10 + (*f->p++ - '0');
+            }
+
+            if (f->p == f->end) {
+                bs_error_at(bs, 1, "expected format character after count");
+            }
+            c = *f->p++;
         }
+
+        if (!bs_bytes_field_size(c)) {
+            bs_error_at(bs, 1, "invalid format character '%c'", c);
+        }
+
+        *code = c;
+        return true;
     }
 
-    return bs_value_object(dst);
+    return false;
 }
 
-static Bs_Value bs_array_reduce(Bs *bs, Bs_Value *args, size_t arity) {
-    if (arity != 1 && arity != 2) {
-        bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
+// The number of bytes the fields take, and the number of values they stand for
+static size_t bs_bytes_format_size(Bs *bs, Bs_Bytes_Format f, size_t *values) {
+    size_t size = 0;
+    *values = 0;
+
+    char   code;
+    size_t count;
+    while (bs_bytes_format_next(bs, &f, &code, &count)) {
+        const size_t field = bs_bytes_field_size(code);
+        if (count > (SIZE_MAX - size) / field) {
+            bs_error_at(bs, 1, "format count is too large");
+        }
+        size += count * field;
+
+        if (code == 's') {
+            *values += 1;
+        } else if (code != 'x') {
+            *values += count;
+        }
     }
 
-    bs_arg_check_callable(bs, args, 0);
+    return size;
+}
 
-    const Bs_Array *src = (const Bs_Array *) args[-1].as.object;
-    const Bs_Value  fn = args[0];
-    Bs_Value        acc = arity == 2 ? args[1] : bs_value_nil;
+static void bs_bytes_check_range(Bs *bs, const Bs_Buffer *b, size_t offset, size_t size) {
+    if (offset > b->count || size > b->count - offset) {
+        bs_error(
+            bs,
+            "cannot access %zu bytes at offset %zu in Bytes of length %zu",
+            size,
+            offset,
+            b->count);
+    }
+}
 
-    for (size_t i = 0; i < src->count; i++) {
-        if (acc.type == BS_VALUE_NIL) {
-            acc = src->data[i];
-            continue;
+static uint64_t bs_bytes_load(const uint8_t *p, size_t size, bool big) {
+    uint64_t bits = 0;
+    if (big) {
+        for (size_t i = 0; i < size; i++) {
+            bits = (bits << 8) | p[i];
+        }
+    } else {
+        for (size_t i = size; i--;) {
+            bits = (bits << 8) | p[i];
         }
-
-        const Bs_Value input[] = {acc, src->data[i]};
-        acc = bs_call(bs, fn, input, bs_c_array_size(input));
     }
+    return bits;
+}
 
-    return acc;
+static void bs_bytes_store(uint8_t *p, size_t size, bool big, uint64_t bits) {
+    for (size_t i = 0; i < size; i++) {
+        p[big ? size - 1 - i : i] = bits >> (i * 8);
+    }
 }
 
-static Bs_Value bs_array_join(Bs *bs, Bs_Value *args, size_t arity) {
-    bs_check_arity(bs, arity, 1);
-    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_STR);
+// Decodes the fields into `values`, which has room for all of them. The range must be checked
+static void bs_bytes_decode(Bs *bs, const uint8_t *p, Bs_Bytes_Format f, Bs_Value *values) {
+    char   code;
+    size_t count;
+    while (bs_bytes_format_next(bs, &f, &code, &count)) {
+        if (code == 'x') {
+            p += count;
+            continue;
+        }
 
-    Bs_Buffer   *b = &bs_config(bs)->buffer;
-    const size_t start = b->count;
-    {
-        Bs_Writer w = bs_buffer_writer(b);
+        if (code == 's') {
+            *values++ = bs_value_object(bs_str_new(bs, Bs_Sv((const char *) p, count)));
+            p += count;
+            continue;
+        }
 
-        const Bs_Array *array = (const Bs_Array *) args[-1].as.object;
-        const Bs_Str   *str = (const Bs_Str *) args[0].as.object;
-        const Bs_Sv     separator = Bs_Sv(str->data, str->size);
+        const size_t size = bs_bytes_field_size(code);
+        for (size_t i = 0; i < count; i++, p += size) {
+            const uint64_t bits = bs_bytes_load(p, size, f.big);
 
-        for (size_t i = 0; i < array->count; i++) {
-            if (i) {
-                w.write(&w, separator);
+            double n = 0;
+            switch (code) {
+            case 'b':
+                n = (int8_t) bits;
+                break;
+
+            case 'B':
+                n = (uint8_t) bits;
+                break;
+
+            case 'h':
+                n = (int16_t) bits;
+                break;
+
+            case 'H':
+                n = (uint16_t) bits;
+                break;
+
+            case 'i':
+                n = (int32_t) bits;
+                break;
+
+            case 'I':
+                n = (uint32_t) bits;
+                break;
+
+            case 'q':
+                n = (int64_t) bits;
+                break;
+
+            case 'Q':
+                n = bits;
+                break;
+
+            case 'f': {
+                const uint32_t half = bits;
+                float          x;
+                memcpy(&x, &half, sizeof(x));
+                n = x;
+            } break;
+
+            case 'd':
+                memcpy(&n, &bits, sizeof(n));
+                break;
             }
-            bs_value_write(bs, &w, array->data[i]);
+
+            *values++ = bs_value_num(n);
         }
     }
-    return bs_value_object(bs_str_new(bs, bs_buffer_reset(b, start)));
 }
 
-static Bs_Value bs_array_find(Bs *bs, Bs_Value *args, size_t arity) {
-    if (arity != 1 && arity != 2) {
-        bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
-    }
+// Encodes the values, which are the arguments from `index` onwards. Integers must be whole, and
+// wrap around like they do in typed arrays
+static void
+bs_bytes_encode(Bs *bs, uint8_t *p, Bs_Bytes_Format f, const Bs_Value *args, size_t index) {
+    char   code;
+    size_t count;
+    while (bs_bytes_format_next(bs, &f, &code, &count)) {
+        if (code == 'x') {
+            memset(p, 0, count);
+            p += count;
+            continue;
+        }
 
-    if (arity == 2) {
-        bs_arg_check_whole_number(bs, args, 1);
-    }
+        if (code == 's') {
+            const Bs_Check checks[] = {
+                bs_check_object(BS_OBJECT_STR),
+                bs_check_c_instance(bs_bytes_class),
+            };
+            bs_arg_check_multi(bs, args, index, checks, bs_c_array_size(checks));
+
+            Bs_Sv sv;
+            if (args[index].as.object->type == BS_OBJECT_STR) {
+                const Bs_Str *str = (const Bs_Str *) args[index].as.object;
+                sv = Bs_Sv(str->data, str->size);
+            } else {
+                const Bs_Buffer *src =
+                    &bs_flex_member_as(((Bs_C_Instance *) args[index].as.object)->data, Bs_Buffer);
+                sv = Bs_Sv(src->data, src->count);
+            }
 
-    const Bs_Array *array = (const Bs_Array *) args[-1].as.object;
-    const Bs_Value  pred = args[0];
-    const size_t    offset = arity == 2 ? args[1].as.number : 0;
+            // Cut or padded with zeroes to the length
+            const size_t size = bs_min(sv.size, count);
+            memmove(p, sv.data, size);
+            memset(p + size, 0, count - size);
 
-    for (size_t i = offset; i < array->count; i++) {
-        if (bs_value_equal(array->data[i], pred)) {
-            return bs_value_num(i);
+            p += count;
+            index++;
+            continue;
         }
-    }
 
-    return bs_value_nil;
+        const size_t size = bs_bytes_field_size(code);
+        for (size_t i = 0; i < count; i++, p += size, index++) {
+            bs_arg_check_value_type(bs, args, index, BS_VALUE_NUM);
+            const double n = args[index].as.number;
+
+            uint64_t bits;
+            if (code == 'f') {
+                const float x = n;
+                uint32_t    half;
+                memcpy(&half, &x, sizeof(half));
+                bits = half;
+            } else if (code == 'd') {
+                memcpy(&bits, &n, sizeof(bits));
+            } else {
+                bs_arg_check_integer(bs, args, index);
+                if (n < -9223372036854775808.0 || n >= 18446744073709551616.0) {
+                    bs_error_at(bs, index + 1, "number %.15g is out of range for '%c'", n, code);
+                }
+                bits = n < 0 ? (uint64_t) (int64_t) n : (uint64_t) n;
+            }
+
+            bs_bytes_store(p, size, f.big, bits);
+        }
+    }
 }
 
-static Bs_Value bs_array_push(Bs *bs, Bs_Value *args, size_t arity) {
-    bs_check_arity(bs, arity, 1);
-    Bs_Array *a = (Bs_Array *) args[-1].as.object;
-    bs_array_set(bs, a, a->count, args[0]);
-    return args[-1];
+static size_t bs_bytes_offset(Bs *bs, Bs_Value *args, size_t index) {
+    bs_arg_check_whole_number(bs, args, index);
+    return args[index].as.number;
 }
 
-static Bs_Value bs_array_insert(Bs *bs, Bs_Value *args, size_t arity) {
+static Bs_Value bs_bytes_read(Bs *bs, Bs_Value *args, size_t arity) {
     bs_check_arity(bs, arity, 2);
-    bs_arg_check_whole_number(bs, args, 0);
+    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_STR);
 
-    Bs_Array      *a = (Bs_Array *) args[-1].as.object;
-    const size_t   index = args[0].as.number;
-    const Bs_Value value = args[1];
+    const Bs_Buffer      *b = &bs_this_c_instance_data_as(args, Bs_Buffer);
+    const Bs_Bytes_Format f = bs_bytes_format(args, 0);
+    const size_t          offset = bs_bytes_offset(bs, args, 1);
 
-    if (index < a->count) {
-        bs_array_set(bs, a, a->count, bs_value_nil);
+    size_t       values;
+    const size_t size = bs_bytes_format_size(bs, f, &values);
+    if (values != 1) {
+        bs_error_at(bs, 1, "expected format of a single value, got %zu", values);
+    }
+    bs_bytes_check_range(bs, b, offset, size);
 
-        for (size_t i = index; i + 1 < a->count; i++) {
-            a->data[i + 1] = a->data[i];
-        }
+    Bs_Value value;
+    bs_bytes_decode(bs, (const uint8_t *) b->data + offset, f, &value);
+    return value;
+}
 
-        a->data[index] = value;
-    } else {
-        bs_array_set(bs, a, index, value);
+static Bs_Value bs_bytes_write(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity < 2) {
+        bs_error(bs, "expected at least 2 arguments, got %zu", arity);
     }
-    return args[-1];
-}
+    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_STR);
 
-static Bs_Value bs_array_pop(Bs *bs, Bs_Value *args, size_t arity) {
-    bs_check_arity(bs, arity, 0);
-    Bs_Array *a = (Bs_Array *) args[-1].as.object;
-    if (!a->count) {
-        bs_error(bs, "cannot pop from empty array");
+    Bs_Buffer            *b = &bs_this_c_instance_data_as(args, Bs_Buffer);
+    const Bs_Bytes_Format f = bs_bytes_format(args, 0);
+    const size_t          offset = bs_bytes_offset(bs, args, 1);
+
+    size_t       values;
+    const size_t size = bs_bytes_format_size(bs, f, &values);
+    if (values != arity - 2) {
+        bs_error(bs, "format takes %zu values, got %zu", values, arity - 2);
     }
+    bs_bytes_check_range(bs, b, offset, size);
 
-    return a->data[--a->count];
+    // Encoded past the end first, so that an invalid value leaves the fields as they were
+    bs_da_push_many(bs, b, NULL, size);
+    bs_bytes_encode(bs, (uint8_t *) b->data + b->count, f, args, 2);
+    memcpy(b->data + offset, b->data + b->count, size);
+    return args[-1];
 }
 
-typedef struct {
-    Bs      *bs;
-    Bs_Value fn;
-} Bs_Array_Sort_Context;
+static Bs_Value bs_bytes_pack(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity < 1) {
+        bs_error(bs, "expected at least 1 argument, got %zu", arity);
+    }
+    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_STR);
 
-static Bs_Array_Sort_Context sort_context;
+    Bs_Buffer            *b = &bs_this_c_instance_data_as(args, Bs_Buffer);
+    const Bs_Bytes_Format f = bs_bytes_format(args, 0);
 
-static int bs_array_sort_compare(const void *a, const void *b) {
-    const Bs_Value args[] = {
-        *(const Bs_Value *) a,
-        *(const Bs_Value *) b,
-    };
+    size_t       values;
+    const size_t size = bs_bytes_format_size(bs, f, &values);
+    if (values != arity - 1) {
+        bs_error(bs, "format takes %zu values, got %zu", values, arity - 1);
+    }
 
-    const Bs_Value output = bs_call(sort_context.bs, sort_context.fn, args, bs_c_array_size(args));
-    return bs_value_is_falsey(output) ? 1 : -1;
+    // Only counted once every value is known to be valid
+    bs_da_push_many(bs, b, NULL, size);
+    bs_bytes_encode(bs, (uint8_t *) b->data + b->count, f, args, 1);
+    b->count += size;
+    return args[-1];
 }
 
-static Bs_Value bs_array_sort(Bs *bs, Bs_Value *args, size_t arity) {
-    bs_check_arity(bs, arity, 1);
-    bs_arg_check_callable(bs, args, 0);
-
-    sort_context.bs = bs;
-    sort_context.fn = args[0];
+static Bs_Value bs_bytes_unpack(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 1 && arity != 2) {
+        bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
+    }
+    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_STR);
 
-    Bs_Array *src = (Bs_Array *) args[-1].as.object;
-    qsort(src->data, src->count, sizeof(*src->data), bs_array_sort_compare);
-    return args[-1];
-}
+    const Bs_Buffer      *b = &bs_this_c_instance_data_as(args, Bs_Buffer);
+    const Bs_Bytes_Format f = bs_bytes_format(args, 0);
+    const size_t          offset = arity == 2 ? bs_bytes_offset(bs, args, 1) : 0;
 
-static Bs_Value bs_array_resize(Bs *bs, Bs_Value *args, size_t arity) {
-    bs_check_arity(bs, arity, 1);
-    bs_arg_check_whole_number(bs, args, 0);
+    size_t       values;
+    const size_t size = bs_bytes_format_size(bs, f, &values);
+    bs_bytes_check_range(bs, b, offset, size);
 
-    Bs_Array    *src = (Bs_Array *) args[-1].as.object;
-    const size_t size = args[0].as.number;
-    if (size > src->count) {
-        bs_array_set(bs, src, size - 1, bs_value_nil);
-    } else {
-        src->count = size;
+    Bs_Array *array = bs_array_new(bs);
+    if (values) {
+        array->data = bs_realloc(bs, NULL, 0, values * sizeof(*array->data));
+        array->capacity = values;
+        for (size_t i = 0; i < values; i++) {
+            array->data[i] = bs_value_nil;
+        }
+        array->count = values;
     }
-    return args[-1];
+
+    bs_bytes_decode(bs, (const uint8_t *) b->data + offset, f, array->data);
+    return bs_value_object(array);
 }
 
-static Bs_Value bs_array_reverse(Bs *bs, Bs_Value *args, size_t arity) {
-    bs_check_arity(bs, arity, 0);
+// The contents of a string or another Bytes
+static Bs_Sv bs_bytes_source(Bs *bs, Bs_Value *args, size_t index) {
+    const Bs_Check checks[] = {
+        bs_check_object(BS_OBJECT_STR),
+        bs_check_c_instance(bs_bytes_class),
+    };
+    bs_arg_check_multi(bs, args, index, checks, bs_c_array_size(checks));
 
-    Bs_Array *src = (Bs_Array *) args[-1].as.object;
-    for (size_t i = 0; i < src->count / 2; i++) {
-        const Bs_Value t = src->data[i];
-        src->data[i] = src->data[src->count - i - 1];
-        src->data[src->count - i - 1] = t;
+    if (args[index].as.object->type == BS_OBJECT_STR) {
+        const Bs_Str *str = (const Bs_Str *) args[index].as.object;
+        return Bs_Sv(str->data, str->size);
     }
-    return args[-1];
+
+    const Bs_Buffer *b = &bs_flex_member_as(((Bs_C_Instance *) args[index].as.object)->data, Bs_Buffer);
+    return Bs_Sv(b->data, b->count);
 }
 
-static Bs_Value bs_array_fill(Bs *bs, Bs_Value *args, size_t arity) {
-    bs_check_arity(bs, arity, 1);
+static Bs_Value bs_bytes_append(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 1 && arity != 3) {
+        bs_error(bs, "expected 1 or 3 arguments, got %zu", arity);
+    }
 
-    Bs_Array *src = (Bs_Array *) args[-1].as.object;
-    for (size_t i = 0; i < src->count; i++) {
-        src->data[i] = args[0];
+    Bs_Buffer *b = &bs_this_c_instance_data_as(args, Bs_Buffer);
+    Bs_Sv      sv = bs_bytes_source(bs, args, 0);
+
+    if (arity == 3) {
+        const size_t begin = bs_bytes_offset(bs, args, 1);
+        const size_t end = bs_bytes_offset(bs, args, 2);
+        if (begin > end || end > sv.size) {
+            bs_error(bs, "cannot append from %zu to %zu of %zu bytes", begin, end, sv.size);
+        }
+        sv = Bs_Sv(sv.data + begin, end - begin);
     }
+
+    // The source can be this very buffer, which may move as it grows
+    const bool   self = args[0].type == BS_VALUE_OBJECT && args[0].as.object == args[-1].as.object;
+    const size_t from = self ? sv.data - b->data : 0;
+
+    bs_da_push_many(bs, b, NULL, sv.size);
+    memcpy(b->data + b->count, self ? b->data + from : sv.data, sv.size);
+    b->count += sv.size;
     return args[-1];
 }
 
-static Bs_Value bs_array_slice(Bs *bs, Bs_Value *args, size_t arity) {
+static Bs_Value bs_bytes_find(Bs *bs, Bs_Value *args, size_t arity) {
     if (arity != 1 && arity != 2) {
         bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
     }
 
-    bs_arg_check_whole_number(bs, args, 0);
-    if (arity == 2) {
-        bs_arg_check_whole_number(bs, args, 1);
+    const Bs_Buffer *b = &bs_this_c_instance_data_as(args, Bs_Buffer);
+    const Bs_Sv      pattern = bs_bytes_source(bs, args, 0);
+    const size_t     offset = arity == 2 ? bs_bytes_offset(bs, args, 1) : 0;
+
+    if (offset > b->count) {
+        bs_error_at(bs, 2, "cannot take offset of %zu in Bytes of length %zu", offset, b->count);
+    }
+
+    size_t index;
+    if (pattern.size && bs_sv_find_sv(Bs_Sv(b->data + offset, b->count - offset), pattern, &index)) {
+        return bs_value_num(offset + index);
+    }
+    return bs_value_nil;
+}
+
+static Bs_Value bs_bytes_compare(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+
+    const Bs_Buffer *b = &bs_this_c_instance_data_as(args, Bs_Buffer);
+    const Bs_Sv      other = bs_bytes_source(bs, args, 0);
+
+    const size_t size = bs_min(b->count, other.size);
+    const int    result = size ? memcmp(b->data, other.data, size) : 0;
+    if (result) {
+        return bs_value_num(result < 0 ? -1 : 1);
+    }
+    return bs_value_num(b->count == other.size ? 0 : b->count < other.size ? -1 : 1);
+}
+
+// Typed Arrays
+//
+// Fixed size arrays of raw numbers, which take a fraction of the memory of an array of values and
+// come with bulk operations that run as plain C loops over the elements
+typedef enum {
+    BS_TYPED_F64,
+    BS_TYPED_F32,
+    BS_TYPED_I64,
+    BS_TYPED_I32,
+    BS_TYPED_U8,
+    BS_COUNT_TYPED,
+} Bs_Typed_Kind;
+
+static const struct {
+    const char *name;
+    size_t      size;
+} bs_typed_kinds[BS_COUNT_TYPED] = {
+    [BS_TYPED_F64] = {"F64Array", sizeof(double)},
+    [BS_TYPED_F32] = {"F32Array", sizeof(float)},
+    [BS_TYPED_I64] = {"I64Array", sizeof(int64_t)},
+    [BS_TYPED_I32] = {"I32Array", sizeof(int32_t)},
+    [BS_TYPED_U8] = {"U8Array", sizeof(uint8_t)},
+};
+
+static Bs_C_Class *bs_typed_array_classes[BS_COUNT_TYPED];
+
+typedef struct {
+    Bs_Typed_Kind kind;
+    void         *data;
+    size_t        count;
+
+    // Set for the arrays which own their data
+    Bs *bs;
+
+    // The array a slice is a view into
+    Bs_Value owner;
+} Bs_Typed_Array;
+
+// Expands `F(T, U)` with the element type of the kind, and the type its arithmetic is done in. The
+// integers wrap around, so they are computed unsigned
+#define bs_typed_array_switch(kind, F)                                                             \
+    do {                                                                                           \
+        switch (kind) {                                                                            \
+        case BS_TYPED_F64:                                                                         \
+            F(double, double);                                                                     \
+            break;                                                                                 \
+        case BS_TYPED_F32:                                                                         \
+            F(float, float);                                                                       \
+            break;                                                                                 \
+        case BS_TYPED_I64:                                                                         \
+            F(int64_t, uint64_t);                                                                  \
+            break;                                                                                 \
+        case BS_TYPED_I32:                                                                         \
+            F(int32_t, uint32_t);                                                                  \
+            break;                                                                                 \
+        case BS_TYPED_U8:                                                                          \
+            F(uint8_t, uint32_t);                                                                  \
+            break;                                                                                 \
+        default:                                                                                   \
+            assert(false && "unreachable");                                                        \
+        }                                                                                          \
+    } while (0)
+
+static bool bs_typed_kind_is_float(Bs_Typed_Kind kind) {
+    return kind == BS_TYPED_F64 || kind == BS_TYPED_F32;
+}
+
+static Bs_Typed_Array *bs_typed_array_of(Bs_Value value) {
+    return &bs_flex_member_as(((Bs_C_Instance *) value.as.object)->data, Bs_Typed_Array);
+}
+
+static Bs_Typed_Array *bs_typed_array_check(Bs *bs, Bs_Value *args, size_t index) {
+    const Bs_Check checks[] = {
+        bs_check_c_instance(bs_typed_array_classes[BS_TYPED_F64]),
+        bs_check_c_instance(bs_typed_array_classes[BS_TYPED_F32]),
+        bs_check_c_instance(bs_typed_array_classes[BS_TYPED_I64]),
+        bs_check_c_instance(bs_typed_array_classes[BS_TYPED_I32]),
+        bs_check_c_instance(bs_typed_array_classes[BS_TYPED_U8]),
+    };
+    bs_arg_check_multi(bs, args, index, checks, bs_c_array_size(checks));
+    return bs_typed_array_of(args[index]);
+}
+
+// Bulk operations between two arrays need them to be of the same kind and length
+static Bs_Typed_Array *bs_typed_array_check_same(Bs *bs, Bs_Value *args, size_t index) {
+    const Bs_Typed_Array *a = bs_typed_array_of(args[-1]);
+    const Bs_Check        check = bs_check_c_instance(bs_typed_array_classes[a->kind]);
+    bs_arg_check_multi(bs, args, index, &check, 1);
+
+    Bs_Typed_Array *b = bs_typed_array_of(args[index]);
+    if (a->count != b->count) {
+        bs_error(
+            bs,
+            "cannot combine %s of length %zu with one of length %zu",
+            bs_typed_kinds[a->kind].name,
+            a->count,
+            b->count);
+    }
+    return b;
+}
+
+static double bs_typed_array_load(const Bs_Typed_Array *a, size_t index) {
+#define F(T, U) return ((const T *) a->data)[index]
+    bs_typed_array_switch(a->kind, F);
+#undef F
+    return 0;
+}
+
+// Checks that the value fits the kind, and converts it to the bits of the element. Integers must be
+// whole, and wrap around like they do in C
+static void bs_typed_array_convert(
+    Bs           *bs,
+    Bs_Typed_Kind kind,
+    size_t        location,
+    const char   *label,
+    Bs_Value      value,
+    double       *f,
+    uint64_t     *i) {
+    bs_check_value_type_at(bs, location, value, BS_VALUE_NUM, label);
+    if (bs_typed_kind_is_float(kind)) {
+        *f = value.as.number;
+        return;
+    }
+
+    bs_check_integer_at(bs, location, value, label);
+    const double n = value.as.number;
+    if (n < -9223372036854775808.0 || n >= 18446744073709551616.0) {
+        bs_error_at(bs, location, "number %.15g is out of range for %s", n, bs_typed_kinds[kind].name);
+    }
+    *i = n < 0 ? (uint64_t) (int64_t) n : (uint64_t) n;
+}
+
+static void bs_typed_array_store(
+    Bs             *bs,
+    Bs_Typed_Array *a,
+    size_t          begin,
+    size_t          end,
+    size_t          location,
+    const char     *label,
+    Bs_Value        value) {
+    double   f = 0;
+    uint64_t i = 0;
+    bs_typed_array_convert(bs, a->kind, location, label, value, &f, &i);
+
+#define F(T, U)                                                                                    \
+    do {                                                                                           \
+        T *data = a->data;                                                                         \
+        T  x = bs_typed_kind_is_float(a->kind) ? (T) f : (T) i;                                    \
+        for (size_t j = begin; j < end; j++) {                                                     \
+            data[j] = x;                                                                           \
+        }                                                                                          \
+    } while (0)
+    bs_typed_array_switch(a->kind, F);
+#undef F
+}
+
+static void bs_typed_array_alloc(Bs *bs, Bs_Typed_Array *a, size_t count) {
+    const size_t size = count * bs_typed_kinds[a->kind].size;
+    a->data = bs_realloc(bs, NULL, 0, size);
+    a->count = count;
+    a->bs = bs;
+    memset(a->data, 0, size);
+}
+
+static void bs_typed_array_free(void *userdata, void *instance_data) {
+    Bs_Typed_Array *a = &bs_flex_member_as(instance_data, Bs_Typed_Array);
+    if (a->bs) {
+        bs_realloc(a->bs, a->data, a->count * bs_typed_kinds[a->kind].size, 0);
+    }
+}
+
+static void bs_typed_array_mark(Bs *bs, void *instance_data) {
+    Bs_Typed_Array *a = &bs_flex_member_as(instance_data, Bs_Typed_Array);
+    bs_mark_value(bs, a->owner);
+}
+
+static void bs_typed_array_show(Bs_Pretty_Printer *p, const void *instance_data) {
+    const Bs_Typed_Array *a = &bs_flex_member_as(instance_data, Bs_Typed_Array);
+
+    bs_fmt(p->writer, "%s([", bs_typed_kinds[a->kind].name);
+    for (size_t i = 0; i < a->count; i++) {
+        if (i) {
+            bs_fmt(p->writer, ", ");
+        }
+        bs_value_write_impl(p, bs_value_num(bs_typed_array_load(a, i)));
+    }
+    bs_fmt(p->writer, "])");
+}
+
+static size_t bs_typed_array_count_hook(const void *instance_data) {
+    return bs_flex_member_as(instance_data, Bs_Typed_Array).count;
+}
+
+static Bs_Value bs_typed_array_get_hook(Bs *bs, const void *instance_data, size_t index) {
+    return bs_value_num(bs_typed_array_load(&bs_flex_member_as(instance_data, Bs_Typed_Array), index));
+}
+
+static void bs_typed_array_set_hook(Bs *bs, void *instance_data, size_t index, Bs_Value value) {
+    Bs_Typed_Array *a = &bs_flex_member_as(instance_data, Bs_Typed_Array);
+    bs_typed_array_store(bs, a, index, index + 1, 0, "element", value);
+}
+
+static Bs_Value bs_typed_array_new(Bs *bs, Bs_Typed_Kind kind) {
+    Bs_C_Instance  *instance = bs_c_instance_new(bs, bs_typed_array_classes[kind]);
+    Bs_Typed_Array *a = &bs_flex_member_as(instance->data, Bs_Typed_Array);
+    a->kind = kind;
+    return bs_value_object(instance);
+}
+
+static void bs_typed_array_init(Bs *bs, Bs_Value *args, size_t arity, Bs_Typed_Kind kind) {
+    bs_check_arity(bs, arity, 1);
+
+    Bs_Typed_Array *a = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+    a->kind = kind;
+
+    if (args[0].type == BS_VALUE_NUM) {
+        bs_arg_check_whole_number(bs, args, 0);
+        bs_typed_array_alloc(bs, a, args[0].as.number);
+        return;
+    }
+
+    if (args[0].type == BS_VALUE_OBJECT && args[0].as.object->type == BS_OBJECT_ARRAY) {
+        const Bs_Array *src = (const Bs_Array *) args[0].as.object;
+        bs_typed_array_alloc(bs, a, src->count);
+        for (size_t i = 0; i < src->count; i++) {
+            bs_typed_array_store(bs, a, i, i + 1, 1, "element", src->data[i]);
+        }
+        return;
+    }
+
+    // Conversion between kinds
+    const Bs_Typed_Array *src = bs_typed_array_check(bs, args, 0);
+    bs_typed_array_alloc(bs, a, src->count);
+    for (size_t i = 0; i < src->count; i++) {
+        bs_typed_array_store(
+            bs, a, i, i + 1, 1, "element", bs_value_num(bs_typed_array_load(src, i)));
+    }
+}
+
+static Bs_Value bs_f64_array_init(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_typed_array_init(bs, args, arity, BS_TYPED_F64);
+    return bs_value_nil;
+}
+
+static Bs_Value bs_f32_array_init(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_typed_array_init(bs, args, arity, BS_TYPED_F32);
+    return bs_value_nil;
+}
+
+static Bs_Value bs_i64_array_init(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_typed_array_init(bs, args, arity, BS_TYPED_I64);
+    return bs_value_nil;
+}
+
+static Bs_Value bs_i32_array_init(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_typed_array_init(bs, args, arity, BS_TYPED_I32);
+    return bs_value_nil;
+}
+
+static Bs_Value bs_u8_array_init(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_typed_array_init(bs, args, arity, BS_TYPED_U8);
+    return bs_value_nil;
+}
+
+static Bs_Value bs_typed_array_count(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+    return bs_value_num(bs_this_c_instance_data_as(args, Bs_Typed_Array).count);
+}
+
+static Bs_Value bs_typed_array_fill(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+
+    Bs_Typed_Array *a = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+    bs_typed_array_store(bs, a, 0, a->count, 1, NULL, args[0]);
+    return args[-1];
+}
+
+static Bs_Value bs_typed_array_copy(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+
+    const Bs_Typed_Array *src = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+    const Bs_Value        result = bs_typed_array_new(bs, src->kind);
+
+    Bs_Typed_Array *dst = bs_typed_array_of(result);
+    bs_typed_array_alloc(bs, dst, src->count);
+    memcpy(dst->data, src->data, src->count * bs_typed_kinds[src->kind].size);
+    return result;
+}
+
+static Bs_Value bs_typed_array_slice(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 1 && arity != 2) {
+        bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
+    }
+
+    bs_arg_check_whole_number(bs, args, 0);
+    if (arity == 2) {
+        bs_arg_check_whole_number(bs, args, 1);
+    }
+
+    const Bs_Typed_Array *src = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+    const size_t          begin = args[0].as.number;
+    const size_t          end = (arity == 2) ? args[1].as.number : src->count;
+
+    if (begin > end || end > src->count) {
+        bs_error(
+            bs,
+            "cannot slice %s of length %zu from %zu to %zu",
+            bs_typed_kinds[src->kind].name,
+            src->count,
+            begin,
+            end);
+    }
+
+    const Bs_Value result = bs_typed_array_new(bs, src->kind);
+
+    // Views share the data of the array which owns it, and keep it alive
+    Bs_Typed_Array *dst = bs_typed_array_of(result);
+    dst->data = (char *) src->data + begin * bs_typed_kinds[src->kind].size;
+    dst->count = end - begin;
+    dst->owner = src->bs ? args[-1] : src->owner;
+    return result;
+}
+
+static Bs_Value bs_typed_array_toarray(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+
+    const Bs_Typed_Array *src = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+
+    Bs_Array *dst = bs_array_new(bs);
+    for (size_t i = 0; i < src->count; i++) {
+        bs_array_set(bs, dst, i, bs_value_num(bs_typed_array_load(src, i)));
+    }
+    return bs_value_object(dst);
+}
+
+static Bs_Value bs_typed_array_add(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+
+    Bs_Typed_Array       *a = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+    const Bs_Typed_Array *b = bs_typed_array_check_same(bs, args, 0);
+
+#define F(T, U)                                                                                    \
+    do {                                                                                           \
+        T       *x = a->data;                                                                      \
+        const T *y = b->data;                                                                      \
+        for (size_t i = 0; i < a->count; i++) {                                                    \
+            x[i] = (T) ((U) x[i] + (U) y[i]);                                                      \
+        }                                                                                          \
+    } while (0)
+    bs_typed_array_switch(a->kind, F);
+#undef F
+
+    return args[-1];
+}
+
+static Bs_Value bs_typed_array_mul(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+
+    Bs_Typed_Array       *a = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+    const Bs_Typed_Array *b = bs_typed_array_check_same(bs, args, 0);
+
+#define F(T, U)                                                                                    \
+    do {                                                                                           \
+        T       *x = a->data;                                                                      \
+        const T *y = b->data;                                                                      \
+        for (size_t i = 0; i < a->count; i++) {                                                    \
+            x[i] = (T) ((U) x[i] * (U) y[i]);                                                      \
+        }                                                                                          \
+    } while (0)
+    bs_typed_array_switch(a->kind, F);
+#undef F
+
+    return args[-1];
+}
+
+static Bs_Value bs_typed_array_scale(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+
+    Bs_Typed_Array *a = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+
+    double   f = 0;
+    uint64_t n = 0;
+    bs_typed_array_convert(bs, a->kind, 1, NULL, args[0], &f, &n);
+
+#define F(T, U)                                                                                    \
+    do {                                                                                           \
+        T      *x = a->data;                                                                       \
+        const U k = bs_typed_kind_is_float(a->kind) ? (U) f : (U) n;                               \
+        for (size_t i = 0; i < a->count; i++) {                                                    \
+            x[i] = (T) ((U) x[i] * k);                                                             \
+        }                                                                                          \
+    } while (0)
+    bs_typed_array_switch(a->kind, F);
+#undef F
+
+    return args[-1];
+}
+
+static Bs_Value bs_typed_array_sum(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+
+    const Bs_Typed_Array *a = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+
+    double sum = 0;
+#define F(T, U)                                                                                    \
+    do {                                                                                           \
+        const T *x = a->data;                                                                      \
+        for (size_t i = 0; i < a->count; i++) {                                                    \
+            sum += x[i];                                                                           \
+        }                                                                                          \
+    } while (0)
+    bs_typed_array_switch(a->kind, F);
+#undef F
+
+    return bs_value_num(sum);
+}
+
+static Bs_Value bs_typed_array_dot(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+
+    const Bs_Typed_Array *a = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+    const Bs_Typed_Array *b = bs_typed_array_check_same(bs, args, 0);
+
+    double sum = 0;
+#define F(T, U)                                                                                    \
+    do {                                                                                           \
+        const T *x = a->data;                                                                      \
+        const T *y = b->data;                                                                      \
+        for (size_t i = 0; i < a->count; i++) {                                                    \
+            sum += (double) x[i] * (double) y[i];                                                  \
+        }                                                                                          \
+    } while (0)
+    bs_typed_array_switch(a->kind, F);
+#undef F
+
+    return bs_value_num(sum);
+}
+
+static Bs_Value bs_typed_array_extremum(Bs *bs, Bs_Value *args, size_t arity, bool max) {
+    bs_check_arity(bs, arity, 0);
+
+    const Bs_Typed_Array *a = &bs_this_c_instance_data_as(args, Bs_Typed_Array);
+    if (!a->count) {
+        return bs_value_nil;
+    }
+
+    double result = 0;
+#define F(T, U)                                                                                    \
+    do {                                                                                           \
+        const T *x = a->data;                                                                      \
+        T        m = x[0];                                                                         \
+        for (size_t i = 1; i < a->count; i++) {                                                    \
+            m = (max ? x[i] > m : x[i] < m) ? x[i] : m;                                            \
+        }                                                                                          \
+        result = m;                                                                                \
+    } while (0)
+    bs_typed_array_switch(a->kind, F);
+#undef F
+
+    return bs_value_num(result);
+}
+
+static Bs_Value bs_typed_array_min(Bs *bs, Bs_Value *args, size_t arity) {
+    return bs_typed_array_extremum(bs, args, arity, false);
+}
+
+static Bs_Value bs_typed_array_max(Bs *bs, Bs_Value *args, size_t arity) {
+    return bs_typed_array_extremum(bs, args, arity, true);
+}
+
+// Array
+static Bs_Value bs_array_map(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_callable(bs, args, 0);
+
+    const Bs_Array *src = (const Bs_Array *) args[-1].as.object;
+    const Bs_Call   fn = bs_call_prepare(bs, args[0], 1);
+    Bs_Array       *dst = bs_array_new(bs);
+
+    for (size_t i = 0; i < src->count; i++) {
+        const Bs_Value input = src->data[i];
+        const Bs_Value output = bs_call_invoke(&fn, &input);
+        bs_array_set(bs, dst, i, output);
+    }
+
+    return bs_value_object(dst);
+}
+
+static Bs_Value bs_array_filter(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_callable(bs, args, 0);
+
+    const Bs_Array *src = (const Bs_Array *) args[-1].as.object;
+    const Bs_Call   fn = bs_call_prepare(bs, args[0], 1);
+    Bs_Array       *dst = bs_array_new(bs);
+
+    for (size_t i = 0; i < src->count; i++) {
+        const Bs_Value input = src->data[i];
+        const Bs_Value output = bs_call_invoke(&fn, &input);
+
+        if (!bs_value_is_falsey(output)) {
+            bs_array_set(bs, dst, dst->count, input);
+        }
+    }
+
+    return bs_value_object(dst);
+}
+
+static Bs_Value bs_array_reduce(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 1 && arity != 2) {
+        bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
+    }
+
+    bs_arg_check_callable(bs, args, 0);
+
+    const Bs_Array *src = (const Bs_Array *) args[-1].as.object;
+    const Bs_Call   fn = bs_call_prepare(bs, args[0], 2);
+    Bs_Value        acc = arity == 2 ? args[1] : bs_value_nil;
+
+    for (size_t i = 0; i < src->count; i++) {
+        if (acc.type == BS_VALUE_NIL) {
+            acc = src->data[i];
+            continue;
+        }
+
+        const Bs_Value input[] = {acc, src->data[i]};
+        acc = bs_call_invoke(&fn, input);
+    }
+
+    return acc;
+}
+
+static Bs_Value bs_array_join(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_STR);
+
+    Bs_Buffer   *b = &bs_config(bs)->buffer;
+    const size_t start = b->count;
+    {
+        Bs_Writer w = bs_buffer_writer(b);
+
+        const Bs_Array *array = (const Bs_Array *) args[-1].as.object;
+        const Bs_Str   *str = (const Bs_Str *) args[0].as.object;
+        const Bs_Sv     separator = Bs_Sv(str->data, str->size);
+
+        for (size_t i = 0; i < array->count; i++) {
+            if (i) {
+                w.write(&w, separator);
+            }
+            bs_value_write(bs, &w, array->data[i]);
+        }
+    }
+    return bs_value_object(bs_str_new(bs, bs_buffer_reset(b, start)));
+}
+
+static Bs_Value bs_array_find(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 1 && arity != 2) {
+        bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
+    }
+
+    if (arity == 2) {
+        bs_arg_check_whole_number(bs, args, 1);
+    }
+
+    const Bs_Array *array = (const Bs_Array *) args[-1].as.object;
+    const Bs_Value  pred = args[0];
+    const size_t    offset = arity == 2 ? args[1].as.number : 0;
+
+    for (size_t i = offset; i < array->count; i++) {
+        if (bs_value_equal(array->data[i], pred)) {
+            return bs_value_num(i);
+        }
+    }
+
+    return bs_value_nil;
+}
+
+static Bs_Value bs_array_push(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    Bs_Array *a = (Bs_Array *) args[-1].as.object;
+    bs_array_set(bs, a, a->count, args[0]);
+    return args[-1];
+}
+
+static Bs_Value bs_array_insert(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 2);
+    bs_arg_check_whole_number(bs, args, 0);
+
+    Bs_Array      *a = (Bs_Array *) args[-1].as.object;
+    const size_t   index = args[0].as.number;
+    const Bs_Value value = args[1];
+
+    if (index < a->count) {
+        bs_array_set(bs, a, a->count, bs_value_nil);
+
+        for (size_t i = index; i + 1 < a->count; i++) {
+            a->data[i + 1] = a->data[i];
+        }
+
+        a->data[index] = value;
+    } else {
+        bs_array_set(bs, a, index, value);
+    }
+    return args[-1];
+}
+
+static Bs_Value bs_array_pop(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+    Bs_Array *a = (Bs_Array *) args[-1].as.object;
+    if (!a->count) {
+        bs_error(bs, "cannot pop from empty array");
+    }
+
+    return a->data[--a->count];
+}
+
+// Stable merge sort, with insertion sort for short ranges. Sorting happens in scratch arrays
+// allocated as handles, so the comparator is free to do anything with the array itself, including
+// sorting it again, and the array is only written back once everything succeeds. Resizing it is an
+// error though, see bs_array_sort_write()
+#define BS_ARRAY_SORT_RUN 16
+
+typedef enum {
+    BS_ARRAY_SORT_NUM,
+    BS_ARRAY_SORT_STR,
+    BS_ARRAY_SORT_CALL,
+} Bs_Array_Sort_Kind;
+
+typedef struct {
+    Bs_Call            fn;
+    Bs_Array_Sort_Kind kind;
+
+    // The keys decide the order. The values, if any, are carried along with their keys
+    Bs_Value *keys;
+    Bs_Value *keys_tmp;
+    Bs_Value *values;
+    Bs_Value *values_tmp;
+} Bs_Array_Sort;
+
+static bool bs_array_sort_less(Bs_Array_Sort *s, Bs_Value a, Bs_Value b) {
+    switch (s->kind) {
+    case BS_ARRAY_SORT_NUM:
+        return a.as.number < b.as.number;
+
+    case BS_ARRAY_SORT_STR: {
+        const Bs_Str *x = (const Bs_Str *) a.as.object;
+        const Bs_Str *y = (const Bs_Str *) b.as.object;
+
+        const int order = memcmp(x->data, y->data, bs_min(x->size, y->size));
+        return order ? order < 0 : x->size < y->size;
+    }
+
+    case BS_ARRAY_SORT_CALL: {
+        const Bs_Value args[] = {a, b};
+        return !bs_value_is_falsey(bs_call_invoke(&s->fn, args));
+    }
+    }
+
+    assert(false && "unreachable");
+}
+
+static void bs_array_sort_insertion(Bs_Array_Sort *s, size_t begin, size_t end) {
+    for (size_t i = begin + 1; i < end; i++) {
+        const Bs_Value key = s->keys[i];
+        const Bs_Value value = s->values ? s->values[i] : bs_value_nil;
+
+        size_t j = i;
+        while (j > begin && bs_array_sort_less(s, key, s->keys[j - 1])) {
+            s->keys[j] = s->keys[j - 1];
+            if (s->values) {
+                s->values[j] = s->values[j - 1];
+            }
+            j--;
+        }
+
+        s->keys[j] = key;
+        if (s->values) {
+            s->values[j] = value;
+        }
+    }
+}
+
+static void bs_array_sort_range(Bs_Array_Sort *s, size_t begin, size_t end) {
+    if (end - begin <= BS_ARRAY_SORT_RUN) {
+        bs_array_sort_insertion(s, begin, end);
+        return;
+    }
+
+    const size_t mid = begin + (end - begin) / 2;
+    bs_array_sort_range(s, begin, mid);
+    bs_array_sort_range(s, mid, end);
+
+    // Already in order, which makes sorted input linear
+    if (!bs_array_sort_less(s, s->keys[mid], s->keys[mid - 1])) {
+        return;
+    }
+
+    const size_t count = mid - begin;
+    memcpy(s->keys_tmp, &s->keys[begin], count * sizeof(*s->keys));
+    if (s->values) {
+        memcpy(s->values_tmp, &s->values[begin], count * sizeof(*s->values));
+    }
+
+    size_t i = 0;
+    size_t j = mid;
+    size_t k = begin;
+    while (i < count && j < end) {
+        // Only take from the right when strictly less, which keeps the sort stable
+        if (bs_array_sort_less(s, s->keys[j], s->keys_tmp[i])) {
+            s->keys[k] = s->keys[j];
+            if (s->values) {
+                s->values[k] = s->values[j];
+            }
+            j++;
+        } else {
+            s->keys[k] = s->keys_tmp[i];
+            if (s->values) {
+                s->values[k] = s->values_tmp[i];
+            }
+            i++;
+        }
+        k++;
+    }
+
+    memcpy(&s->keys[k], &s->keys_tmp[i], (count - i) * sizeof(*s->keys));
+    if (s->values) {
+        memcpy(&s->values[k], &s->values_tmp[i], (count - i) * sizeof(*s->values));
+    }
+}
+
+// Both arrays are handles, hence kept alive by the GC for as long as the native call lasts
+static Bs_Value *bs_array_sort_scratch(Bs *bs, const Bs_Value *data, size_t count) {
+    Bs_Array *a = bs_array_new(bs);
+    bs_array_set(bs, a, count - 1, bs_value_nil);
+    if (data) {
+        memcpy(a->data, data, count * sizeof(*data));
+    }
+    return a->data;
+}
+
+// The sorted elements are the ones the array had at the start, so writing them back over an array
+// which has since grown or shrunk would either lose elements or bring removed ones back
+static void bs_array_sort_write(Bs *bs, Bs_Array *src, const Bs_Value *data, size_t count) {
+    if (src->count != count) {
+        bs_error(bs, "array was resized during sort, from %zu to %zu", count, src->count);
+    }
+
+    memcpy(src->data, data, count * sizeof(*data));
+}
+
+// Without a compare function, the keys must be all numbers or all strings
+static Bs_Array_Sort_Kind
+bs_array_sort_kind(Bs *bs, const Bs_Value *keys, size_t count, const char *label) {
+    const Bs_Value first = keys[0];
+    if (first.type != BS_VALUE_NUM &&
+        (first.type != BS_VALUE_OBJECT || first.as.object->type != BS_OBJECT_STR)) {
+        const Bs_Sv sv = bs_value_type_name_full(first);
+        bs_error(bs, "cannot sort " Bs_Sv_Fmt " %s", Bs_Sv_Arg(sv), label);
+    }
+
+    for (size_t i = 1; i < count; i++) {
+        const Bs_Value key = keys[i];
+        if (key.type != first.type ||
+            (key.type == BS_VALUE_OBJECT && key.as.object->type != BS_OBJECT_STR)) {
+            const Bs_Sv a = bs_value_type_name_full(first);
+            const Bs_Sv b = bs_value_type_name_full(key);
+            bs_error(
+                bs,
+                "cannot sort " Bs_Sv_Fmt " and " Bs_Sv_Fmt " %s",
+                Bs_Sv_Arg(a),
+                Bs_Sv_Arg(b),
+                label);
+        }
+    }
+
+    return first.type == BS_VALUE_NUM ? BS_ARRAY_SORT_NUM : BS_ARRAY_SORT_STR;
+}
+
+static Bs_Value bs_array_sort(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity > 1) {
+        bs_error(bs, "expected 0 or 1 arguments, got %zu", arity);
+    }
+
+    if (arity == 1) {
+        bs_arg_check_callable(bs, args, 0);
+    }
+
+    Bs_Array    *src = (Bs_Array *) args[-1].as.object;
+    const size_t count = src->count;
+    if (count < 2) {
+        return args[-1];
+    }
+
+    Bs_Array_Sort s = {0};
+    if (arity == 1) {
+        s.fn = bs_call_prepare(bs, args[0], 2);
+        s.kind = BS_ARRAY_SORT_CALL;
+    } else {
+        s.kind = bs_array_sort_kind(bs, src->data, count, "without a compare function");
+    }
+
+    s.keys = bs_array_sort_scratch(bs, src->data, count);
+    s.keys_tmp = bs_array_sort_scratch(bs, NULL, count / 2);
+    bs_array_sort_range(&s, 0, count);
+
+    bs_array_sort_write(bs, src, s.keys, count);
+    return args[-1];
+}
+
+static Bs_Value bs_array_sort_by(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_callable(bs, args, 0);
+
+    Bs_Array    *src = (Bs_Array *) args[-1].as.object;
+    const size_t count = src->count;
+    if (count < 2) {
+        return args[-1];
+    }
+
+    Bs_Array_Sort s = {0};
+    s.values = bs_array_sort_scratch(bs, src->data, count);
+    s.values_tmp = bs_array_sort_scratch(bs, NULL, count / 2);
+    s.keys = bs_array_sort_scratch(bs, NULL, count);
+    s.keys_tmp = bs_array_sort_scratch(bs, NULL, count / 2);
+
+    const Bs_Call key = bs_call_prepare(bs, args[0], 1);
+    for (size_t i = 0; i < count; i++) {
+        s.keys[i] = bs_call_invoke(&key, &s.values[i]);
+    }
+
+    s.kind = bs_array_sort_kind(bs, s.keys, count, "keys");
+    bs_array_sort_range(&s, 0, count);
+
+    bs_array_sort_write(bs, src, s.values, count);
+    return args[-1];
+}
+
+static Bs_Value bs_array_resize(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_whole_number(bs, args, 0);
+
+    Bs_Array    *src = (Bs_Array *) args[-1].as.object;
+    const size_t size = args[0].as.number;
+    if (size > src->count) {
+        bs_array_set(bs, src, size - 1, bs_value_nil);
+    } else {
+        src->count = size;
+    }
+    return args[-1];
+}
+
+static Bs_Value bs_array_reverse(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+
+    Bs_Array *src = (Bs_Array *) args[-1].as.object;
+    for (size_t i = 0; i < src->count / 2; i++) {
+        const Bs_Value t = src->data[i];
+        src->data[i] = src->data[src->count - i - 1];
+        src->data[src->count - i - 1] = t;
+    }
+    return args[-1];
+}
+
+static Bs_Value bs_array_fill(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+
+    Bs_Array *src = (Bs_Array *) args[-1].as.object;
+    for (size_t i = 0; i < src->count; i++) {
+        src->data[i] = args[0];
+    }
+    return args[-1];
+}
+
+static Bs_Value bs_array_slice(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 1 && arity != 2) {
+        bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
+    }
+
+    bs_arg_check_whole_number(bs, args, 0);
+    if (arity == 2) {
+        bs_arg_check_whole_number(bs, args, 1);
     }
 
     const Bs_Array *src = (const Bs_Array *) args[-1].as.object;
     const size_t    begin = args[0].as.number;
     const size_t    end = (arity == 2) ? args[1].as.number : src->count;
 
-    Bs_Array *dst = bs_array_new(bs);
-    if (begin == end) {
-        return bs_value_object(dst);
+    Bs_Array *dst = bs_array_new(bs);
+    if (begin == end) {
+        return bs_value_object(dst);
+    }
+
+    if (begin >= src->count || end > src->count) {
+        bs_error(bs, "cannot slice array of length %zu from %zu to %zu", src->count, begin, end);
+    }
+
+    for (size_t i = begin; i < end; i++) {
+        bs_array_set(bs, dst, i - begin, src->data[i]);
+    }
+    return bs_value_object(dst);
+}
+
+static Bs_Value bs_array_append(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_ARRAY);
+
+    Bs_Array       *dst = (Bs_Array *) args[-1].as.object;
+    const Bs_Array *src = (const Bs_Array *) args[0].as.object;
+
+    for (size_t i = 0; i < src->count; i++) {
+        bs_array_set(bs, dst, dst->count, src->data[i]);
+    }
+    return args[-1];
+}
+
+// Table
+static Bs_Value bs_table_extend(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 2);
+    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_TABLE);
+    bs_arg_check_value_type(bs, args, 1, BS_VALUE_BOOL);
+
+    Bs_Table       *dst = (Bs_Table *) args[-1].as.object;
+    const Bs_Table *src = (const Bs_Table *) args[0].as.object;
+    const bool      overwrite = args[1].as.object;
+
+    for (size_t i = 0; i < src->map.capacity; i++) {
+        const Bs_Entry *entry = &src->map.data[i];
+        if (entry->key.type != BS_VALUE_NIL) {
+            if (bs_map_get(bs, &dst->map, entry->key, NULL) && !overwrite) {
+                continue;
+            }
+
+            bs_map_set(bs, &dst->map, entry->key, entry->value);
+        }
+    }
+
+    return args[-1];
+}
+
+// Iter
+//
+// Lazy iterators. Every stage pulls one value at a time from the one before it, so a pipeline like
+// `xs.iter().map(f).filter(g).take(n)` makes a single pass without any arrays in between, and stops
+// pulling as soon as the result is known
+typedef enum {
+    BS_ITERATOR_ARRAY,
+    BS_ITERATOR_STR,
+    BS_ITERATOR_ENTRIES,
+    BS_ITERATOR_RANGE,
+    BS_ITERATOR_LINES,
+    BS_ITERATOR_SPLIT,
+    BS_ITERATOR_JSON,
+
+    BS_ITERATOR_MAP,
+    BS_ITERATOR_FILTER,
+    BS_ITERATOR_TAKE,
+    BS_ITERATOR_SKIP,
+} Bs_Iterator_Kind;
+
+typedef struct {
+    Bs_Iterator_Kind kind;
+    bool             done;
+
+    // The container, or the iterator this stage pulls from
+    Bs_Value source;
+
+    // The function of a stage, or the separator of a split
+    Bs_Value arg;
+    Bs_Call  fn;
+
+    // The position in the container, the lines read so far, or the count left to take or skip
+    size_t cursor;
+
+    double position;
+    double end;
+    double step;
+} Bs_Iterator;
+
+static Bs_C_Class *bs_iterator_class;
+
+static void bs_iterator_mark(Bs *bs, void *instance_data) {
+    Bs_Iterator *it = &bs_flex_member_as(instance_data, Bs_Iterator);
+    bs_mark_value(bs, it->source);
+    bs_mark_value(bs, it->arg);
+}
+
+static bool bs_iterator_next(Bs *bs, void *instance_data, Bs_Value *value);
+
+static bool bs_iterator_pull(Bs *bs, Bs_Value source, Bs_Value *value) {
+    return bs_iterator_next(bs, ((Bs_C_Instance *) source.as.object)->data, value);
+}
+
+static Bs_Value bs_json_decode(Bs *bs, Bs_Sv input, size_t line);
+
+// Reads the next line into the config buffer, the caller resets it
+static bool bs_iterator_read_line(Bs *bs, Bs_Iterator *it, Bs_Sv *line) {
+    const Bs_File *f = &bs_flex_member_as(((Bs_C_Instance *) it->source.as.object)->data, Bs_File);
+    if (!f->file) {
+        bs_error(bs, "cannot read from closed file");
+    }
+
+    int c = fgetc(f->file);
+    if (c == EOF) {
+        it->done = true;
+        return false;
+    }
+
+    Bs_Buffer   *b = &bs_config(bs)->buffer;
+    const size_t start = b->count;
+    while (c != '\n' && c != EOF) {
+        bs_da_push(bs, b, c);
+        c = fgetc(f->file);
+    }
+
+    it->cursor++;
+    *line = Bs_Sv(b->data + start, b->count - start);
+    return true;
+}
+
+static bool bs_iterator_split(Bs *bs, Bs_Iterator *it, Bs_Value *value) {
+    const Bs_Str *str = (const Bs_Str *) it->source.as.object;
+    const size_t  j = it->cursor;
+
+    if (it->arg.as.object->type == BS_OBJECT_STR) {
+        const Bs_Str *pattern = (const Bs_Str *) it->arg.as.object;
+        if (!pattern->size) {
+            it->done = true;
+            *value = it->source;
+            return true;
+        }
+        size_t i;
+        if (bs_sv_find_sv(
+                Bs_Sv(str->data + j, str->size - j), Bs_Sv(pattern->data, pattern->size), &i)) {
+            it->cursor = j + i + pattern->size;
+            *value = bs_value_object(bs_str_new(bs, Bs_Sv(str->data + j, i)));
+            return true;
+        }
+    } else {
+        Bs_Regex_Span match;
+        if (bs_regex_find(bs_regex_of(it->arg), Bs_Sv(str->data, str->size), j, &match, 1) &&
+            match.begin != match.end) {
+            it->cursor = match.end;
+            *value = bs_value_object(bs_str_new(bs, Bs_Sv(str->data + j, match.begin - j)));
+            return true;
+        }
+    }
+
+    // The rest of the string, unless it is empty, just like str.split()
+    it->done = true;
+    if (j == str->size) {
+        return false;
+    }
+
+    *value = bs_value_object(bs_str_new(bs, Bs_Sv(str->data + j, str->size - j)));
+    return true;
+}
+
+static bool bs_iterator_next(Bs *bs, void *instance_data, Bs_Value *value) {
+    Bs_Iterator *it = &bs_flex_member_as(instance_data, Bs_Iterator);
+    if (it->done) {
+        return false;
+    }
+
+    switch (it->kind) {
+    case BS_ITERATOR_ARRAY: {
+        const Bs_Array *array = (const Bs_Array *) it->source.as.object;
+        if (it->cursor >= array->count) {
+            return false;
+        }
+
+        *value = array->data[it->cursor++];
+        return true;
+    }
+
+    case BS_ITERATOR_STR: {
+        const Bs_Str *str = (const Bs_Str *) it->source.as.object;
+        if (it->cursor >= str->size) {
+            return false;
+        }
+
+        *value = bs_value_object(bs_str_new(bs, Bs_Sv(&str->data[it->cursor++], 1)));
+        return true;
+    }
+
+    case BS_ITERATOR_ENTRIES: {
+        const Bs_Object *object = it->source.as.object;
+        const Bs_Map    *map = object->type == BS_OBJECT_TABLE
+                                   ? &((const Bs_Table *) object)->map
+                                   : &((const Bs_Instance *) object)->properties;
+
+        while (it->cursor < map->capacity && map->data[it->cursor].key.type == BS_VALUE_NIL) {
+            it->cursor++;
+        }
+
+        if (it->cursor >= map->capacity) {
+            return false;
+        }
+
+        const Bs_Entry entry = map->data[it->cursor++];
+
+        Bs_Array *pair = bs_array_new(bs);
+        bs_array_set(bs, pair, 0, entry.key);
+        bs_array_set(bs, pair, 1, entry.value);
+        *value = bs_value_object(pair);
+        return true;
+    }
+
+    case BS_ITERATOR_RANGE:
+        if (it->step > 0 ? it->position >= it->end : it->position <= it->end) {
+            return false;
+        }
+
+        *value = bs_value_num(it->position);
+        it->position += it->step;
+        return true;
+
+    case BS_ITERATOR_LINES: {
+        Bs_Sv line;
+        if (!bs_iterator_read_line(bs, it, &line)) {
+            return false;
+        }
+
+        Bs_Buffer *b = &bs_config(bs)->buffer;
+        *value = bs_value_object(bs_str_new(bs, bs_buffer_reset(b, line.data - b->data)));
+        return true;
+    }
+
+    case BS_ITERATOR_JSON: {
+        // The line is parsed where it was read, blank ones are skipped
+        Bs_Sv line;
+        while (bs_iterator_read_line(bs, it, &line)) {
+            Bs_Buffer   *b = &bs_config(bs)->buffer;
+            const size_t start = line.data - b->data;
+
+            size_t i = 0;
+            while (i < line.size && isspace((uint8_t) line.data[i])) {
+                i++;
+            }
+
+            const bool blank = i == line.size;
+            if (!blank) {
+                *value = bs_json_decode(bs, line, it->cursor);
+            }
+
+            bs_buffer_reset(b, start);
+            if (!blank) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    case BS_ITERATOR_SPLIT:
+        return bs_iterator_split(bs, it, value);
+
+    case BS_ITERATOR_MAP:
+        if (!bs_iterator_pull(bs, it->source, value)) {
+            return false;
+        }
+
+        *value = bs_call_invoke(&it->fn, value);
+        return true;
+
+    case BS_ITERATOR_FILTER:
+        while (bs_iterator_pull(bs, it->source, value)) {
+            if (!bs_value_is_falsey(bs_call_invoke(&it->fn, value))) {
+                return true;
+            }
+        }
+        return false;
+
+    case BS_ITERATOR_TAKE:
+        if (!it->cursor) {
+            it->done = true;
+            return false;
+        }
+
+        it->cursor--;
+        return bs_iterator_pull(bs, it->source, value);
+
+    case BS_ITERATOR_SKIP:
+        for (; it->cursor; it->cursor--) {
+            if (!bs_iterator_pull(bs, it->source, value)) {
+                return false;
+            }
+        }
+
+        return bs_iterator_pull(bs, it->source, value);
+    }
+
+    assert(false && "unreachable");
+}
+
+static Bs_Value bs_iterator_new(Bs *bs, Bs_Iterator_Kind kind, Bs_Value source, Bs_Value arg) {
+    Bs_C_Instance *instance = bs_c_instance_new(bs, bs_iterator_class);
+
+    Bs_Iterator *it = &bs_flex_member_as(instance->data, Bs_Iterator);
+    it->kind = kind;
+    it->source = source;
+    it->arg = arg;
+    it->fn = bs_call_prepare(bs, arg, 1);
+    return bs_value_object(instance);
+}
+
+// Shared with math.range()
+static double bs_range_step(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 2 && arity != 3) {
+        bs_error(bs, "expected 2 or 3 arguments, got %zu", arity);
+    }
+
+    bs_arg_check_value_type(bs, args, 0, BS_VALUE_NUM);
+    bs_arg_check_value_type(bs, args, 1, BS_VALUE_NUM);
+
+    const bool ascending = args[1].as.number > args[0].as.number;
+    if (arity == 2) {
+        return ascending ? 1 : -1;
+    }
+
+    bs_arg_check_value_type(bs, args, 2, BS_VALUE_NUM);
+    const double step = args[2].as.number;
+    if (step == 0 || ascending != (step > 0)) {
+        bs_error_at(
+            bs,
+            3,
+            "a step of %.15g in %s range would run indefinitely",
+            step,
+            ascending ? "an ascending" : "a descending");
+    }
+    return step;
+}
+
+static Bs_Value bs_iterator_init(Bs *bs, Bs_Value *args, size_t arity) {
+    Bs_Iterator *it = &bs_this_c_instance_data_as(args, Bs_Iterator);
+
+    if (arity != 1) {
+        it->kind = BS_ITERATOR_RANGE;
+        it->step = bs_range_step(bs, args, arity);
+        it->position = args[0].as.number;
+        it->end = args[1].as.number;
+        return bs_value_nil;
+    }
+
+    const Bs_Check checks[] = {
+        bs_check_object(BS_OBJECT_ARRAY),
+        bs_check_object(BS_OBJECT_STR),
+        bs_check_object(BS_OBJECT_TABLE),
+        bs_check_object(BS_OBJECT_INSTANCE),
+        bs_check_c_instance(bs_io_reader_class),
+        bs_check_c_instance(bs_iterator_class),
+    };
+    bs_arg_check_multi(bs, args, 0, checks, bs_c_array_size(checks));
+
+    it->source = args[0];
+    switch (args[0].as.object->type) {
+    case BS_OBJECT_ARRAY:
+        it->kind = BS_ITERATOR_ARRAY;
+        break;
+
+    case BS_OBJECT_STR:
+        it->kind = BS_ITERATOR_STR;
+        break;
+
+    case BS_OBJECT_TABLE:
+    case BS_OBJECT_INSTANCE:
+        it->kind = BS_ITERATOR_ENTRIES;
+        break;
+
+    default:
+        if (((const Bs_C_Instance *) args[0].as.object)->class == bs_io_reader_class) {
+            it->kind = BS_ITERATOR_LINES;
+        } else {
+            // Skipping nothing simply passes the values through
+            it->kind = BS_ITERATOR_SKIP;
+        }
+        break;
+    }
+
+    return bs_value_nil;
+}
+
+static Bs_Value bs_iterator_map(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_callable(bs, args, 0);
+    return bs_iterator_new(bs, BS_ITERATOR_MAP, args[-1], args[0]);
+}
+
+static Bs_Value bs_iterator_filter(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_callable(bs, args, 0);
+    return bs_iterator_new(bs, BS_ITERATOR_FILTER, args[-1], args[0]);
+}
+
+static Bs_Value bs_iterator_take(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_whole_number(bs, args, 0);
+
+    const Bs_Value result = bs_iterator_new(bs, BS_ITERATOR_TAKE, args[-1], bs_value_nil);
+    bs_flex_member_as(((Bs_C_Instance *) result.as.object)->data, Bs_Iterator).cursor =
+        args[0].as.number;
+    return result;
+}
+
+static Bs_Value bs_iterator_skip(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_whole_number(bs, args, 0);
+
+    const Bs_Value result = bs_iterator_new(bs, BS_ITERATOR_SKIP, args[-1], bs_value_nil);
+    bs_flex_member_as(((Bs_C_Instance *) result.as.object)->data, Bs_Iterator).cursor =
+        args[0].as.number;
+    return result;
+}
+
+static Bs_Value bs_iterator_next_method(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+
+    Bs_Value value;
+    if (!bs_iterator_pull(bs, args[-1], &value)) {
+        return bs_value_nil;
+    }
+    return value;
+}
+
+static Bs_Value bs_iterator_collect(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+
+    Bs_Array *dst = bs_array_new(bs);
+
+    Bs_Value value;
+    while (bs_iterator_pull(bs, args[-1], &value)) {
+        bs_array_set(bs, dst, dst->count, value);
+    }
+    return bs_value_object(dst);
+}
+
+static Bs_Value bs_iterator_reduce(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 1 && arity != 2) {
+        bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
+    }
+
+    bs_arg_check_callable(bs, args, 0);
+
+    const Bs_Call fn = bs_call_prepare(bs, args[0], 2);
+    Bs_Value      acc = arity == 2 ? args[1] : bs_value_nil;
+
+    Bs_Value value;
+    while (bs_iterator_pull(bs, args[-1], &value)) {
+        if (acc.type == BS_VALUE_NIL) {
+            acc = value;
+            continue;
+        }
+
+        const Bs_Value input[] = {acc, value};
+        acc = bs_call_invoke(&fn, input);
+    }
+
+    return acc;
+}
+
+static Bs_Value bs_iterator_count(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+
+    size_t   count = 0;
+    Bs_Value value;
+    while (bs_iterator_pull(bs, args[-1], &value)) {
+        count++;
+    }
+    return bs_value_num(count);
+}
+
+static Bs_Value bs_array_iter(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+    return bs_iterator_new(bs, BS_ITERATOR_ARRAY, args[-1], bs_value_nil);
+}
+
+static Bs_Value bs_table_iter(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+    return bs_iterator_new(bs, BS_ITERATOR_ENTRIES, args[-1], bs_value_nil);
+}
+
+static Bs_Value bs_str_split_iter(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+
+    const Bs_Check checks[] = {
+        bs_check_object(BS_OBJECT_STR),
+        bs_check_c_instance(bs_regex_class),
+    };
+    bs_arg_check_multi(bs, args, 0, checks, bs_c_array_size(checks));
+    return bs_iterator_new(bs, BS_ITERATOR_SPLIT, args[-1], args[0]);
+}
+
+static Bs_Value bs_io_reader_lines(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+    return bs_iterator_new(bs, BS_ITERATOR_LINES, args[-1], bs_value_nil);
+}
+
+// JSON
+//
+// Raises the error with the position in terms of the input, which starts at the given line
+static Bs_Value bs_json_decode(Bs *bs, Bs_Sv input, size_t line) {
+    Bs_Value      value;
+    Bs_Json_Error error;
+    if (bs_json_parse(bs, input, &value, &error)) {
+        return value;
+    }
+
+    size_t row = line;
+    size_t col = 1;
+    for (size_t i = 0; i < error.offset; i++) {
+        if (input.data[i] == '\n') {
+            row++;
+            col = 1;
+        } else {
+            col++;
+        }
     }
 
-    if (begin >= src->count || end > src->count) {
-        bs_error(bs, "cannot slice array of length %zu from %zu to %zu", src->count, begin, end);
+    bs_error(bs, "invalid JSON at %zu:%zu: %s", row, col, error.message);
+    return bs_value_nil;
+}
+
+static size_t bs_json_indent(Bs *bs, Bs_Value *args, size_t arity, size_t index) {
+    if (arity <= index) {
+        return 0;
     }
 
-    for (size_t i = begin; i < end; i++) {
-        bs_array_set(bs, dst, i - begin, src->data[i]);
+    bs_arg_check_whole_number(bs, args, index);
+    return args[index].as.number;
+}
+
+static Bs_Value bs_json_parse_fn(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_STR);
+
+    const Bs_Str *str = (const Bs_Str *) args[0].as.object;
+    return bs_json_decode(bs, Bs_Sv(str->data, str->size), 1);
+}
+
+static Bs_Value bs_json_stringify(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 1 && arity != 2) {
+        bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
     }
-    return bs_value_object(dst);
+
+    const size_t indent = bs_json_indent(bs, args, arity, 1);
+
+    Bs_Buffer   *b = &bs_config(bs)->buffer;
+    const size_t start = b->count;
+    {
+        Bs_Writer w = bs_buffer_writer(b);
+        bs_json_write(bs, &w, args[0], indent);
+    }
+    return bs_value_object(bs_str_new(bs, bs_buffer_reset(b, start)));
 }
 
-static Bs_Value bs_array_append(Bs *bs, Bs_Value *args, size_t arity) {
+static Bs_Value bs_json_write_fn(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 2 && arity != 3) {
+        bs_error(bs, "expected 2 or 3 arguments, got %zu", arity);
+    }
+
+    const Bs_Check check = bs_check_c_instance(bs_io_writer_class);
+    bs_arg_check_multi(bs, args, 0, &check, 1);
+
+    const size_t indent = bs_json_indent(bs, args, arity, 2);
+
+    Bs_File *f = &bs_flex_member_as(((Bs_C_Instance *) args[0].as.object)->data, Bs_File);
+    if (!f->file) {
+        bs_error(bs, "cannot write into closed file");
+    }
+
+    // Straight into the file, without building the whole text first
+    Bs_Writer w = bs_file_writer(f->file);
+    bs_json_write(bs, &w, args[1], indent);
+    bs_fmt(&w, "\n");
+
+    return bs_value_bool(!ferror(f->file));
+}
+
+static Bs_Value bs_json_lines(Bs *bs, Bs_Value *args, size_t arity) {
     bs_check_arity(bs, arity, 1);
-    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_ARRAY);
 
-    Bs_Array       *dst = (Bs_Array *) args[-1].as.object;
-    const Bs_Array *src = (const Bs_Array *) args[0].as.object;
+    const Bs_Check check = bs_check_c_instance(bs_io_reader_class);
+    bs_arg_check_multi(bs, args, 0, &check, 1);
+    return bs_iterator_new(bs, BS_ITERATOR_JSON, args[0], bs_value_nil);
+}
 
-    for (size_t i = 0; i < src->count; i++) {
-        bs_array_set(bs, dst, dst->count, src->data[i]);
+// CSV
+//
+// Records are read from the file in large chunks and split in place, so a field only becomes a
+// value if it ends up in the row. Quoted fields follow RFC 4180, they may contain the delimiter,
+// newlines and doubled quotes
+#define BS_CSV_CHUNK (64 * 1024)
+
+// The slot of a column which is not part of the row
+#define BS_CSV_DROP SIZE_MAX
+
+typedef struct {
+    Bs_Value file;
+
+    char delimiter;
+    bool numbers;
+
+    // The row handed out every time, if it is reused
+    bool      reuse;
+    Bs_Array *row;
+
+    // Where each column goes in the row, NULL if the row has all of them
+    size_t *slots;
+    size_t  slots_count;
+    size_t  width;
+
+    // What has been read so far, the next record starts at the cursor. There is always a byte to
+    // spare past the end, so that a field can be terminated in place
+    Bs_Buffer input;
+    size_t    cursor;
+    bool      eof;
+
+    size_t line;
+} Bs_Csv;
+
+static Bs_C_Class *bs_csv_reader_class;
+
+static void bs_csv_reader_free(void *userdata, void *instance_data) {
+    Bs_Csv *c = &bs_flex_member_as(instance_data, Bs_Csv);
+    if (c->input.bs) {
+        bs_realloc(c->input.bs, c->slots, c->slots_count * sizeof(*c->slots), 0);
+        bs_da_free(c->input.bs, &c->input);
     }
-    return args[-1];
 }
 
-// Table
-static Bs_Value bs_table_extend(Bs *bs, Bs_Value *args, size_t arity) {
-    bs_check_arity(bs, arity, 2);
-    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_TABLE);
-    bs_arg_check_value_type(bs, args, 1, BS_VALUE_BOOL);
+static void bs_csv_reader_mark(Bs *bs, void *instance_data) {
+    Bs_Csv *c = &bs_flex_member_as(instance_data, Bs_Csv);
+    bs_mark_value(bs, c->file);
+    bs_mark(bs, (Bs_Object *) c->row);
+}
 
-    Bs_Table       *dst = (Bs_Table *) args[-1].as.object;
-    const Bs_Table *src = (const Bs_Table *) args[0].as.object;
-    const bool      overwrite = args[1].as.object;
+static Bs_Value bs_csv_option(Bs *bs, Bs_Table *options, const char *name) {
+    Bs_Value value = bs_value_nil;
+    bs_table_get(bs, options, bs_value_object(bs_str_new(bs, bs_sv_from_cstr(name))), &value);
+    return value;
+}
 
-    for (size_t i = 0; i < src->map.capacity; i++) {
-        const Bs_Entry *entry = &src->map.data[i];
-        if (entry->key.type != BS_VALUE_NIL) {
-            if (bs_map_get(bs, &dst->map, entry->key, NULL) && !overwrite) {
-                continue;
+static void bs_csv_reader_columns(Bs *bs, Bs_Csv *c, const Bs_Array *columns) {
+    for (size_t i = 0; i < columns->count; i++) {
+        bs_check_whole_number_at(bs, 2, columns->data[i], "column");
+        c->slots_count = bs_max(c->slots_count, (size_t) columns->data[i].as.number + 1);
+    }
+
+    c->slots = bs_realloc(bs, NULL, 0, c->slots_count * sizeof(*c->slots));
+    for (size_t i = 0; i < c->slots_count; i++) {
+        c->slots[i] = BS_CSV_DROP;
+    }
+
+    for (size_t i = 0; i < columns->count; i++) {
+        const size_t column = columns->data[i].as.number;
+        if (c->slots[column] != BS_CSV_DROP) {
+            bs_error_at(bs, 2, "duplicate column %zu", column);
+        }
+        c->slots[column] = i;
+    }
+
+    c->width = columns->count;
+}
+
+static Bs_Value bs_csv_reader_init(Bs *bs, Bs_Value *args, size_t arity) {
+    if (arity != 1 && arity != 2) {
+        bs_error(bs, "expected 1 or 2 arguments, got %zu", arity);
+    }
+
+    const Bs_Check check = bs_check_c_instance(bs_io_reader_class);
+    bs_arg_check_multi(bs, args, 0, &check, 1);
+
+    Bs_Csv *c = &bs_this_c_instance_data_as(args, Bs_Csv);
+    c->file = args[0];
+    c->delimiter = ',';
+    c->input.bs = bs;
+
+    if (arity == 2) {
+        bs_arg_check_object_type(bs, args, 1, BS_OBJECT_TABLE);
+        Bs_Table *options = (Bs_Table *) args[1].as.object;
+
+        const Bs_Value delimiter = bs_csv_option(bs, options, "delimiter");
+        if (delimiter.type != BS_VALUE_NIL) {
+            bs_check_object_type_at(bs, 2, delimiter, BS_OBJECT_STR, "delimiter");
+
+            const Bs_Str *str = (const Bs_Str *) delimiter.as.object;
+            if (str->size != 1 || *str->data == '"' || *str->data == '\n' || *str->data == '\r') {
+                bs_error_at(bs, 2, "expected delimiter to be a single character other than a quote or a newline");
             }
+            c->delimiter = *str->data;
+        }
 
-            bs_map_set(bs, &dst->map, entry->key, entry->value);
+        const Bs_Value columns = bs_csv_option(bs, options, "columns");
+        if (columns.type != BS_VALUE_NIL) {
+            bs_check_object_type_at(bs, 2, columns, BS_OBJECT_ARRAY, "columns");
+            bs_csv_reader_columns(bs, c, (const Bs_Array *) columns.as.object);
+        }
+
+        const Bs_Value numbers = bs_csv_option(bs, options, "numbers");
+        if (numbers.type != BS_VALUE_NIL) {
+            bs_check_value_type_at(bs, 2, numbers, BS_VALUE_BOOL, "numbers");
+            c->numbers = numbers.as.boolean;
+        }
+
+        const Bs_Value reuse = bs_csv_option(bs, options, "reuse");
+        if (reuse.type != BS_VALUE_NIL) {
+            bs_check_value_type_at(bs, 2, reuse, BS_VALUE_BOOL, "reuse");
+            c->reuse = reuse.as.boolean;
         }
     }
 
-    return args[-1];
+    return bs_value_nil;
+}
+
+// Buffers a whole record, and finds where it ends. Newlines only end a record outside of quotes,
+// which is the case when the quotes before them are balanced
+static bool bs_csv_record(Bs *bs, Bs_Csv *c, size_t *end, size_t *newlines) {
+    size_t scan = c->cursor;
+    size_t quotes = 0;
+    *newlines = 0;
+
+    while (true) {
+        const char *data = c->input.data;
+        while (scan < c->input.count) {
+            const char  *newline = memchr(data + scan, '\n', c->input.count - scan);
+            const size_t stop = newline ? (size_t) (newline - data) : c->input.count;
+
+            for (const char *q = data + scan; (q = memchr(q, '"', data + stop - q)); q++) {
+                quotes++;
+            }
+
+            scan = stop;
+            if (!newline) {
+                break;
+            }
+
+            if (quotes % 2 == 0) {
+                *end = stop;
+                return true;
+            }
+
+            scan++;
+            (*newlines)++;
+        }
+
+        if (c->eof) {
+            *end = c->input.count;
+            return c->cursor < c->input.count;
+        }
+
+        // Drop what has been consumed, and read some more
+        const Bs_File *f = &bs_flex_member_as(((Bs_C_Instance *) c->file.as.object)->data, Bs_File);
+        if (!f->file) {
+            bs_error(bs, "cannot read from closed file");
+        }
+
+        if (c->cursor) {
+            c->input.count -= c->cursor;
+            memmove(c->input.data, c->input.data + c->cursor, c->input.count);
+            scan -= c->cursor;
+            c->cursor = 0;
+        }
+
+        bs_da_push_many(bs, &c->input, NULL, BS_CSV_CHUNK);
+
+        const size_t count = fread(
+            c->input.data + c->input.count,
+            sizeof(char),
+            c->input.capacity - c->input.count - 1,
+            f->file);
+
+        if (!count) {
+            if (ferror(f->file)) {
+                bs_error(bs, "could not read CSV file");
+            }
+            c->eof = true;
+        }
+        c->input.count += count;
+    }
+}
+
+// Fields which string.tonumber() accepts become numbers, if asked for
+static Bs_Value bs_csv_value(Bs *bs, Bs_Csv *c, char *begin, char *end) {
+    if (c->numbers && begin != end) {
+        // Plain integers are exact in a double up to 15 digits
+        const char *p = begin + (*begin == '-');
+        if (p != end && end - p <= 15) {
+            uint64_t n = 0;
+            for (; p < end && *p >= '0' && *p <= '9'; p++) {
+                n = n * 10 + (*p - '0');
+            }
+
+            if (p == end) {
+                return bs_value_num(*begin == '-' ? -(double) n : (double) n);
+            }
+        }
+
+        const char save = *end;
+        *end = '\0';
+
+        char *stop;
+        errno = 0;
+        const double value = strtod(begin, &stop);
+
+        *end = save;
+        if (stop == end && errno != ERANGE) {
+            return bs_value_num(value);
+        }
+    }
+
+    return bs_value_object(bs_str_new(bs, Bs_Sv(begin, end - begin)));
+}
+
+// The contents of a quoted field which has doubled quotes in it
+static Bs_Value bs_csv_unquote(Bs *bs, const char *begin, const char *end) {
+    Bs_Buffer   *b = &bs_config(bs)->buffer;
+    const size_t start = b->count;
+
+    for (const char *q; (q = memchr(begin, '"', end - begin)); begin = q + 2) {
+        bs_da_push_many(bs, b, begin, q + 1 - begin);
+    }
+    bs_da_push_many(bs, b, begin, end - begin);
+
+    return bs_value_object(bs_str_new(bs, bs_buffer_reset(b, start)));
+}
+
+static bool bs_csv_reader_next(Bs *bs, void *instance_data, Bs_Value *value) {
+    Bs_Csv *c = &bs_flex_member_as(instance_data, Bs_Csv);
+
+    // Blank lines are skipped
+    size_t end;
+    size_t newlines;
+    char  *p;
+    char  *stop;
+    do {
+        if (!bs_csv_record(bs, c, &end, &newlines)) {
+            return false;
+        }
+
+        p = c->input.data + c->cursor;
+        stop = c->input.data + end;
+        if (stop > p && stop[-1] == '\r') {
+            stop--;
+        }
+
+        c->line += newlines + 1;
+        c->cursor = bs_min(end + 1, c->input.count);
+    } while (p == stop);
+
+    const size_t line = c->line - newlines;
+
+    Bs_Array *row = c->reuse ? c->row : NULL;
+    if (!row) {
+        row = bs_array_new(bs);
+        if (c->reuse) {
+            c->row = row;
+        }
+    }
+
+    row->count = 0;
+    for (size_t i = 0; i < c->width; i++) {
+        bs_array_set(bs, row, i, bs_value_nil);
+    }
+
+    for (size_t column = 0;; column++) {
+        size_t slot = column;
+        if (c->slots) {
+            if (column >= c->slots_count) {
+                break;
+            }
+            slot = c->slots[column];
+        }
+
+        Bs_Value field = bs_value_nil;
+        if (p < stop && *p == '"') {
+            const char *begin = p + 1;
+            const char *q = begin;
+            bool        doubled = false;
+            while (true) {
+                q = memchr(q, '"', stop - q);
+                if (!q) {
+                    bs_error(bs, "invalid CSV on line %zu: unterminated quoted field", line);
+                }
+
+                if (q + 1 < stop && q[1] == '"') {
+                    doubled = true;
+                    q += 2;
+                    continue;
+                }
+                break;
+            }
+
+            p = (char *) q + 1;
+            if (p < stop && *p != c->delimiter) {
+                bs_error(bs, "invalid CSV on line %zu: expected delimiter after quoted field", line);
+            }
+
+            if (slot != BS_CSV_DROP) {
+                field = doubled ? bs_csv_unquote(bs, begin, q)
+                                : bs_value_object(bs_str_new(bs, Bs_Sv(begin, q - begin)));
+            }
+        } else {
+            char *field_end = memchr(p, c->delimiter, stop - p);
+            if (!field_end) {
+                field_end = stop;
+            }
+
+            if (slot != BS_CSV_DROP) {
+                field = bs_csv_value(bs, c, p, field_end);
+            }
+            p = field_end;
+        }
+
+        if (slot != BS_CSV_DROP) {
+            bs_array_set(bs, row, slot, field);
+        }
+
+        if (p == stop) {
+            break;
+        }
+        p++;
+    }
+
+    *value = bs_value_object(row);
+    return true;
+}
+
+static Bs_Value bs_csv_reader_next_method(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 0);
+
+    Bs_Value value;
+    if (!bs_csv_reader_next(bs, ((Bs_C_Instance *) args[-1].as.object)->data, &value)) {
+        return bs_value_nil;
+    }
+    return value;
 }
 
 // Math
@@ -2207,33 +4247,12 @@ static Bs_Value bs_math_sign(Bs *bs, Bs_Value *args, size_t arity) {
 }
 
 static Bs_Value bs_math_range(Bs *bs, Bs_Value *args, size_t arity) {
-    if (arity != 2 && arity != 3) {
-        bs_error(bs, "expected 2 or 3 arguments, got %zu", arity);
-    }
-
-    bs_arg_check_value_type(bs, args, 0, BS_VALUE_NUM);
-    bs_arg_check_value_type(bs, args, 1, BS_VALUE_NUM);
-
+    const double step = bs_range_step(bs, args, arity);
     const double begin = args[0].as.number;
     const double end = args[1].as.number;
 
-    const bool ascending = end > begin;
-    double     step = ascending ? 1 : -1;
-    if (arity == 3) {
-        bs_arg_check_value_type(bs, args, 2, BS_VALUE_NUM);
-        step = args[2].as.number;
-        if (step == 0 || ascending != step > 0) {
-            bs_error_at(
-                bs,
-                3,
-                "a step of %.15g in %s range would run indefinitely",
-                step,
-                ascending ? "an ascending" : "a descending");
-        }
-    }
-
     Bs_Array *a = bs_array_new(bs);
-    for (double i = begin; ascending ? (i < end) : (i > end); i += step) {
+    for (double i = begin; step > 0 ? (i < end) : (i > end); i += step) {
         bs_array_set(bs, a, a->count, bs_value_num(i));
     }
     return bs_value_object(a);
@@ -2621,6 +4640,32 @@ static Bs_Value bs_meta_eval(Bs *bs, Bs_Value *args, size_t arity) {
     return bs_call(bs, bs_value_object(closure), NULL, 0);
 }
 
+static Bs_Value bs_meta_serialize(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+
+    Bs_Buffer   *b = &bs_config(bs)->buffer;
+    const size_t start = b->count;
+    {
+        Bs_Writer w = bs_buffer_writer(b);
+        bs_serialize(bs, &w, args[0]);
+    }
+    return bs_value_object(bs_str_new(bs, bs_buffer_reset(b, start)));
+}
+
+static Bs_Value bs_meta_deserialize(Bs *bs, Bs_Value *args, size_t arity) {
+    bs_check_arity(bs, arity, 1);
+    bs_arg_check_object_type(bs, args, 0, BS_OBJECT_STR);
+
+    const Bs_Str *str = (const Bs_Str *) args[0].as.object;
+
+    Bs_Value        value;
+    Bs_Serial_Error error;
+    if (!bs_deserialize(bs, Bs_Sv(str->data, str->size), &value, &error)) {
+        bs_error(bs, "invalid serialized data at offset %zu: %s", error.offset, error.message);
+    }
+    return value;
+}
+
 // Main
 static void bs_add(Bs *bs, Bs_Table *table, const char *key, Bs_Value value) {
     bs_table_set(bs, table, bs_value_object(bs_str_new(bs, bs_sv_from_cstr(key))), value);
@@ -2644,6 +4689,7 @@ void bs_core_init(Bs *bs, int argc, char **argv) {
         bs_c_class_add(bs, bs_io_reader_class, Bs_Sv_Static("close"), bs_io_file_close);
         bs_c_class_add(bs, bs_io_reader_class, Bs_Sv_Static("read"), bs_io_reader_read);
         bs_c_class_add(bs, bs_io_reader_class, Bs_Sv_Static("readln"), bs_io_reader_readln);
+        bs_c_class_add(bs, bs_io_reader_class, Bs_Sv_Static("lines"), bs_io_reader_lines);
 
         bs_c_class_add(bs, bs_io_reader_class, Bs_Sv_Static("eof"), bs_io_reader_eof);
         bs_c_class_add(bs, bs_io_reader_class, Bs_Sv_Static("seek"), bs_io_reader_seek);
@@ -2762,9 +4808,11 @@ void bs_core_init(Bs *bs, int argc, char **argv) {
     }
 
     {
-        bs_regex_class = bs_c_class_new(bs, Bs_Sv_Static("Regex"), sizeof(Bs_Regex), bs_regex_init);
+        bs_regex_class = bs_c_class_new(
+            bs, Bs_Sv_Static("Regex"), sizeof(Bs_Regex_Instance), bs_regex_instance_init);
         bs_regex_class->can_fail = true;
-        bs_regex_class->free = bs_regex_free;
+        bs_regex_class->free = bs_regex_instance_free;
+        bs_regex_class->mark = bs_regex_instance_mark;
 
         bs_global_set(bs, Bs_Sv_Static("Regex"), bs_value_object(bs_regex_class));
     }
@@ -2780,6 +4828,8 @@ void bs_core_init(Bs *bs, int argc, char **argv) {
 
         bs_builtin_object_methods_add(bs, BS_OBJECT_STR, Bs_Sv_Static("find"), bs_str_find);
         bs_builtin_object_methods_add(bs, BS_OBJECT_STR, Bs_Sv_Static("split"), bs_str_split);
+        bs_builtin_object_methods_add(
+            bs, BS_OBJECT_STR, Bs_Sv_Static("split_iter"), bs_str_split_iter);
         bs_builtin_object_methods_add(bs, BS_OBJECT_STR, Bs_Sv_Static("replace"), bs_str_replace);
 
         bs_builtin_object_methods_add(bs, BS_OBJECT_STR, Bs_Sv_Static("compare"), bs_str_compare);
@@ -2834,13 +4884,84 @@ void bs_core_init(Bs *bs, int argc, char **argv) {
         bs_c_class_add(bs, bs_bytes_class, Bs_Sv_Static("get"), bs_bytes_get);
         bs_c_class_add(bs, bs_bytes_class, Bs_Sv_Static("set"), bs_bytes_set);
 
+        bs_c_class_add(bs, bs_bytes_class, Bs_Sv_Static("read"), bs_bytes_read);
+        bs_c_class_add(bs, bs_bytes_class, Bs_Sv_Static("write"), bs_bytes_write);
+        bs_c_class_add(bs, bs_bytes_class, Bs_Sv_Static("pack"), bs_bytes_pack);
+        bs_c_class_add(bs, bs_bytes_class, Bs_Sv_Static("unpack"), bs_bytes_unpack);
+
+        bs_c_class_add(bs, bs_bytes_class, Bs_Sv_Static("append"), bs_bytes_append);
+        bs_c_class_add(bs, bs_bytes_class, Bs_Sv_Static("find"), bs_bytes_find);
+        bs_c_class_add(bs, bs_bytes_class, Bs_Sv_Static("compare"), bs_bytes_compare);
+
         bs_global_set(bs, Bs_Sv_Static("Bytes"), bs_value_object(bs_bytes_class));
     }
 
+    {
+        static const Bs_C_Fn_Ptr inits[BS_COUNT_TYPED] = {
+            [BS_TYPED_F64] = bs_f64_array_init,
+            [BS_TYPED_F32] = bs_f32_array_init,
+            [BS_TYPED_I64] = bs_i64_array_init,
+            [BS_TYPED_I32] = bs_i32_array_init,
+            [BS_TYPED_U8] = bs_u8_array_init,
+        };
+
+        for (Bs_Typed_Kind kind = 0; kind < BS_COUNT_TYPED; kind++) {
+            const Bs_Sv name = bs_sv_from_cstr(bs_typed_kinds[kind].name);
+
+            Bs_C_Class *class = bs_c_class_new(bs, name, sizeof(Bs_Typed_Array), inits[kind]);
+            bs_typed_array_classes[kind] = class;
+
+            class->free = bs_typed_array_free;
+            class->mark = bs_typed_array_mark;
+            class->show = bs_typed_array_show;
+            class->count = bs_typed_array_count_hook;
+            class->get = bs_typed_array_get_hook;
+            class->set = bs_typed_array_set_hook;
+
+            bs_c_class_add(bs, class, Bs_Sv_Static("count"), bs_typed_array_count);
+            bs_c_class_add(bs, class, Bs_Sv_Static("fill"), bs_typed_array_fill);
+            bs_c_class_add(bs, class, Bs_Sv_Static("copy"), bs_typed_array_copy);
+            bs_c_class_add(bs, class, Bs_Sv_Static("slice"), bs_typed_array_slice);
+            bs_c_class_add(bs, class, Bs_Sv_Static("toarray"), bs_typed_array_toarray);
+
+            bs_c_class_add(bs, class, Bs_Sv_Static("add"), bs_typed_array_add);
+            bs_c_class_add(bs, class, Bs_Sv_Static("mul"), bs_typed_array_mul);
+            bs_c_class_add(bs, class, Bs_Sv_Static("scale"), bs_typed_array_scale);
+
+            bs_c_class_add(bs, class, Bs_Sv_Static("sum"), bs_typed_array_sum);
+            bs_c_class_add(bs, class, Bs_Sv_Static("dot"), bs_typed_array_dot);
+            bs_c_class_add(bs, class, Bs_Sv_Static("min"), bs_typed_array_min);
+            bs_c_class_add(bs, class, Bs_Sv_Static("max"), bs_typed_array_max);
+
+            bs_global_set(bs, name, bs_value_object(class));
+        }
+    }
+
+    {
+        bs_iterator_class =
+            bs_c_class_new(bs, Bs_Sv_Static("Iter"), sizeof(Bs_Iterator), bs_iterator_init);
+
+        bs_iterator_class->mark = bs_iterator_mark;
+        bs_iterator_class->next = bs_iterator_next;
+
+        bs_c_class_add(bs, bs_iterator_class, Bs_Sv_Static("map"), bs_iterator_map);
+        bs_c_class_add(bs, bs_iterator_class, Bs_Sv_Static("filter"), bs_iterator_filter);
+        bs_c_class_add(bs, bs_iterator_class, Bs_Sv_Static("take"), bs_iterator_take);
+        bs_c_class_add(bs, bs_iterator_class, Bs_Sv_Static("skip"), bs_iterator_skip);
+
+        bs_c_class_add(bs, bs_iterator_class, Bs_Sv_Static("next"), bs_iterator_next_method);
+        bs_c_class_add(bs, bs_iterator_class, Bs_Sv_Static("collect"), bs_iterator_collect);
+        bs_c_class_add(bs, bs_iterator_class, Bs_Sv_Static("reduce"), bs_iterator_reduce);
+        bs_c_class_add(bs, bs_iterator_class, Bs_Sv_Static("count"), bs_iterator_count);
+
+        bs_global_set(bs, Bs_Sv_Static("Iter"), bs_value_object(bs_iterator_class));
+    }
+
     {
         bs_builtin_object_methods_add(bs, BS_OBJECT_ARRAY, Bs_Sv_Static("map"), bs_array_map);
         bs_builtin_object_methods_add(bs, BS_OBJECT_ARRAY, Bs_Sv_Static("filter"), bs_array_filter);
         bs_builtin_object_methods_add(bs, BS_OBJECT_ARRAY, Bs_Sv_Static("reduce"), bs_array_reduce);
+        bs_builtin_object_methods_add(bs, BS_OBJECT_ARRAY, Bs_Sv_Static("iter"), bs_array_iter);
 
         bs_builtin_object_methods_add(bs, BS_OBJECT_ARRAY, Bs_Sv_Static("join"), bs_array_join);
         bs_builtin_object_methods_add(bs, BS_OBJECT_ARRAY, Bs_Sv_Static("find"), bs_array_find);
@@ -2850,6 +4971,8 @@ void bs_core_init(Bs *bs, int argc, char **argv) {
         bs_builtin_object_methods_add(bs, BS_OBJECT_ARRAY, Bs_Sv_Static("pop"), bs_array_pop);
 
         bs_builtin_object_methods_add(bs, BS_OBJECT_ARRAY, Bs_Sv_Static("sort"), bs_array_sort);
+        bs_builtin_object_methods_add(
+            bs, BS_OBJECT_ARRAY, Bs_Sv_Static("sort_by"), bs_array_sort_by);
         bs_builtin_object_methods_add(bs, BS_OBJECT_ARRAY, Bs_Sv_Static("resize"), bs_array_resize);
         bs_builtin_object_methods_add(bs, BS_OBJECT_ARRAY, Bs_Sv_Static("reverse"), bs_array_reverse);
 
@@ -2861,6 +4984,31 @@ void bs_core_init(Bs *bs, int argc, char **argv) {
     {
         // Table
         bs_builtin_object_methods_add(bs, BS_OBJECT_TABLE, Bs_Sv_Static("extend"), bs_table_extend);
+        bs_builtin_object_methods_add(bs, BS_OBJECT_TABLE, Bs_Sv_Static("iter"), bs_table_iter);
+    }
+
+    {
+        Bs_Table *json = bs_table_new(bs);
+        bs_add_fn(bs, json, "parse", bs_json_parse_fn);
+        bs_add_fn(bs, json, "stringify", bs_json_stringify);
+        bs_add_fn(bs, json, "write", bs_json_write_fn);
+        bs_add_fn(bs, json, "lines", bs_json_lines);
+        bs_global_set(bs, Bs_Sv_Static("json"), bs_value_object(json));
+    }
+
+    {
+        bs_csv_reader_class =
+            bs_c_class_new(bs, Bs_Sv_Static("Reader"), sizeof(Bs_Csv), bs_csv_reader_init);
+
+        bs_csv_reader_class->free = bs_csv_reader_free;
+        bs_csv_reader_class->mark = bs_csv_reader_mark;
+        bs_csv_reader_class->next = bs_csv_reader_next;
+
+        bs_c_class_add(bs, bs_csv_reader_class, Bs_Sv_Static("next"), bs_csv_reader_next_method);
+
+        Bs_Table *csv = bs_table_new(bs);
+        bs_add(bs, csv, "Reader", bs_value_object(bs_csv_reader_class));
+        bs_global_set(bs, Bs_Sv_Static("csv"), bs_value_object(csv));
     }
 
     {
@@ -2929,6 +5077,8 @@ void bs_core_init(Bs *bs, int argc, char **argv) {
         bs_add_fn(bs, meta, "compile", bs_meta_compile);
         bs_add_fn(bs, meta, "call", bs_meta_call);
         bs_add_fn(bs, meta, "eval", bs_meta_eval);
+        bs_add_fn(bs, meta, "serialize", bs_meta_serialize);
+        bs_add_fn(bs, meta, "deserialize", bs_meta_deserialize);
         bs_global_set(bs, Bs_Sv_Static("meta"), bs_value_object(meta));
     }
 }
@@ -18,6 +18,21 @@ bs_debug_op_value(Bs_Pretty_Printer *p, const Bs_Chunk *c, size_t *offset, const
     bs_fmt(p->writer, "'\n");
 }
 
+static void
+bs_debug_op_iter(Bs_Pretty_Printer *p, const Bs_Chunk *c, size_t *offset, const char *name) {
+    const Bs_Iter_Bindings bindings = c->data[(*offset)++];
+    const size_t           jump = *(const size_t *) &c->data[*offset];
+    *offset += sizeof(jump);
+
+    bs_fmt(
+        p->writer,
+        "%-16s %4ld%s%s\n",
+        name,
+        jump,
+        (bindings & BS_ITER_KEY) ? " key" : "",
+        (bindings & BS_ITER_VALUE) ? " value" : "");
+}
+
 static void
 bs_debug_op_invoke(Bs_Pretty_Printer *p, const Bs_Chunk *c, size_t *offset, const char *name) {
     const size_t constant = *(const size_t *) &c->data[*offset];
@@ -28,7 +43,7 @@ bs_debug_op_invoke(Bs_Pretty_Printer *p, const Bs_Chunk *c, size_t *offset, cons
     bs_fmt(p->writer, "'\n");
 }
 
-static_assert(BS_COUNT_OPS == 77, "Update bs_debug_op()");
+static_assert(BS_COUNT_OPS == 105, "Update bs_debug_op()");
 void bs_debug_op(Bs_Pretty_Printer *p, const Bs_Chunk *c, size_t *offset) {
     bs_fmt(p->writer, "%04zu ", *offset);
 
@@ -42,10 +57,27 @@ void bs_debug_op(Bs_Pretty_Printer *p, const Bs_Chunk *c, size_t *offset) {
         bs_fmt(p->writer, "OP_CALL\n");
         break;
 
+    case BS_OP_TAIL_CALL:
+        bs_fmt(p->writer, "OP_TAIL_CALL\n");
+        break;
+
     case BS_OP_DEFER:
         bs_fmt(p->writer, "OP_DEFER\n");
         break;
 
+    case BS_OP_DEFER_INVOKE: {
+        const size_t constant = *(const size_t *) &c->data[*offset];
+        *offset += sizeof(constant);
+
+        const Bs_Capture capture = c->data[(*offset)++];
+        const size_t     slot = *(const size_t *) &c->data[*offset];
+        *offset += sizeof(slot);
+
+        bs_fmt(p->writer, "%-16s %4zu '", "OP_DEFER_INVOKE", constant);
+        bs_value_write_impl(p, c->constants.data[constant]);
+        bs_fmt(p->writer, "' %s %zu\n", capture == BS_CAPTURE_VALUE ? "value" : "local", slot);
+    } break;
+
     case BS_OP_SPREAD:
         bs_fmt(p->writer, "OP_SPREAD\n");
         break;
@@ -61,15 +93,21 @@ void bs_debug_op(Bs_Pretty_Printer *p, const Bs_Chunk *c, size_t *offset) {
 
         const Bs_Fn *fn = (const Bs_Fn *) value.as.object;
         for (size_t i = 0; i < fn->upvalues; i++) {
-            const bool   local = c->data[(*offset)++];
-            const size_t index = *(const size_t *) &c->data[*offset];
+            static const char *kinds[] = {
+                [BS_CAPTURE_UPVALUE] = "upvalue",
+                [BS_CAPTURE_LOCAL] = "local",
+                [BS_CAPTURE_VALUE] = "value",
+            };
+
+            const Bs_Capture capture = c->data[(*offset)++];
+            const size_t     index = *(const size_t *) &c->data[*offset];
             *offset += sizeof(index);
 
             bs_fmt(
                 p->writer,
                 "%04zu      |                     %s %zu\n",
                 *offset - 1 - sizeof(index),
-                local ? "local" : "upvalue",
+                kinds[capture],
                 index);
         }
     } break;
@@ -361,8 +399,12 @@ void bs_debug_op(Bs_Pretty_Printer *p, const Bs_Chunk *c, size_t *offset) {
         bs_debug_op_int(p, c, offset, "OP_MATCH_IF");
         break;
 
+    case BS_OP_MATCH_TABLE:
+        bs_debug_op_value(p, c, offset, "OP_MATCH_TABLE");
+        break;
+
     case BS_OP_ITER:
-        bs_debug_op_int(p, c, offset, "OP_ITER");
+        bs_debug_op_iter(p, c, offset, "OP_ITER");
         break;
 
     case BS_OP_RANGE:
@@ -373,6 +415,108 @@ void bs_debug_op(Bs_Pretty_Printer *p, const Bs_Chunk *c, size_t *offset) {
         bs_debug_op_int(p, c, offset, "OP_IRANGE");
         break;
 
+    case BS_OP_RANGE_INIT:
+        bs_fmt(p->writer, "OP_RANGE_INIT%s\n", c->data[(*offset)++] ? " inclusive" : "");
+        break;
+
+    case BS_OP_ADD_NUM:
+        bs_fmt(p->writer, "OP_ADD_NUM\n");
+        break;
+
+    case BS_OP_SUB_NUM:
+        bs_fmt(p->writer, "OP_SUB_NUM\n");
+        break;
+
+    case BS_OP_MUL_NUM:
+        bs_fmt(p->writer, "OP_MUL_NUM\n");
+        break;
+
+    case BS_OP_DIV_NUM:
+        bs_fmt(p->writer, "OP_DIV_NUM\n");
+        break;
+
+    case BS_OP_GT_NUM:
+        bs_fmt(p->writer, "OP_GT_NUM\n");
+        break;
+
+    case BS_OP_GE_NUM:
+        bs_fmt(p->writer, "OP_GE_NUM\n");
+        break;
+
+    case BS_OP_LT_NUM:
+        bs_fmt(p->writer, "OP_LT_NUM\n");
+        break;
+
+    case BS_OP_LE_NUM:
+        bs_fmt(p->writer, "OP_LE_NUM\n");
+        break;
+
+    case BS_OP_IGET_ARRAY_INDEX:
+        bs_fmt(p->writer, "OP_IGET_ARRAY_INDEX\n");
+        break;
+
+    case BS_OP_ITER_ARRAY:
+        bs_debug_op_iter(p, c, offset, "OP_ITER_ARRAY");
+        break;
+
+    case BS_OP_ITER_STR:
+        bs_debug_op_iter(p, c, offset, "OP_ITER_STR");
+        break;
+
+    case BS_OP_ITER_MAP:
+        bs_debug_op_iter(p, c, offset, "OP_ITER_MAP");
+        break;
+
+    case BS_OP_INVOKE_INSTANCE:
+        bs_debug_op_invoke(p, c, offset, "OP_INVOKE_INSTANCE");
+        break;
+
+    // Superinstructions only own the operand of their first op, the rest of the sequence is
+    // printed as is
+    case BS_OP_LGET_LGET_ADD:
+        bs_debug_op_int(p, c, offset, "OP_LGET_LGET_ADD");
+        break;
+
+    case BS_OP_LGET_CONST_LT_ELSE:
+        bs_debug_op_int(p, c, offset, "OP_LGET_CONST_LT_ELSE");
+        break;
+
+    case BS_OP_LGET_IGET_CONST:
+        bs_debug_op_int(p, c, offset, "OP_LGET_IGET_CONST");
+        break;
+
+    case BS_OP_INCR_LOCAL:
+        bs_debug_op_int(p, c, offset, "OP_INCR_LOCAL");
+        break;
+
+    case BS_OP_REG_BINARY:
+        bs_debug_op_int(p, c, offset, "OP_REG_BINARY");
+        break;
+
+    case BS_OP_REG_BINARY_SET:
+        bs_debug_op_int(p, c, offset, "OP_REG_BINARY_SET");
+        break;
+
+    case BS_OP_REG_BINARY_ELSE:
+        bs_debug_op_int(p, c, offset, "OP_REG_BINARY_ELSE");
+        break;
+
+    case BS_OP_REG_TOP:
+        bs_debug_op_int(p, c, offset, "OP_REG_TOP");
+        break;
+
+    case BS_OP_REG_TOP_SET:
+        bs_debug_op_int(p, c, offset, "OP_REG_TOP_SET");
+        break;
+
+    case BS_OP_REG_MOVE:
+        bs_debug_op_int(p, c, offset, "OP_REG_MOVE");
+        break;
+
+    case BS_OP_REG_LOAD:
+        bs_debug_op_value(p, c, offset, "OP_REG_LOAD");
+        break;
+
     default:
         bs_fmt(p->writer, "error: unknown opcode %d at offset %zu\n", op, *offset);
         return;
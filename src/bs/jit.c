@@ -0,0 +1,607 @@
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "bs/jit.h"
+
+#if defined(__linux__) && defined(__x86_64__)
+#    include <sys/mman.h>
+
+// The code is entered through a single function, which jumps to the op it was asked to start at:
+//
+//   rdi = The frame base
+//   rsi = Where the stack top gets written back to
+//   rdx = The entry point
+//
+// The stack top lives in r9 for as long as the code runs. Every exit stores it back and returns
+// the offset of the op the interpreter should continue from in rax. The code never calls out, so
+// only the caller saved registers are used and no stack frame is needed
+typedef size_t (*Bs_Jit_Fn)(Bs_Value *base, Bs_Value **top, const uint8_t *entry);
+
+typedef enum {
+    BS_JIT_RAX = 0,
+    BS_JIT_RCX = 1,
+    BS_JIT_RSI = 6,
+    BS_JIT_RDI = 7,
+    BS_JIT_R9 = 9,
+} Bs_Jit_Reg;
+
+// The second byte of the near conditional jumps, or BS_JIT_JMP for an unconditional jump
+typedef enum {
+    BS_JIT_JMP = 0,
+    BS_JIT_JE = 0x84,
+    BS_JIT_JNE = 0x85,
+} Bs_Jit_Cond;
+
+#    define BS_JIT_TYPE offsetof(Bs_Value, type)
+#    define BS_JIT_AS   offsetof(Bs_Value, as)
+
+static_assert(sizeof(Bs_Value) == 16, "Update the templates in jit.c");
+
+typedef struct {
+    uint8_t *data;
+    size_t   count;
+    size_t   capacity;
+} Bs_Jit_Code;
+
+typedef struct {
+    size_t at;     // Where the 32-bit displacement of the jump goes
+    size_t target; // The op to jump to, or the op which gives up in case of an exit
+} Bs_Jit_Fixup;
+
+typedef struct {
+    Bs_Jit_Fixup *data;
+    size_t        count;
+    size_t        capacity;
+} Bs_Jit_Fixups;
+
+typedef struct {
+    Bs          *bs;
+    Bs_Jit_Code  code;
+    size_t       addr;
+    uint32_t    *labels;
+
+    Bs_Jit_Fixups jumps;
+    Bs_Jit_Fixups exits;
+} Bs_Jit_Compiler;
+
+static void bs_jit_byte(Bs_Jit_Compiler *j, uint8_t byte) {
+    bs_da_push(j->bs, &j->code, byte);
+}
+
+static void bs_jit_bytes(Bs_Jit_Compiler *j, const void *data, size_t size) {
+    bs_da_push_many(j->bs, &j->code, data, size);
+}
+
+static void bs_jit_u32(Bs_Jit_Compiler *j, uint32_t value) {
+    bs_jit_bytes(j, &value, sizeof(value));
+}
+
+static void
+bs_jit_opcode(Bs_Jit_Compiler *j, uint8_t prefix, bool wide, uint16_t opcode, int reg, int rm) {
+    if (prefix) {
+        bs_jit_byte(j, prefix);
+    }
+
+    const uint8_t rex = 0x40 | (wide << 3) | ((reg >> 3) << 2) | (rm >> 3);
+    if (rex != 0x40) {
+        bs_jit_byte(j, rex);
+    }
+
+    if (opcode > 0xFF) {
+        bs_jit_byte(j, opcode >> 8);
+    }
+    bs_jit_byte(j, opcode & 0xFF);
+}
+
+// Encodes `opcode reg, [base + disp]`. The base is never rsp, rbp, r12 or r13, which would need
+// another byte for addressing
+static void bs_jit_mem(
+    Bs_Jit_Compiler *j, uint8_t prefix, bool wide, uint16_t opcode, int reg, int base, int disp) {
+    bs_jit_opcode(j, prefix, wide, opcode, reg, base);
+
+    const uint8_t modrm = ((reg & 7) << 3) | (base & 7);
+    if (!disp) {
+        bs_jit_byte(j, modrm);
+    } else if (disp >= INT8_MIN && disp <= INT8_MAX) {
+        bs_jit_byte(j, 0x40 | modrm);
+        bs_jit_byte(j, disp);
+    } else {
+        bs_jit_byte(j, 0x80 | modrm);
+        bs_jit_u32(j, disp);
+    }
+}
+
+// Encodes `opcode reg, rm` between registers
+static void
+bs_jit_reg(Bs_Jit_Compiler *j, uint8_t prefix, bool wide, uint16_t opcode, int reg, int rm) {
+    bs_jit_opcode(j, prefix, wide, opcode, reg, rm);
+    bs_jit_byte(j, 0xC0 | ((reg & 7) << 3) | (rm & 7));
+}
+
+// The displacement of a field of the value `depth` slots below the top of the stack
+static int32_t bs_jit_slot(size_t depth, size_t field) {
+    return field - (int32_t) ((depth + 1) * sizeof(Bs_Value));
+}
+
+static void
+bs_jit_jump(Bs_Jit_Compiler *j, Bs_Jit_Cond cond, Bs_Jit_Fixups *fixups, size_t target) {
+    if (cond == BS_JIT_JMP) {
+        bs_jit_byte(j, 0xE9);
+    } else {
+        bs_jit_byte(j, 0x0F);
+        bs_jit_byte(j, cond);
+    }
+
+    bs_da_push(j->bs, fixups, ((Bs_Jit_Fixup) {.at = j->code.count, .target = target}));
+    bs_jit_u32(j, 0);
+}
+
+// Short jumps within a template, patched by bs_jit_short_patch()
+static size_t bs_jit_short(Bs_Jit_Compiler *j, uint8_t opcode) {
+    bs_jit_byte(j, opcode);
+    bs_jit_byte(j, 0);
+    return j->code.count - 1;
+}
+
+static void bs_jit_short_patch(Bs_Jit_Compiler *j, size_t at) {
+    const size_t distance = j->code.count - at - 1;
+    assert(distance <= INT8_MAX);
+    j->code.data[at] = distance;
+}
+
+static void bs_jit_exit(Bs_Jit_Compiler *j, size_t addr) {
+    bs_jit_mem(j, 0, true, 0x89, BS_JIT_R9, BS_JIT_RSI, 0); // mov [rsi], r9
+    bs_jit_byte(j, 0xB8);                                   // mov eax, addr
+    bs_jit_u32(j, addr);
+    bs_jit_byte(j, 0xC3); // ret
+}
+
+static void bs_jit_top_move(Bs_Jit_Compiler *j, int8_t values) {
+    const int8_t bytes = values * (int8_t) sizeof(Bs_Value);
+    bs_jit_byte(j, 0x49);
+    bs_jit_byte(j, 0x83);
+    if (bytes > 0) {
+        bs_jit_byte(j, 0xC1); // add r9, bytes
+        bs_jit_byte(j, bytes);
+    } else {
+        bs_jit_byte(j, 0xE9); // sub r9, -bytes
+        bs_jit_byte(j, -bytes);
+    }
+}
+
+// Gives up on the current op unless the value `depth` slots below the top is a number
+static void bs_jit_guard_num(Bs_Jit_Compiler *j, size_t depth) {
+    bs_jit_mem(j, 0, false, 0x83, 7, BS_JIT_R9, bs_jit_slot(depth, BS_JIT_TYPE));
+    bs_jit_byte(j, BS_VALUE_NUM);
+    bs_jit_jump(j, BS_JIT_JNE, &j->exits, j->addr);
+}
+
+static void bs_jit_push_copy(Bs_Jit_Compiler *j, int base, int32_t disp) {
+    bs_jit_mem(j, 0, true, 0x8B, BS_JIT_RAX, base, disp);
+    bs_jit_mem(j, 0, true, 0x8B, BS_JIT_RCX, base, disp + BS_JIT_AS);
+    bs_jit_mem(j, 0, true, 0x89, BS_JIT_RAX, BS_JIT_R9, 0);
+    bs_jit_mem(j, 0, true, 0x89, BS_JIT_RCX, BS_JIT_R9, BS_JIT_AS);
+    bs_jit_top_move(j, 1);
+}
+
+static void bs_jit_push_value(Bs_Jit_Compiler *j, Bs_Value value) {
+    uint64_t payload = 0;
+    switch (value.type) {
+    case BS_VALUE_NIL:
+        break;
+
+    case BS_VALUE_NUM:
+        memcpy(&payload, &value.as.number, sizeof(value.as.number));
+        break;
+
+    case BS_VALUE_BOOL:
+        payload = value.as.boolean;
+        break;
+
+    case BS_VALUE_OBJECT:
+        payload = (uintptr_t) value.as.object;
+        break;
+    }
+
+    bs_jit_mem(j, 0, false, 0xC7, 0, BS_JIT_R9, BS_JIT_TYPE); // mov dword [r9], type
+    bs_jit_u32(j, value.type);
+
+    bs_jit_byte(j, 0x48); // mov rax, payload
+    bs_jit_byte(j, 0xB8);
+    bs_jit_bytes(j, &payload, sizeof(payload));
+    bs_jit_mem(j, 0, true, 0x89, BS_JIT_RAX, BS_JIT_R9, BS_JIT_AS);
+    bs_jit_top_move(j, 1);
+}
+
+// Replaces the two values on the top with a boolean from the setcc ops already in al
+static void bs_jit_replace_bool(Bs_Jit_Compiler *j) {
+    bs_jit_reg(j, 0, false, 0x0FB6, BS_JIT_RAX, BS_JIT_RAX); // movzx eax, al
+    bs_jit_mem(j, 0, false, 0xC7, 0, BS_JIT_R9, bs_jit_slot(1, BS_JIT_TYPE));
+    bs_jit_u32(j, BS_VALUE_BOOL);
+    bs_jit_mem(j, 0, true, 0x89, BS_JIT_RAX, BS_JIT_R9, bs_jit_slot(1, BS_JIT_AS));
+    bs_jit_top_move(j, -1);
+}
+
+static void bs_jit_load_operands(Bs_Jit_Compiler *j) {
+    bs_jit_guard_num(j, 1);
+    bs_jit_guard_num(j, 0);
+    bs_jit_mem(j, 0xF2, false, 0x0F10, 0, BS_JIT_R9, bs_jit_slot(1, BS_JIT_AS)); // movsd xmm0
+    bs_jit_mem(j, 0xF2, false, 0x0F10, 1, BS_JIT_R9, bs_jit_slot(0, BS_JIT_AS)); // movsd xmm1
+}
+
+static void bs_jit_arithmetic(Bs_Jit_Compiler *j, uint16_t opcode) {
+    bs_jit_load_operands(j);
+    bs_jit_reg(j, 0xF2, false, opcode, 0, 1);
+    bs_jit_mem(j, 0xF2, false, 0x0F11, 0, BS_JIT_R9, bs_jit_slot(1, BS_JIT_AS));
+    bs_jit_top_move(j, -1);
+}
+
+// The unsigned flags of ucomisd match the ordered comparisons, since NaN sets the carry
+static void bs_jit_compare(Bs_Jit_Compiler *j, uint16_t setcc, bool swap) {
+    bs_jit_load_operands(j);
+    bs_jit_reg(j, 0x66, false, 0x0F2E, swap, !swap); // ucomisd
+    bs_jit_reg(j, 0, false, setcc, 0, BS_JIT_RAX);
+    bs_jit_replace_bool(j);
+}
+
+static void bs_jit_equal(Bs_Jit_Compiler *j, bool equal) {
+    bs_jit_load_operands(j);
+    bs_jit_reg(j, 0x66, false, 0x0F2E, 0, 1); // ucomisd xmm0, xmm1
+
+    // Unordered compares as unequal
+    if (equal) {
+        bs_jit_reg(j, 0, false, 0x0F94, 0, BS_JIT_RAX); // sete al
+        bs_jit_reg(j, 0, false, 0x0F9B, 0, BS_JIT_RCX); // setnp cl
+        bs_jit_reg(j, 0, false, 0x20, BS_JIT_RCX, BS_JIT_RAX);
+    } else {
+        bs_jit_reg(j, 0, false, 0x0F95, 0, BS_JIT_RAX); // setne al
+        bs_jit_reg(j, 0, false, 0x0F9A, 0, BS_JIT_RCX); // setp cl
+        bs_jit_reg(j, 0, false, 0x08, BS_JIT_RCX, BS_JIT_RAX);
+    }
+
+    bs_jit_replace_bool(j);
+}
+
+// Loads the type of the top into eax and checks whether it is nil, leaving the flags for the jump
+static void bs_jit_test_top(Bs_Jit_Compiler *j) {
+    bs_jit_mem(j, 0, false, 0x8B, BS_JIT_RAX, BS_JIT_R9, bs_jit_slot(0, BS_JIT_TYPE));
+    bs_jit_reg(j, 0, false, 0x85, BS_JIT_RAX, BS_JIT_RAX); // test eax, eax
+}
+
+static void bs_jit_test_bool(Bs_Jit_Compiler *j) {
+    bs_jit_reg(j, 0, false, 0x83, 7, BS_JIT_RAX); // cmp eax, BS_VALUE_BOOL
+    bs_jit_byte(j, BS_VALUE_BOOL);
+}
+
+static void bs_jit_test_false(Bs_Jit_Compiler *j) {
+    bs_jit_mem(j, 0, false, 0x80, 7, BS_JIT_R9, bs_jit_slot(0, BS_JIT_AS)); // cmp byte
+    bs_jit_byte(j, 0);
+}
+
+static void bs_jit_else(Bs_Jit_Compiler *j, size_t target) {
+    bs_jit_test_top(j);
+    bs_jit_jump(j, BS_JIT_JE, &j->jumps, target);
+
+    bs_jit_test_bool(j);
+    const size_t truthy = bs_jit_short(j, 0x75); // jne
+    bs_jit_test_false(j);
+    bs_jit_jump(j, BS_JIT_JE, &j->jumps, target);
+    bs_jit_short_patch(j, truthy);
+}
+
+static void bs_jit_then(Bs_Jit_Compiler *j, size_t target) {
+    bs_jit_test_top(j);
+    const size_t falsey = bs_jit_short(j, 0x74); // je
+
+    bs_jit_test_bool(j);
+    bs_jit_jump(j, BS_JIT_JNE, &j->jumps, target);
+    bs_jit_test_false(j);
+    bs_jit_jump(j, BS_JIT_JNE, &j->jumps, target);
+    bs_jit_short_patch(j, falsey);
+}
+
+static void bs_jit_lnot(Bs_Jit_Compiler *j) {
+    bs_jit_reg(j, 0, false, 0x31, BS_JIT_RCX, BS_JIT_RCX); // xor ecx, ecx
+    bs_jit_test_top(j);
+    const size_t nil = bs_jit_short(j, 0x74); // je
+
+    bs_jit_test_bool(j);
+    const size_t truthy = bs_jit_short(j, 0x75); // jne
+    bs_jit_test_false(j);
+    const size_t truthy_bool = bs_jit_short(j, 0x75); // jne
+
+    bs_jit_short_patch(j, nil);
+    bs_jit_byte(j, 0xB9); // mov ecx, 1
+    bs_jit_u32(j, 1);
+
+    bs_jit_short_patch(j, truthy);
+    bs_jit_short_patch(j, truthy_bool);
+    bs_jit_mem(j, 0, false, 0xC7, 0, BS_JIT_R9, bs_jit_slot(0, BS_JIT_TYPE));
+    bs_jit_u32(j, BS_VALUE_BOOL);
+    bs_jit_mem(j, 0, true, 0x89, BS_JIT_RCX, BS_JIT_R9, bs_jit_slot(0, BS_JIT_AS));
+}
+
+// Only the ranges with a precomputed count. See BS_OP_RANGE in bs_interpret()
+static void bs_jit_range(Bs_Jit_Compiler *j, size_t target) {
+    const double one = 1;
+    uint64_t     payload;
+    memcpy(&payload, &one, sizeof(payload));
+
+    bs_jit_guard_num(j, 0);
+    bs_jit_mem(j, 0xF2, false, 0x0F10, 0, BS_JIT_R9, bs_jit_slot(0, BS_JIT_AS)); // movsd xmm0
+    bs_jit_reg(j, 0x66, false, 0x0F57, 1, 1);                                    // xorpd xmm1
+    bs_jit_reg(j, 0x66, false, 0x0F2E, 0, 1);                                    // ucomisd
+
+    // Neither of these touch the flags
+    bs_jit_byte(j, 0x48); // mov rax, 1.0
+    bs_jit_byte(j, 0xB8);
+    bs_jit_bytes(j, &payload, sizeof(payload));
+    bs_jit_reg(j, 0x66, true, 0x0F6E, 1, BS_JIT_RAX); // movq xmm1, rax
+    bs_jit_reg(j, 0xF2, false, 0x0F5C, 0, 1);         // subsd xmm0, xmm1
+    bs_jit_mem(j, 0xF2, false, 0x0F11, 0, BS_JIT_R9, bs_jit_slot(0, BS_JIT_AS));
+
+    const size_t unordered = bs_jit_short(j, 0x7A); // jp
+    bs_jit_jump(j, BS_JIT_JE, &j->jumps, target);
+    bs_jit_short_patch(j, unordered);
+
+    // Push the start, then step it
+    bs_jit_push_copy(j, BS_JIT_R9, bs_jit_slot(3, BS_JIT_TYPE));
+    bs_jit_mem(j, 0xF2, false, 0x0F10, 0, BS_JIT_R9, bs_jit_slot(4, BS_JIT_AS)); // movsd xmm0
+    bs_jit_mem(j, 0xF2, false, 0x0F58, 0, BS_JIT_R9, bs_jit_slot(2, BS_JIT_AS)); // addsd xmm0
+    bs_jit_mem(j, 0xF2, false, 0x0F11, 0, BS_JIT_R9, bs_jit_slot(4, BS_JIT_AS));
+}
+
+static_assert(BS_COUNT_OPS == 105, "Update bs_jit_op()");
+static bool bs_jit_op(Bs_Jit_Compiler *j, const Bs_Chunk *chunk, size_t next) {
+    const uint8_t *operand = &chunk->data[j->addr + 1];
+    const size_t   value = next - j->addr > sizeof(size_t) ? *(const size_t *) operand : 0;
+
+    const Bs_Op op = bs_op_generic(chunk->data[j->addr]);
+    switch (op) {
+    case BS_OP_DUP:
+        bs_jit_push_copy(j, BS_JIT_R9, bs_jit_slot(*operand, BS_JIT_TYPE));
+        break;
+
+    case BS_OP_DROP:
+        bs_jit_top_move(j, -1);
+        break;
+
+    case BS_OP_NIL:
+        bs_jit_push_value(j, bs_value_nil);
+        break;
+
+    case BS_OP_TRUE:
+        bs_jit_push_value(j, bs_value_bool(true));
+        break;
+
+    case BS_OP_FALSE:
+        bs_jit_push_value(j, bs_value_bool(false));
+        break;
+
+    case BS_OP_CONST:
+        bs_jit_push_value(j, chunk->constants.data[value]);
+        break;
+
+    case BS_OP_ADD:
+        bs_jit_arithmetic(j, 0x0F58);
+        break;
+
+    case BS_OP_SUB:
+        bs_jit_arithmetic(j, 0x0F5C);
+        break;
+
+    case BS_OP_MUL:
+        bs_jit_arithmetic(j, 0x0F59);
+        break;
+
+    case BS_OP_DIV:
+        bs_jit_arithmetic(j, 0x0F5E);
+        break;
+
+    case BS_OP_NEG:
+        bs_jit_guard_num(j, 0);
+        bs_jit_mem(j, 0, true, 0x8B, BS_JIT_RAX, BS_JIT_R9, bs_jit_slot(0, BS_JIT_AS));
+        bs_jit_reg(j, 0, true, 0x0FBA, 7, BS_JIT_RAX); // btc rax, 63
+        bs_jit_byte(j, 63);
+        bs_jit_mem(j, 0, true, 0x89, BS_JIT_RAX, BS_JIT_R9, bs_jit_slot(0, BS_JIT_AS));
+        break;
+
+    case BS_OP_LNOT:
+        bs_jit_lnot(j);
+        break;
+
+    case BS_OP_GT:
+        bs_jit_compare(j, 0x0F97, false); // seta
+        break;
+
+    case BS_OP_GE:
+        bs_jit_compare(j, 0x0F93, false); // setae
+        break;
+
+    case BS_OP_LT:
+        bs_jit_compare(j, 0x0F97, true);
+        break;
+
+    case BS_OP_LE:
+        bs_jit_compare(j, 0x0F93, true);
+        break;
+
+    case BS_OP_EQ:
+        bs_jit_equal(j, true);
+        break;
+
+    case BS_OP_NE:
+        bs_jit_equal(j, false);
+        break;
+
+    case BS_OP_LGET:
+    case BS_OP_LSET:
+        if (value >= INT32_MAX / sizeof(Bs_Value)) {
+            return false;
+        }
+
+        if (op == BS_OP_LSET) {
+            bs_jit_mem(j, 0, true, 0x8B, BS_JIT_RAX, BS_JIT_R9, bs_jit_slot(0, BS_JIT_TYPE));
+            bs_jit_mem(j, 0, true, 0x8B, BS_JIT_RCX, BS_JIT_R9, bs_jit_slot(0, BS_JIT_AS));
+            bs_jit_mem(j, 0, true, 0x89, BS_JIT_RAX, BS_JIT_RDI, value * sizeof(Bs_Value));
+            bs_jit_mem(
+                j, 0, true, 0x89, BS_JIT_RCX, BS_JIT_RDI, value * sizeof(Bs_Value) + BS_JIT_AS);
+        } else {
+            bs_jit_push_copy(j, BS_JIT_RDI, value * sizeof(Bs_Value));
+        }
+        break;
+
+    case BS_OP_JUMP:
+        bs_jit_jump(j, BS_JIT_JMP, &j->jumps, next + value);
+        break;
+
+    case BS_OP_ELSE:
+        bs_jit_else(j, next + value);
+        break;
+
+    case BS_OP_THEN:
+        bs_jit_then(j, next + value);
+        break;
+
+    case BS_OP_RANGE:
+    case BS_OP_IRANGE:
+        bs_jit_range(j, next + value);
+        break;
+
+    default:
+        return false;
+    }
+
+    return true;
+}
+
+static void bs_jit_compiler_free(Bs_Jit_Compiler *j) {
+    bs_da_free(j->bs, &j->code);
+    bs_da_free(j->bs, &j->jumps);
+    bs_da_free(j->bs, &j->exits);
+}
+
+Bs_Jit *bs_jit_compile(Bs *bs, const Bs_Fn *fn) {
+    const Bs_Chunk *chunk = &fn->chunk;
+    if (chunk->count >= BS_JIT_NONE) {
+        return NULL;
+    }
+
+    Bs_Jit *jit = bs_realloc(bs, NULL, 0, sizeof(Bs_Jit));
+    *jit = (Bs_Jit) {.count = chunk->count};
+    jit->entries = bs_realloc(bs, NULL, 0, jit->count * sizeof(*jit->entries));
+
+    Bs_Jit_Compiler j = {.bs = bs, .labels = jit->entries};
+    bs_jit_mem(&j, 0, true, 0x8B, BS_JIT_R9, BS_JIT_RSI, 0); // mov r9, [rsi]
+    bs_jit_byte(&j, 0xFF);                                  // jmp rdx
+    bs_jit_byte(&j, 0xE2);
+
+    // The ops without a template give up right away, which leaves something to jump to for the
+    // ops that do have one
+    bool *templated = bs_realloc(bs, NULL, 0, jit->count * sizeof(*templated));
+    memset(jit->entries, 0xFF, jit->count * sizeof(*jit->entries));
+
+    for (size_t next; j.addr < chunk->count; j.addr = next) {
+        next = j.addr + bs_chunk_op_size(chunk, j.addr);
+
+        const size_t start = j.code.count;
+        jit->entries[j.addr] = start;
+        templated[j.addr] = bs_jit_op(&j, chunk, next);
+        if (!templated[j.addr]) {
+            j.code.count = start;
+            bs_jit_exit(&j, j.addr);
+        }
+    }
+
+    for (size_t i = 0; i < j.jumps.count; i++) {
+        const Bs_Jit_Fixup fixup = j.jumps.data[i];
+        const int32_t      distance = j.labels[fixup.target] - (fixup.at + sizeof(int32_t));
+        memcpy(&j.code.data[fixup.at], &distance, sizeof(distance));
+    }
+
+    // Every op shares a single exit between its guards, and they were all emitted in a row
+    size_t stub = 0;
+    for (size_t i = 0; i < j.exits.count; i++) {
+        const Bs_Jit_Fixup fixup = j.exits.data[i];
+        if (!i || fixup.target != j.exits.data[i - 1].target) {
+            stub = j.code.count;
+            bs_jit_exit(&j, fixup.target);
+        }
+
+        const int32_t distance = stub - (fixup.at + sizeof(int32_t));
+        memcpy(&j.code.data[fixup.at], &distance, sizeof(distance));
+    }
+
+    for (size_t i = 0; i < jit->count; i++) {
+        if (jit->entries[i] != BS_JIT_NONE && !templated[i]) {
+            jit->entries[i] = BS_JIT_NONE;
+        }
+    }
+    bs_realloc(bs, templated, jit->count * sizeof(*templated), 0);
+
+    jit->size = j.code.count;
+    jit->code = mmap(NULL, jit->size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (jit->code == MAP_FAILED) {
+        jit->code = NULL;
+    } else {
+        memcpy(jit->code, j.code.data, jit->size);
+        if (mprotect(jit->code, jit->size, PROT_READ | PROT_EXEC)) {
+            munmap(jit->code, jit->size);
+            jit->code = NULL;
+        }
+    }
+
+    bs_jit_compiler_free(&j);
+    if (!jit->code) {
+        bs_jit_free(bs, jit);
+        return NULL;
+    }
+
+    return jit;
+}
+
+void bs_jit_free(Bs *bs, Bs_Jit *jit) {
+    if (jit->code) {
+        munmap(jit->code, jit->size);
+    }
+
+    bs_realloc(bs, jit->entries, jit->count * sizeof(*jit->entries), 0);
+    bs_realloc(bs, jit, sizeof(*jit), 0);
+}
+
+size_t bs_jit_run(const Bs_Jit *jit, size_t offset, Bs_Value *base, Bs_Value **top) {
+    if (jit->native) {
+        return jit->native(jit->constants, offset, base, top);
+    }
+
+    const uint32_t entry = jit->entries[offset];
+    if (entry == BS_JIT_NONE) {
+        return offset;
+    }
+
+    return ((Bs_Jit_Fn) jit->code)(base, top, jit->code + entry);
+}
+#else
+Bs_Jit *bs_jit_compile(Bs *bs, const Bs_Fn *fn) {
+    return NULL;
+}
+
+void bs_jit_free(Bs *bs, Bs_Jit *jit) {
+    bs_realloc(bs, jit, sizeof(*jit), 0);
+}
+
+size_t bs_jit_run(const Bs_Jit *jit, size_t offset, Bs_Value *base, Bs_Value **top) {
+    if (jit->native) {
+        return jit->native(jit->constants, offset, base, top);
+    }
+
+    return offset;
+}
+#endif // __linux__ && __x86_64__
+
+Bs_Jit *bs_jit_native(Bs *bs, Bs_Jit_Native native, const Bs_Value *constants) {
+    Bs_Jit *jit = bs_realloc(bs, NULL, 0, sizeof(Bs_Jit));
+    *jit = (Bs_Jit) {.native = native, .constants = constants};
+    return jit;
+}
@@ -0,0 +1,730 @@
+#ifdef __SSE2__
+#    include <emmintrin.h>
+#endif // __SSE2__
+
+#include <math.h>
+
+#include "bs/json.h"
+#include "bs/map.h"
+#include "bs/object.h"
+
+// Finds the first byte of a string which cannot be copied as is: a quote, a backslash or a control
+// character. Shared by the parser and the writer
+static const char *bs_json_string_scan(const char *p, const char *end) {
+#ifdef __SSE2__
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+    for (; end - p >= 16; p += 16) {
+        const __m128i x = _mm_loadu_si128((const __m128i *) p);
+
+        // There is no unsigned comparison, but x <= 0x1f exactly when min(x, 0x1f) is x
+        const __m128i hits = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(x, control), x));
+
+        const unsigned mask = _mm_movemask_epi8(hits);
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif // __SSE2__
+
+    while (p < end && *p != '"' && *p != '\\' && (uint8_t) *p >= 0x20) {
+        p++;
+    }
+    return p;
+}
+
+// Parser
+typedef struct {
+    Bs_Value *data;
+    size_t    count;
+    size_t    capacity;
+} Bs_Json_Values;
+
+typedef struct {
+    Bs *bs;
+
+    const char *begin;
+    const char *p;
+    const char *end;
+
+    size_t depth;
+
+    // The members of the containers being parsed, innermost last
+    Bs_Json_Values members;
+
+    // Strings with escapes and numbers are decoded here rather than in the config buffer, as that
+    // is where the input itself may be
+    Bs_Buffer scratch;
+
+    Bs_Json_Error *error;
+} Bs_Json_Parser;
+
+static bool bs_json_fail(Bs_Json_Parser *p, const char *at, const char *message) {
+    p->error->offset = at - p->begin;
+    p->error->message = message;
+    return false;
+}
+
+static void bs_json_skip_space(Bs_Json_Parser *p) {
+    while (p->p < p->end && (*p->p == ' ' || *p->p == '\n' || *p->p == '\r' || *p->p == '\t')) {
+        p->p++;
+    }
+}
+
+static bool bs_json_parse_literal(Bs_Json_Parser *p, Bs_Sv literal) {
+    if ((size_t) (p->end - p->p) < literal.size || memcmp(p->p, literal.data, literal.size)) {
+        return bs_json_fail(p, p->p, "unexpected character");
+    }
+
+    p->p += literal.size;
+    return true;
+}
+
+static int bs_json_hex(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+// Reads the 4 hex digits after a \u
+static bool bs_json_parse_hex4(Bs_Json_Parser *p, const char *q, uint32_t *codepoint) {
+    if (p->end - q < 4) {
+        return bs_json_fail(p, q, "unterminated string");
+    }
+
+    *codepoint = 0;
+    for (size_t i = 0; i < 4; i++) {
+        const int digit = bs_json_hex(q[i]);
+        if (digit < 0) {
+            return bs_json_fail(p, q + i, "invalid unicode escape");
+        }
+        *codepoint = (*codepoint << 4) | digit;
+    }
+
+    return true;
+}
+
+static void bs_json_push_utf8(Bs *bs, Bs_Buffer *b, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        bs_da_push(bs, b, codepoint);
+    } else if (codepoint < 0x800) {
+        bs_da_push(bs, b, 0xc0 | (codepoint >> 6));
+        bs_da_push(bs, b, 0x80 | (codepoint & 0x3f));
+    } else if (codepoint < 0x10000) {
+        bs_da_push(bs, b, 0xe0 | (codepoint >> 12));
+        bs_da_push(bs, b, 0x80 | ((codepoint >> 6) & 0x3f));
+        bs_da_push(bs, b, 0x80 | (codepoint & 0x3f));
+    } else {
+        bs_da_push(bs, b, 0xf0 | (codepoint >> 18));
+        bs_da_push(bs, b, 0x80 | ((codepoint >> 12) & 0x3f));
+        bs_da_push(bs, b, 0x80 | ((codepoint >> 6) & 0x3f));
+        bs_da_push(bs, b, 0x80 | (codepoint & 0x3f));
+    }
+}
+
+// Decodes the escapes starting at `q` into the scratch buffer, up to the closing quote
+static bool bs_json_parse_escapes(Bs_Json_Parser *p, const char *q) {
+    Bs        *bs = p->bs;
+    Bs_Buffer *b = &p->scratch;
+    while (true) {
+        if (q >= p->end) {
+            return bs_json_fail(p, q, "unterminated string");
+        }
+
+        if (*q == '"') {
+            p->p = q + 1;
+            return true;
+        }
+
+        if (*q != '\\') {
+            return bs_json_fail(p, q, "control character in string");
+        }
+
+        q++;
+        if (q >= p->end) {
+            return bs_json_fail(p, q, "unterminated string");
+        }
+
+        switch (*q++) {
+        case '"':
+            bs_da_push(bs, b, '"');
+            break;
+
+        case '\\':
+            bs_da_push(bs, b, '\\');
+            break;
+
+        case '/':
+            bs_da_push(bs, b, '/');
+            break;
+
+        case 'b':
+            bs_da_push(bs, b, '\b');
+            break;
+
+        case 'f':
+            bs_da_push(bs, b, '\f');
+            break;
+
+        case 'n':
+            bs_da_push(bs, b, '\n');
+            break;
+
+        case 'r':
+            bs_da_push(bs, b, '\r');
+            break;
+
+        case 't':
+            bs_da_push(bs, b, '\t');
+            break;
+
+        case 'u': {
+            uint32_t codepoint;
+            if (!bs_json_parse_hex4(p, q, &codepoint)) {
+                return false;
+            }
+            q += 4;
+
+            if (codepoint >= 0xd800 && codepoint <= 0xdbff) {
+                uint32_t low;
+                if (p->end - q < 2 || q[0] != '\\' || q[1] != 'u' ||
+                    !bs_json_parse_hex4(p, q + 2, &low) || low < 0xdc00 || low > 0xdfff) {
+                    return bs_json_fail(p, q - 6, "unpaired surrogate in string");
+                }
+                q += 6;
+
+                codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (low - 0xdc00);
+            } else if (codepoint >= 0xdc00 && codepoint <= 0xdfff) {
+                return bs_json_fail(p, q - 6, "unpaired surrogate in string");
+            }
+
+            bs_json_push_utf8(bs, b, codepoint);
+        } break;
+
+        default:
+            return bs_json_fail(p, q - 2, "invalid escape in string");
+        }
+
+        const char *run = bs_json_string_scan(q, p->end);
+        bs_da_push_many(bs, b, q, run - q);
+        q = run;
+    }
+}
+
+static bool bs_json_parse_string(Bs_Json_Parser *p, Bs_Value *value) {
+    const char *start = ++p->p;
+    const char *q = bs_json_string_scan(start, p->end);
+
+    // The common case, nothing to decode
+    if (q < p->end && *q == '"') {
+        p->p = q + 1;
+        *value = bs_value_object(bs_str_new(p->bs, Bs_Sv(start, q - start)));
+        return true;
+    }
+
+    p->scratch.count = 0;
+    if (q != start) {
+        bs_da_push_many(p->bs, &p->scratch, start, q - start);
+    }
+
+    if (!bs_json_parse_escapes(p, q)) {
+        return false;
+    }
+
+    *value = bs_value_object(bs_str_new(p->bs, Bs_Sv(p->scratch.data, p->scratch.count)));
+    return true;
+}
+
+static bool bs_json_is_digit(Bs_Json_Parser *p, const char *q) {
+    return q < p->end && *q >= '0' && *q <= '9';
+}
+
+static bool bs_json_parse_number(Bs_Json_Parser *p, Bs_Value *value) {
+    const char *start = p->p;
+    const char *q = start;
+
+    const bool negative = *q == '-';
+    if (negative) {
+        q++;
+    }
+
+    if (!bs_json_is_digit(p, q)) {
+        return bs_json_fail(p, q, "expected digit");
+    }
+
+    if (*q == '0') {
+        q++;
+    } else {
+        while (bs_json_is_digit(p, q)) {
+            q++;
+        }
+    }
+
+    const char *digits_end = q;
+    if (q < p->end && *q == '.') {
+        q++;
+        if (!bs_json_is_digit(p, q)) {
+            return bs_json_fail(p, q, "expected digit");
+        }
+
+        while (bs_json_is_digit(p, q)) {
+            q++;
+        }
+    }
+
+    if (q < p->end && (*q == 'e' || *q == 'E')) {
+        q++;
+        if (q < p->end && (*q == '+' || *q == '-')) {
+            q++;
+        }
+
+        if (!bs_json_is_digit(p, q)) {
+            return bs_json_fail(p, q, "expected digit");
+        }
+
+        while (bs_json_is_digit(p, q)) {
+            q++;
+        }
+    }
+
+    p->p = q;
+
+    // Integers of up to 15 digits are exact in a double, no need for strtod()
+    const char  *digits = start + negative;
+    const size_t digits_count = digits_end - digits;
+    if (digits_end == q && digits_count <= 15) {
+        uint64_t n = 0;
+        for (size_t i = 0; i < digits_count; i++) {
+            n = n * 10 + (digits[i] - '0');
+        }
+
+        *value = bs_value_num(negative ? -(double) n : (double) n);
+        return true;
+    }
+
+    // strtod() needs a terminator, which the input does not necessarily have
+    p->scratch.count = 0;
+    if (q != start) {
+        bs_da_push_many(p->bs, &p->scratch, start, q - start);
+    }
+    bs_da_push(p->bs, &p->scratch, '\0');
+
+    *value = bs_value_num(strtod(p->scratch.data, NULL));
+    return true;
+}
+
+static bool bs_json_parse_value(Bs_Json_Parser *p, Bs_Value *value);
+
+static bool bs_json_enter(Bs_Json_Parser *p) {
+    if (p->depth >= BS_JSON_MAX_DEPTH) {
+        return bs_json_fail(p, p->p, "nesting too deep");
+    }
+
+    p->depth++;
+    p->p++;
+    bs_json_skip_space(p);
+    return true;
+}
+
+// Consumes the separator after a member, returns whether it was the last one
+static bool bs_json_parse_separator(Bs_Json_Parser *p, char close, bool *last, const char *message) {
+    bs_json_skip_space(p);
+    if (p->p >= p->end || (*p->p != ',' && *p->p != close)) {
+        return bs_json_fail(p, p->p, message);
+    }
+
+    *last = *p->p++ == close;
+    return true;
+}
+
+static bool bs_json_parse_array(Bs_Json_Parser *p, Bs_Value *value) {
+    Bs *bs = p->bs;
+    if (!bs_json_enter(p)) {
+        return false;
+    }
+
+    const size_t base = p->members.count;
+    if (p->p < p->end && *p->p == ']') {
+        p->p++;
+    } else {
+        bool last = false;
+        while (!last) {
+            Bs_Value member;
+            if (!bs_json_parse_value(p, &member)) {
+                return false;
+            }
+            bs_da_push(bs, &p->members, member);
+
+            if (!bs_json_parse_separator(p, ']', &last, "expected ',' or ']'")) {
+                return false;
+            }
+        }
+    }
+
+    const size_t count = p->members.count - base;
+
+    Bs_Array *array = bs_array_new(bs);
+    if (count) {
+        array->data = bs_realloc(bs, NULL, 0, count * sizeof(*array->data));
+        array->count = count;
+        array->capacity = count;
+        memcpy(array->data, &p->members.data[base], count * sizeof(*array->data));
+    }
+
+    p->members.count = base;
+    p->depth--;
+
+    *value = bs_value_object(array);
+    return true;
+}
+
+static bool bs_json_parse_object(Bs_Json_Parser *p, Bs_Value *value) {
+    Bs *bs = p->bs;
+    if (!bs_json_enter(p)) {
+        return false;
+    }
+
+    // Keys and values, one after the other
+    const size_t base = p->members.count;
+    if (p->p < p->end && *p->p == '}') {
+        p->p++;
+    } else {
+        bool last = false;
+        while (!last) {
+            bs_json_skip_space(p);
+            if (p->p >= p->end || *p->p != '"') {
+                return bs_json_fail(p, p->p, "expected string key");
+            }
+
+            Bs_Value key;
+            if (!bs_json_parse_string(p, &key)) {
+                return false;
+            }
+            bs_da_push(bs, &p->members, key);
+
+            bs_json_skip_space(p);
+            if (p->p >= p->end || *p->p != ':') {
+                return bs_json_fail(p, p->p, "expected ':'");
+            }
+            p->p++;
+
+            Bs_Value member;
+            if (!bs_json_parse_value(p, &member)) {
+                return false;
+            }
+            bs_da_push(bs, &p->members, member);
+
+            if (!bs_json_parse_separator(p, '}', &last, "expected ',' or '}'")) {
+                return false;
+            }
+        }
+    }
+
+    const size_t count = (p->members.count - base) / 2;
+
+    Bs_Table *table = bs_table_new(bs);
+    bs_map_reserve(bs, &table->map, count);
+    for (size_t i = 0; i < count; i++) {
+        const Bs_Value *entry = &p->members.data[base + i * 2];
+        bs_map_set(bs, &table->map, entry[0], entry[1]);
+    }
+
+    p->members.count = base;
+    p->depth--;
+
+    *value = bs_value_object(table);
+    return true;
+}
+
+static bool bs_json_parse_value(Bs_Json_Parser *p, Bs_Value *value) {
+    bs_json_skip_space(p);
+    if (p->p >= p->end) {
+        return bs_json_fail(p, p->p, "unexpected end of input");
+    }
+
+    switch (*p->p) {
+    case '{':
+        return bs_json_parse_object(p, value);
+
+    case '[':
+        return bs_json_parse_array(p, value);
+
+    case '"':
+        return bs_json_parse_string(p, value);
+
+    case 't':
+        *value = bs_value_bool(true);
+        return bs_json_parse_literal(p, Bs_Sv_Static("true"));
+
+    case 'f':
+        *value = bs_value_bool(false);
+        return bs_json_parse_literal(p, Bs_Sv_Static("false"));
+
+    case 'n':
+        *value = bs_value_nil;
+        return bs_json_parse_literal(p, Bs_Sv_Static("null"));
+
+    default:
+        if (*p->p == '-' || (*p->p >= '0' && *p->p <= '9')) {
+            return bs_json_parse_number(p, value);
+        }
+        return bs_json_fail(p, p->p, "unexpected character");
+    }
+}
+
+bool bs_json_parse(Bs *bs, Bs_Sv input, Bs_Value *value, Bs_Json_Error *error) {
+    Bs_Json_Parser p = {
+        .bs = bs,
+        .begin = input.data,
+        .p = input.data,
+        .end = input.data + input.size,
+        .error = error,
+    };
+
+    bool ok = bs_json_parse_value(&p, value);
+    if (ok) {
+        bs_json_skip_space(&p);
+        if (p.p < p.end) {
+            ok = bs_json_fail(&p, p.p, "expected end of input");
+        }
+    }
+
+    bs_da_free(bs, &p.members);
+    bs_da_free(bs, &p.scratch);
+    return ok;
+}
+
+// Writer
+typedef struct {
+    Bs        *bs;
+    Bs_Writer *w;
+    size_t     indent;
+    size_t     depth;
+} Bs_Json_Writer;
+
+static void bs_json_write_value(Bs_Json_Writer *j, Bs_Value value);
+
+static void bs_json_write_newline(Bs_Json_Writer *j) {
+    if (!j->indent) {
+        return;
+    }
+
+    static const char spaces[] = "                                ";
+
+    j->w->write(j->w, Bs_Sv_Static("\n"));
+    for (size_t n = j->depth * j->indent; n;) {
+        const size_t count = bs_min(n, sizeof(spaces) - 1);
+        j->w->write(j->w, Bs_Sv(spaces, count));
+        n -= count;
+    }
+}
+
+static void bs_json_write_number(Bs_Json_Writer *j, double number) {
+    if (!isfinite(number)) {
+        bs_error(j->bs, "cannot convert %s to JSON", isnan(number) ? "nan" : "infinity");
+    }
+
+    // The fewest digits which read back as the same number, 17 always do
+    char data[32];
+    for (int precision = 15; precision <= 17; precision++) {
+        snprintf(data, sizeof(data), "%.*g", precision, number);
+        if (strtod(data, NULL) == number) {
+            break;
+        }
+    }
+
+    j->w->write(j->w, bs_sv_from_cstr(data));
+}
+
+static void bs_json_write_string(Bs_Json_Writer *j, Bs_Sv s) {
+    Bs_Writer *w = j->w;
+    w->write(w, Bs_Sv_Static("\""));
+
+    const char *p = s.data;
+    const char *end = s.data + s.size;
+    while (true) {
+        const char *q = bs_json_string_scan(p, end);
+        if (q != p) {
+            w->write(w, Bs_Sv(p, q - p));
+        }
+
+        if (q == end) {
+            break;
+        }
+
+        switch (*q) {
+        case '"':
+            w->write(w, Bs_Sv_Static("\\\""));
+            break;
+
+        case '\\':
+            w->write(w, Bs_Sv_Static("\\\\"));
+            break;
+
+        case '\b':
+            w->write(w, Bs_Sv_Static("\\b"));
+            break;
+
+        case '\f':
+            w->write(w, Bs_Sv_Static("\\f"));
+            break;
+
+        case '\n':
+            w->write(w, Bs_Sv_Static("\\n"));
+            break;
+
+        case '\r':
+            w->write(w, Bs_Sv_Static("\\r"));
+            break;
+
+        case '\t':
+            w->write(w, Bs_Sv_Static("\\t"));
+            break;
+
+        default:
+            bs_fmt(w, "\\u%04x", (uint8_t) *q);
+            break;
+        }
+
+        p = q + 1;
+    }
+
+    w->write(w, Bs_Sv_Static("\""));
+}
+
+static void bs_json_enter_container(Bs_Json_Writer *j) {
+    if (j->depth >= BS_JSON_MAX_DEPTH) {
+        bs_error(j->bs, "cannot convert value nested deeper than %d levels to JSON", BS_JSON_MAX_DEPTH);
+    }
+    j->depth++;
+}
+
+static void bs_json_write_array(Bs_Json_Writer *j, const Bs_Array *array) {
+    if (!array->count) {
+        j->w->write(j->w, Bs_Sv_Static("[]"));
+        return;
+    }
+
+    bs_json_enter_container(j);
+    j->w->write(j->w, Bs_Sv_Static("["));
+
+    for (size_t i = 0; i < array->count; i++) {
+        if (i) {
+            j->w->write(j->w, Bs_Sv_Static(","));
+        }
+
+        bs_json_write_newline(j);
+        bs_json_write_value(j, array->data[i]);
+    }
+
+    j->depth--;
+    bs_json_write_newline(j);
+    j->w->write(j->w, Bs_Sv_Static("]"));
+}
+
+static void bs_json_write_map(Bs_Json_Writer *j, const Bs_Map *map) {
+    if (!map->length) {
+        j->w->write(j->w, Bs_Sv_Static("{}"));
+        return;
+    }
+
+    bs_json_enter_container(j);
+    j->w->write(j->w, Bs_Sv_Static("{"));
+
+    bool first = true;
+    for (size_t i = 0; i < map->capacity; i++) {
+        const Bs_Entry *entry = &map->data[i];
+        if (entry->key.type == BS_VALUE_NIL) {
+            continue;
+        }
+
+        if (entry->key.type != BS_VALUE_OBJECT || entry->key.as.object->type != BS_OBJECT_STR) {
+            const Bs_Sv sv = bs_value_type_name_full(entry->key);
+            bs_error(
+                j->bs, "expected JSON object keys to be strings, got " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
+        }
+
+        if (!first) {
+            j->w->write(j->w, Bs_Sv_Static(","));
+        }
+        first = false;
+
+        bs_json_write_newline(j);
+
+        const Bs_Str *key = (const Bs_Str *) entry->key.as.object;
+        bs_json_write_string(j, Bs_Sv(key->data, key->size));
+        j->w->write(j->w, j->indent ? Bs_Sv_Static(": ") : Bs_Sv_Static(":"));
+        bs_json_write_value(j, entry->value);
+    }
+
+    j->depth--;
+    bs_json_write_newline(j);
+    j->w->write(j->w, Bs_Sv_Static("}"));
+}
+
+static void bs_json_write_value(Bs_Json_Writer *j, Bs_Value value) {
+    switch (value.type) {
+    case BS_VALUE_NIL:
+        j->w->write(j->w, Bs_Sv_Static("null"));
+        return;
+
+    case BS_VALUE_NUM:
+        bs_json_write_number(j, value.as.number);
+        return;
+
+    case BS_VALUE_BOOL:
+        j->w->write(j->w, value.as.boolean ? Bs_Sv_Static("true") : Bs_Sv_Static("false"));
+        return;
+
+    case BS_VALUE_OBJECT:
+        switch (value.as.object->type) {
+        case BS_OBJECT_STR: {
+            const Bs_Str *str = (const Bs_Str *) value.as.object;
+            bs_json_write_string(j, Bs_Sv(str->data, str->size));
+            return;
+        }
+
+        case BS_OBJECT_ARRAY:
+            bs_json_write_array(j, (const Bs_Array *) value.as.object);
+            return;
+
+        case BS_OBJECT_TABLE:
+            bs_json_write_map(j, &((const Bs_Table *) value.as.object)->map);
+            return;
+
+        case BS_OBJECT_INSTANCE:
+            bs_json_write_map(j, &((const Bs_Instance *) value.as.object)->properties);
+            return;
+
+        default:
+            break;
+        }
+        break;
+    }
+
+    const Bs_Sv sv = bs_value_type_name_full(value);
+    bs_error(j->bs, "cannot convert " Bs_Sv_Fmt " to JSON", Bs_Sv_Arg(sv));
+}
+
+void bs_json_write(Bs *bs, Bs_Writer *writer, Bs_Value value, size_t indent) {
+    Bs_Json_Writer j = {
+        .bs = bs,
+        .w = writer,
+        .indent = indent,
+    };
+
+    bs_json_write_value(&j, value);
+}
@@ -157,6 +157,19 @@ static void bs_map_grow(Bs *bs, Bs_Map *m, size_t capacity) {
     m->capacity = capacity;
 }
 
+void bs_map_reserve(Bs *bs, Bs_Map *m, size_t count) {
+    const size_t needed = m->count + count;
+
+    size_t capacity = m->capacity ? m->capacity : BS_DA_INIT_CAP;
+    while (needed > capacity * BS_MAP_MAX_LOAD) {
+        capacity *= 2;
+    }
+
+    if (capacity != m->capacity) {
+        bs_map_grow(bs, m, capacity);
+    }
+}
+
 bool bs_map_set(Bs *bs, Bs_Map *m, Bs_Value key, Bs_Value value) {
     if (m->count >= m->capacity * BS_MAP_MAX_LOAD) {
         bs_map_grow(bs, m, m->capacity ? m->capacity * 2 : BS_DA_INIT_CAP);
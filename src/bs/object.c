@@ -1,3 +1,5 @@
+#include <assert.h>
+
 #include "bs/object.h"
 
 void bs_chunk_free(Bs *bs, Bs_Chunk *c) {
@@ -30,6 +32,61 @@ void bs_chunk_push_op_value(Bs *bs, Bs_Chunk *c, Bs_Op op, Bs_Value value) {
     bs_da_push_many(bs, c, &index, bytes);
 }
 
+static_assert(BS_COUNT_OPS == 105, "Update bs_chunk_op_size()");
+size_t bs_chunk_op_size(const Bs_Chunk *c, size_t offset) {
+    switch (bs_op_generic(c->data[offset])) {
+    case BS_OP_CLOSURE: {
+        const size_t constant = *(const size_t *) &c->data[offset + 1];
+        const Bs_Fn *fn = (const Bs_Fn *) c->constants.data[constant].as.object;
+        return 1 + sizeof(size_t) + fn->upvalues * (1 + sizeof(size_t));
+    }
+
+    case BS_OP_DUP:
+    case BS_OP_INIT_METHOD:
+    case BS_OP_APPEND:
+    case BS_OP_RANGE_INIT:
+        return 2;
+
+    case BS_OP_ITER:
+        return 2 + sizeof(size_t);
+
+    case BS_OP_DEFER_INVOKE:
+        return 2 + 2 * sizeof(size_t);
+
+    case BS_OP_CONST:
+    case BS_OP_CLASS:
+    case BS_OP_INVOKE:
+    case BS_OP_METHOD:
+    case BS_OP_SUPER_GET:
+    case BS_OP_SUPER_INVOKE:
+    case BS_OP_DELETE_CONST:
+    case BS_OP_GDEF:
+    case BS_OP_GGET:
+    case BS_OP_GSET:
+    case BS_OP_GCONST:
+    case BS_OP_LGET:
+    case BS_OP_LSET:
+    case BS_OP_UGET:
+    case BS_OP_USET:
+    case BS_OP_LRECEIVER:
+    case BS_OP_URECEIVER:
+    case BS_OP_IGET_CONST:
+    case BS_OP_ISET_CONST:
+    case BS_OP_JUMP:
+    case BS_OP_ELSE:
+    case BS_OP_THEN:
+    case BS_OP_MATCH:
+    case BS_OP_MATCH_IF:
+    case BS_OP_MATCH_TABLE:
+    case BS_OP_RANGE:
+    case BS_OP_IRANGE:
+        return 1 + sizeof(size_t);
+
+    default:
+        return 1;
+    }
+}
+
 Bs_Fn *bs_fn_new(Bs *bs) {
     Bs_Fn *fn = (Bs_Fn *)bs_object_new(bs, BS_OBJECT_FN, sizeof(Bs_Fn));
     fn->chunk = (Bs_Chunk){0};
@@ -39,6 +96,9 @@ Bs_Fn *bs_fn_new(Bs *bs) {
     fn->arity = 0;
     fn->variadic = false;
     fn->upvalues = 0;
+    fn->closure = NULL;
+    fn->jit = NULL;
+    fn->hotness = 0;
 
     fn->source = NULL;
     fn->compiled_in_module = 0;
@@ -109,16 +169,13 @@ bool bs_table_set(Bs *bs, Bs_Table *t, Bs_Value key, Bs_Value value) {
 }
 
 Bs_Closure *bs_closure_new(Bs *bs, Bs_Fn *fn) {
-    const size_t upvalues = sizeof(Bs_Upvalue *) * fn->upvalues;
+    const size_t upvalues = sizeof(Bs_Value) * fn->upvalues;
     Bs_Closure *closure =
         (Bs_Closure *)bs_object_new(bs, BS_OBJECT_CLOSURE, sizeof(Bs_Closure) + upvalues);
 
     closure->fn = fn;
     closure->upvalues = fn->upvalues;
 
-    closure->defers = (Bs_Defers){0};
-    closure->defer_started = false;
-
     memset(closure->data, 0, upvalues);
     return closure;
 }
@@ -157,6 +214,11 @@ Bs_C_Class *bs_c_class_new(Bs *bs, Bs_Sv name, size_t size, Bs_C_Fn_Ptr init) {
     class->free = NULL;
     class->mark = NULL;
     class->show = NULL;
+    class->next = NULL;
+    class->count = NULL;
+    class->get = NULL;
+    class->set = NULL;
+    class->shared = bs_value_nil;
     class->can_fail = false;
     memset(&class->methods, '\0', sizeof(class->methods));
     return class;
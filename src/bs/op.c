@@ -2,7 +2,7 @@
 
 #include "bs/op.h"
 
-static_assert(BS_COUNT_OPS == 77, "Update bs_op_get_to_set()");
+static_assert(BS_COUNT_OPS == 105, "Update bs_op_get_to_set()");
 Bs_Op bs_op_get_to_set(Bs_Op op) {
     switch (op) {
     case BS_OP_GGET:
@@ -24,3 +24,175 @@ Bs_Op bs_op_get_to_set(Bs_Op op) {
         return BS_OP_RET;
     }
 }
+
+static_assert(BS_COUNT_OPS == 105, "Update bs_op_generic()");
+Bs_Op bs_op_generic(Bs_Op op) {
+    switch (op) {
+    case BS_OP_ADD_NUM:
+        return BS_OP_ADD;
+
+    case BS_OP_SUB_NUM:
+        return BS_OP_SUB;
+
+    case BS_OP_MUL_NUM:
+        return BS_OP_MUL;
+
+    case BS_OP_DIV_NUM:
+        return BS_OP_DIV;
+
+    case BS_OP_GT_NUM:
+        return BS_OP_GT;
+
+    case BS_OP_GE_NUM:
+        return BS_OP_GE;
+
+    case BS_OP_LT_NUM:
+        return BS_OP_LT;
+
+    case BS_OP_LE_NUM:
+        return BS_OP_LE;
+
+    case BS_OP_IGET_ARRAY_INDEX:
+        return BS_OP_IGET;
+
+    case BS_OP_ITER_ARRAY:
+    case BS_OP_ITER_STR:
+    case BS_OP_ITER_MAP:
+        return BS_OP_ITER;
+
+    case BS_OP_INVOKE_INSTANCE:
+        return BS_OP_INVOKE;
+
+    case BS_OP_LGET_LGET_ADD:
+    case BS_OP_LGET_CONST_LT_ELSE:
+    case BS_OP_LGET_IGET_CONST:
+    case BS_OP_INCR_LOCAL:
+    case BS_OP_REG_BINARY:
+    case BS_OP_REG_BINARY_SET:
+    case BS_OP_REG_BINARY_ELSE:
+    case BS_OP_REG_TOP:
+    case BS_OP_REG_TOP_SET:
+    case BS_OP_REG_MOVE:
+        return BS_OP_LGET;
+
+    case BS_OP_REG_LOAD:
+        return BS_OP_CONST;
+
+    default:
+        return op;
+    }
+}
+
+static_assert(BS_COUNT_OPS == 105, "Update bs_op_names[]");
+static const char *bs_op_names[BS_COUNT_OPS] = {
+    [BS_OP_RET]                = "OP_RET",
+    [BS_OP_CALL]               = "OP_CALL",
+    [BS_OP_TAIL_CALL]          = "OP_TAIL_CALL",
+    [BS_OP_DEFER]              = "OP_DEFER",
+    [BS_OP_DEFER_INVOKE]       = "OP_DEFER_INVOKE",
+    [BS_OP_SPREAD]             = "OP_SPREAD",
+    [BS_OP_CLOSURE]            = "OP_CLOSURE",
+    [BS_OP_CALL_INIT]          = "OP_CALL_INIT",
+    [BS_OP_DUP]                = "OP_DUP",
+    [BS_OP_DROP]               = "OP_DROP",
+    [BS_OP_UCLOSE]             = "OP_UCLOSE",
+    [BS_OP_NIL]                = "OP_NIL",
+    [BS_OP_TRUE]               = "OP_TRUE",
+    [BS_OP_FALSE]              = "OP_FALSE",
+    [BS_OP_ARRAY]              = "OP_ARRAY",
+    [BS_OP_TABLE]              = "OP_TABLE",
+    [BS_OP_CONST]              = "OP_CONST",
+    [BS_OP_CLASS]              = "OP_CLASS",
+    [BS_OP_INVOKE]             = "OP_INVOKE",
+    [BS_OP_METHOD]             = "OP_METHOD",
+    [BS_OP_INIT_METHOD]        = "OP_INIT_METHOD",
+    [BS_OP_INHERIT]            = "OP_INHERIT",
+    [BS_OP_SUPER_GET]          = "OP_SUPER_GET",
+    [BS_OP_SUPER_INVOKE]       = "OP_SUPER_INVOKE",
+    [BS_OP_ADD]                = "OP_ADD",
+    [BS_OP_SUB]                = "OP_SUB",
+    [BS_OP_MUL]                = "OP_MUL",
+    [BS_OP_DIV]                = "OP_DIV",
+    [BS_OP_MOD]                = "OP_MOD",
+    [BS_OP_NEG]                = "OP_NEG",
+    [BS_OP_BOR]                = "OP_BOR",
+    [BS_OP_BAND]               = "OP_BAND",
+    [BS_OP_BXOR]               = "OP_BXOR",
+    [BS_OP_BNOT]               = "OP_BNOT",
+    [BS_OP_LNOT]               = "OP_LNOT",
+    [BS_OP_SHL]                = "OP_SHL",
+    [BS_OP_SHR]                = "OP_SHR",
+    [BS_OP_GT]                 = "OP_GT",
+    [BS_OP_GE]                 = "OP_GE",
+    [BS_OP_LT]                 = "OP_LT",
+    [BS_OP_LE]                 = "OP_LE",
+    [BS_OP_EQ]                 = "OP_EQ",
+    [BS_OP_NE]                 = "OP_NE",
+    [BS_OP_IN]                 = "OP_IN",
+    [BS_OP_IS]                 = "OP_IS",
+    [BS_OP_LEN]                = "OP_LEN",
+    [BS_OP_JOIN]               = "OP_JOIN",
+    [BS_OP_TOSTR]              = "OP_TOSTR",
+    [BS_OP_PANIC]              = "OP_PANIC",
+    [BS_OP_ASSERT]             = "OP_ASSERT",
+    [BS_OP_IMPORT]             = "OP_IMPORT",
+    [BS_OP_TYPEOF]             = "OP_TYPEOF",
+    [BS_OP_CLASSOF]            = "OP_CLASSOF",
+    [BS_OP_APPEND]             = "OP_APPEND",
+    [BS_OP_DELETE]             = "OP_DELETE",
+    [BS_OP_DELETE_CONST]       = "OP_DELETE_CONST",
+    [BS_OP_GDEF]               = "OP_GDEF",
+    [BS_OP_GGET]               = "OP_GGET",
+    [BS_OP_GSET]               = "OP_GSET",
+    [BS_OP_GCONST]             = "OP_GCONST",
+    [BS_OP_LGET]               = "OP_LGET",
+    [BS_OP_LSET]               = "OP_LSET",
+    [BS_OP_UGET]               = "OP_UGET",
+    [BS_OP_USET]               = "OP_USET",
+    [BS_OP_LRECEIVER]          = "OP_LRECEIVER",
+    [BS_OP_URECEIVER]          = "OP_URECEIVER",
+    [BS_OP_IGET]               = "OP_IGET",
+    [BS_OP_ISET]               = "OP_ISET",
+    [BS_OP_IGET_CONST]         = "OP_IGET_CONST",
+    [BS_OP_ISET_CONST]         = "OP_ISET_CONST",
+    [BS_OP_ISET_CHAIN]         = "OP_ISET_CHAIN",
+    [BS_OP_JUMP]               = "OP_JUMP",
+    [BS_OP_ELSE]               = "OP_ELSE",
+    [BS_OP_THEN]               = "OP_THEN",
+    [BS_OP_MATCH]              = "OP_MATCH",
+    [BS_OP_MATCH_IF]           = "OP_MATCH_IF",
+    [BS_OP_MATCH_TABLE]        = "OP_MATCH_TABLE",
+    [BS_OP_ITER]               = "OP_ITER",
+    [BS_OP_RANGE]              = "OP_RANGE",
+    [BS_OP_IRANGE]             = "OP_IRANGE",
+    [BS_OP_RANGE_INIT]         = "OP_RANGE_INIT",
+    [BS_OP_ADD_NUM]            = "OP_ADD_NUM",
+    [BS_OP_SUB_NUM]            = "OP_SUB_NUM",
+    [BS_OP_MUL_NUM]            = "OP_MUL_NUM",
+    [BS_OP_DIV_NUM]            = "OP_DIV_NUM",
+    [BS_OP_GT_NUM]             = "OP_GT_NUM",
+    [BS_OP_GE_NUM]             = "OP_GE_NUM",
+    [BS_OP_LT_NUM]             = "OP_LT_NUM",
+    [BS_OP_LE_NUM]             = "OP_LE_NUM",
+    [BS_OP_IGET_ARRAY_INDEX]   = "OP_IGET_ARRAY_INDEX",
+    [BS_OP_ITER_ARRAY]         = "OP_ITER_ARRAY",
+    [BS_OP_ITER_STR]           = "OP_ITER_STR",
+    [BS_OP_ITER_MAP]           = "OP_ITER_MAP",
+    [BS_OP_INVOKE_INSTANCE]    = "OP_INVOKE_INSTANCE",
+    [BS_OP_LGET_LGET_ADD]      = "OP_LGET_LGET_ADD",
+    [BS_OP_LGET_CONST_LT_ELSE] = "OP_LGET_CONST_LT_ELSE",
+    [BS_OP_LGET_IGET_CONST]    = "OP_LGET_IGET_CONST",
+    [BS_OP_INCR_LOCAL]         = "OP_INCR_LOCAL",
+    [BS_OP_REG_BINARY]         = "OP_REG_BINARY",
+    [BS_OP_REG_BINARY_SET]     = "OP_REG_BINARY_SET",
+    [BS_OP_REG_BINARY_ELSE]    = "OP_REG_BINARY_ELSE",
+    [BS_OP_REG_TOP]            = "OP_REG_TOP",
+    [BS_OP_REG_TOP_SET]        = "OP_REG_TOP_SET",
+    [BS_OP_REG_MOVE]           = "OP_REG_MOVE",
+    [BS_OP_REG_LOAD]           = "OP_REG_LOAD",
+};
+
+const char *bs_op_name(Bs_Op op) {
+    assert(op < BS_COUNT_OPS);
+    return bs_op_names[op];
+}
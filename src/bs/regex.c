@@ -0,0 +1,1279 @@
+#include <assert.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bs/map.h"
+#include "bs/regex.h"
+
+// The limits past which a pattern is rejected
+#define BS_REGEX_MAX_DEPTH  256
+#define BS_REGEX_MAX_REPEAT 255
+#define BS_REGEX_MAX_INSTS  (64 * 1024)
+
+// The number of DFA states a regex keeps. Once it is reached they are all thrown away, and the DFA
+// is built again from where the search is
+#define BS_REGEX_MAX_STATES 2048
+
+// Program
+typedef enum {
+    BS_REGEX_CLASS,  // Consume a byte in set x
+    BS_REGEX_SPLIT,  // Continue at both x and y, x taking priority
+    BS_REGEX_JUMP,   // Continue at x
+    BS_REGEX_SAVE,   // Record the position in slot x
+    BS_REGEX_ASSERT, // Continue if assertion x holds at the position
+    BS_REGEX_MATCH,
+} Bs_Regex_Op;
+
+typedef enum {
+    BS_REGEX_BEGIN,      // ^
+    BS_REGEX_END,        // $
+    BS_REGEX_WORD,       // \b
+    BS_REGEX_NOT_WORD,   // \B
+    BS_REGEX_WORD_BEGIN, // \<
+    BS_REGEX_WORD_END,   // \>
+} Bs_Regex_Assert;
+
+typedef struct {
+    Bs_Regex_Op op;
+    uint32_t    x;
+    uint32_t    y;
+} Bs_Regex_Inst;
+
+typedef struct {
+    Bs_Regex_Inst *data;
+    size_t         count;
+    size_t         capacity;
+} Bs_Regex_Insts;
+
+typedef struct {
+    uint8_t bits[32];
+} Bs_Regex_Set;
+
+typedef struct {
+    Bs_Regex_Set *data;
+    size_t        count;
+    size_t        capacity;
+} Bs_Regex_Sets;
+
+static void bs_regex_set_add(Bs_Regex_Set *set, uint8_t ch) {
+    set->bits[ch >> 3] |= 1 << (ch & 7);
+}
+
+static bool bs_regex_set_has(const Bs_Regex_Set *set, uint8_t ch) {
+    return (set->bits[ch >> 3] >> (ch & 7)) & 1;
+}
+
+static bool bs_regex_isword(uint8_t ch) {
+    return isalnum(ch) || ch == '_';
+}
+
+// What the assertions can see around a position
+typedef struct {
+    bool begin;
+    bool end;
+    bool prev_word;
+    bool next_word;
+} Bs_Regex_Context;
+
+static Bs_Regex_Context bs_regex_context(Bs_Sv text, size_t at) {
+    return (Bs_Regex_Context){
+        .begin = at == 0,
+        .end = at == text.size,
+        .prev_word = at && bs_regex_isword(text.data[at - 1]),
+        .next_word = at < text.size && bs_regex_isword(text.data[at]),
+    };
+}
+
+static bool bs_regex_holds(Bs_Regex_Assert assert, const Bs_Regex_Context *context) {
+    switch (assert) {
+    case BS_REGEX_BEGIN:
+        return context->begin;
+
+    case BS_REGEX_END:
+        return context->end;
+
+    case BS_REGEX_WORD:
+        return context->prev_word != context->next_word;
+
+    case BS_REGEX_NOT_WORD:
+        return context->prev_word == context->next_word;
+
+    case BS_REGEX_WORD_BEGIN:
+        return !context->prev_word && context->next_word;
+
+    case BS_REGEX_WORD_END:
+        return context->prev_word && !context->next_word;
+    }
+
+    assert(false && "unreachable");
+    return false;
+}
+
+// Sets of program counters which are cleared in constant time
+typedef struct {
+    uint32_t *dense;
+    uint32_t *sparse;
+    size_t    count;
+} Bs_Regex_Pcs;
+
+static bool bs_regex_pcs_has(const Bs_Regex_Pcs *pcs, uint32_t pc) {
+    const uint32_t i = pcs->sparse[pc];
+    return i < pcs->count && pcs->dense[i] == pc;
+}
+
+static void bs_regex_pcs_add(Bs_Regex_Pcs *pcs, uint32_t pc) {
+    pcs->sparse[pc] = pcs->count;
+    pcs->dense[pcs->count++] = pc;
+}
+
+// Lazy DFA
+//
+// A state is the set of instructions the threads are at, which are the ones that consume a byte,
+// the match, and the assertions. Whether an assertion holds depends on the byte which comes next,
+// so they are only followed once the transition on that byte is taken. What came before is kept
+// in the flags
+#define BS_REGEX_AT_BEGIN  1
+#define BS_REGEX_PREV_WORD 2
+#define BS_REGEX_QUIET     4 // No thread which started before the position is alive
+
+// Transitions are encoded as the index of the next state shifted left by two, along with
+#define BS_REGEX_MATCHED 1 // A match ends right before the byte
+#define BS_REGEX_DEAD    2 // The next state has no threads, so no match is possible
+
+#define BS_REGEX_UNKNOWN -1
+#define BS_REGEX_EOT     256 // The transition taken at the end of the text
+
+typedef struct {
+    uint32_t hash;
+    uint32_t flags;
+    int32_t  next[257];
+
+    uint32_t count;
+    uint32_t pcs[];
+} Bs_Regex_State;
+
+typedef struct {
+    Bs_Regex_State **data;
+    size_t           count;
+    size_t           capacity;
+} Bs_Regex_States;
+
+// Pike VM
+typedef struct {
+    Bs_Regex_Pcs visited;
+
+    // The threads in order of priority, and the slots of each
+    uint32_t *pcs;
+    size_t   *slots;
+    size_t    count;
+} Bs_Regex_Threads;
+
+// Frames of the explicit stack used to add threads. A pc of BS_REGEX_RESTORE puts a slot back to
+// its value from before the SAVE instruction
+#define BS_REGEX_RESTORE UINT32_MAX
+
+typedef struct {
+    uint32_t pc;
+    uint32_t slot;
+    size_t   value;
+} Bs_Regex_Frame;
+
+struct Bs_Regex {
+    Bs *bs;
+
+    Bs_Regex_Insts insts;
+    Bs_Regex_Sets  sets;
+    size_t         groups;
+
+    // Every match starts with ^, so there is no point in looking past the beginning
+    bool anchored;
+
+    // The flags which the assertions of the program need to see
+    uint32_t tracked;
+
+    Bs_Regex_States states;
+    int32_t        *table;
+    size_t          table_capacity;
+    int32_t         initial[4];
+    size_t          generation;
+
+    // Scratch space, sized after the program
+    Bs_Regex_Pcs      closure[2];
+    uint32_t         *stack;
+    uint32_t         *key;
+    Bs_Regex_Threads  threads[2];
+    Bs_Regex_Frame   *frames;
+    size_t           *slots;
+    size_t           *best;
+};
+
+// Parser
+typedef enum {
+    BS_REGEX_NODE_SET,    // a = set
+    BS_REGEX_NODE_ASSERT, // a = assertion
+    BS_REGEX_NODE_CAT,    // a = first child
+    BS_REGEX_NODE_ALT,    // a = first child
+    BS_REGEX_NODE_REPEAT, // a = child
+    BS_REGEX_NODE_GROUP,  // a = child, b = group
+} Bs_Regex_Node_Kind;
+
+#define BS_REGEX_INFINITY UINT32_MAX
+#define BS_REGEX_NIL      UINT32_MAX
+
+typedef struct {
+    Bs_Regex_Node_Kind kind;
+    uint32_t           a;
+    uint32_t           b;
+    uint32_t           min;
+    uint32_t           max;
+
+    // The next child of the parent, which keeps long sequences and alternations off the C stack
+    uint32_t next;
+} Bs_Regex_Node;
+
+typedef struct {
+    Bs_Regex_Node *data;
+    size_t         count;
+    size_t         capacity;
+} Bs_Regex_Nodes;
+
+typedef struct {
+    Bs_Regex *regex;
+    bool      error;
+
+    Bs_Sv  pattern;
+    size_t pos;
+    size_t depth;
+
+    Bs_Regex_Nodes nodes;
+} Bs_Regex_Parser;
+
+static uint32_t bs_regex_node(Bs_Regex_Parser *p, Bs_Regex_Node_Kind kind, uint32_t a, uint32_t b) {
+    const Bs_Regex_Node node = {.kind = kind, .a = a, .b = b, .next = BS_REGEX_NIL};
+    bs_da_push(p->regex->bs, &p->nodes, node);
+    return p->nodes.count - 1;
+}
+
+static uint32_t bs_regex_node_set(Bs_Regex_Parser *p, const Bs_Regex_Set *set) {
+    bs_da_push(p->regex->bs, &p->regex->sets, *set);
+    return bs_regex_node(p, BS_REGEX_NODE_SET, p->regex->sets.count - 1, 0);
+}
+
+static uint32_t bs_regex_node_byte(Bs_Regex_Parser *p, uint8_t ch) {
+    Bs_Regex_Set set = {0};
+    bs_regex_set_add(&set, ch);
+    return bs_regex_node_set(p, &set);
+}
+
+static uint32_t bs_regex_fail(Bs_Regex_Parser *p) {
+    p->error = true;
+    return BS_REGEX_NIL;
+}
+
+static bool bs_regex_peek(const Bs_Regex_Parser *p, char ch) {
+    return p->pos < p->pattern.size && p->pattern.data[p->pos] == ch;
+}
+
+static void bs_regex_class_add(Bs_Regex_Set *set, int (*is)(int)) {
+    for (int ch = 0; ch < 256; ch++) {
+        if (is(ch)) {
+            bs_regex_set_add(set, ch);
+        }
+    }
+}
+
+static void bs_regex_set_negate(Bs_Regex_Set *set) {
+    for (size_t i = 0; i < bs_c_array_size(set->bits); i++) {
+        set->bits[i] = ~set->bits[i];
+    }
+}
+
+static int bs_regex_isword_class(int ch) {
+    return bs_regex_isword(ch);
+}
+
+static const struct {
+    const char *name;
+    int (*is)(int);
+} bs_regex_classes[] = {
+    {"alnum", isalnum},
+    {"alpha", isalpha},
+    {"blank", isblank},
+    {"cntrl", iscntrl},
+    {"digit", isdigit},
+    {"graph", isgraph},
+    {"lower", islower},
+    {"print", isprint},
+    {"punct", ispunct},
+    {"space", isspace},
+    {"upper", isupper},
+    {"xdigit", isxdigit},
+};
+
+// A single byte of a bracket expression, which can also be written as [.c.] or [=c=]
+static bool bs_regex_parse_bracket_byte(Bs_Regex_Parser *p, uint8_t *ch) {
+    const Bs_Sv s = p->pattern;
+    if (p->pos + 1 < s.size && s.data[p->pos] == '[' &&
+        (s.data[p->pos + 1] == '.' || s.data[p->pos + 1] == '=')) {
+        const char kind = s.data[p->pos + 1];
+        if (p->pos + 4 >= s.size || s.data[p->pos + 3] != kind || s.data[p->pos + 4] != ']') {
+            return false;
+        }
+
+        *ch = s.data[p->pos + 2];
+        p->pos += 5;
+        return true;
+    }
+
+    if (p->pos >= s.size) {
+        return false;
+    }
+
+    *ch = s.data[p->pos++];
+    return true;
+}
+
+// Inside the brackets, after the [
+static uint32_t bs_regex_parse_bracket(Bs_Regex_Parser *p) {
+    const Bs_Sv s = p->pattern;
+
+    Bs_Regex_Set set = {0};
+
+    const bool negate = bs_regex_peek(p, '^');
+    if (negate) {
+        p->pos++;
+    }
+
+    // A ] right at the start is taken literally
+    bool first = true;
+    while (true) {
+        if (p->pos >= s.size) {
+            return bs_regex_fail(p);
+        }
+
+        if (s.data[p->pos] == ']' && !first) {
+            p->pos++;
+            break;
+        }
+        first = false;
+
+        if (p->pos + 1 < s.size && s.data[p->pos] == '[' && s.data[p->pos + 1] == ':') {
+            const size_t start = p->pos + 2;
+
+            size_t end = start;
+            while (end + 1 < s.size && !(s.data[end] == ':' && s.data[end + 1] == ']')) {
+                end++;
+            }
+
+            if (end + 1 >= s.size) {
+                return bs_regex_fail(p);
+            }
+
+            const Bs_Sv name = Bs_Sv(s.data + start, end - start);
+
+            bool found = false;
+            for (size_t i = 0; i < bs_c_array_size(bs_regex_classes); i++) {
+                if (bs_sv_eq(name, bs_sv_from_cstr(bs_regex_classes[i].name))) {
+                    bs_regex_class_add(&set, bs_regex_classes[i].is);
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found) {
+                return bs_regex_fail(p);
+            }
+
+            p->pos = end + 2;
+            continue;
+        }
+
+        uint8_t lo;
+        if (!bs_regex_parse_bracket_byte(p, &lo)) {
+            return bs_regex_fail(p);
+        }
+
+        // A - right before the ] is taken literally
+        uint8_t hi = lo;
+        if (p->pos + 1 < s.size && s.data[p->pos] == '-' && s.data[p->pos + 1] != ']') {
+            p->pos++;
+            if (!bs_regex_parse_bracket_byte(p, &hi) || hi < lo) {
+                return bs_regex_fail(p);
+            }
+        }
+
+        for (size_t ch = lo; ch <= hi; ch++) {
+            bs_regex_set_add(&set, ch);
+        }
+    }
+
+    if (negate) {
+        bs_regex_set_negate(&set);
+    }
+
+    return bs_regex_node_set(p, &set);
+}
+
+static uint32_t bs_regex_parse_escape(Bs_Regex_Parser *p) {
+    if (p->pos >= p->pattern.size) {
+        return bs_regex_fail(p);
+    }
+
+    const char ch = p->pattern.data[p->pos++];
+
+    Bs_Regex_Set set = {0};
+    switch (ch) {
+    case 'w':
+    case 'W':
+        bs_regex_class_add(&set, bs_regex_isword_class);
+        break;
+
+    case 's':
+    case 'S':
+        bs_regex_class_add(&set, isspace);
+        break;
+
+    case 'd':
+    case 'D':
+        bs_regex_class_add(&set, isdigit);
+        break;
+
+    case 'b':
+        return bs_regex_node(p, BS_REGEX_NODE_ASSERT, BS_REGEX_WORD, 0);
+
+    case 'B':
+        return bs_regex_node(p, BS_REGEX_NODE_ASSERT, BS_REGEX_NOT_WORD, 0);
+
+    case '<':
+        return bs_regex_node(p, BS_REGEX_NODE_ASSERT, BS_REGEX_WORD_BEGIN, 0);
+
+    case '>':
+        return bs_regex_node(p, BS_REGEX_NODE_ASSERT, BS_REGEX_WORD_END, 0);
+
+    case 't':
+        return bs_regex_node_byte(p, '\t');
+
+    case 'n':
+        return bs_regex_node_byte(p, '\n');
+
+    case 'r':
+        return bs_regex_node_byte(p, '\r');
+
+    case 'f':
+        return bs_regex_node_byte(p, '\f');
+
+    case 'v':
+        return bs_regex_node_byte(p, '\v');
+
+    default:
+        // Back references cannot be matched without backtracking
+        if (isdigit((uint8_t) ch)) {
+            return bs_regex_fail(p);
+        }
+        return bs_regex_node_byte(p, ch);
+    }
+
+    if (isupper(ch)) {
+        bs_regex_set_negate(&set);
+    }
+    return bs_regex_node_set(p, &set);
+}
+
+static uint32_t bs_regex_parse_alt(Bs_Regex_Parser *p);
+
+static uint32_t bs_regex_parse_atom(Bs_Regex_Parser *p) {
+    const char ch = p->pattern.data[p->pos++];
+    switch (ch) {
+    case '(': {
+        if (++p->depth > BS_REGEX_MAX_DEPTH) {
+            return bs_regex_fail(p);
+        }
+
+        const uint32_t group = p->regex->groups++;
+        const uint32_t child = bs_regex_parse_alt(p);
+        if (p->error || !bs_regex_peek(p, ')')) {
+            return bs_regex_fail(p);
+        }
+
+        p->pos++;
+        p->depth--;
+        return bs_regex_node(p, BS_REGEX_NODE_GROUP, child, group);
+    }
+
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+        return bs_regex_fail(p);
+
+    case '[':
+        return bs_regex_parse_bracket(p);
+
+    case '.': {
+        Bs_Regex_Set set;
+        memset(&set, 0xff, sizeof(set));
+        return bs_regex_node_set(p, &set);
+    }
+
+    case '^':
+        return bs_regex_node(p, BS_REGEX_NODE_ASSERT, BS_REGEX_BEGIN, 0);
+
+    case '$':
+        return bs_regex_node(p, BS_REGEX_NODE_ASSERT, BS_REGEX_END, 0);
+
+    case '\\':
+        return bs_regex_parse_escape(p);
+
+    default:
+        return bs_regex_node_byte(p, ch);
+    }
+}
+
+static bool bs_regex_parse_number(Bs_Regex_Parser *p, uint32_t *n) {
+    if (p->pos >= p->pattern.size || !isdigit((uint8_t) p->pattern.data[p->pos])) {
+        return false;
+    }
+
+    *n = 0;
+    while (p->pos < p->pattern.size && isdigit((uint8_t) p->pattern.data[p->pos])) {
+        *n = *n * 10 + p->pattern.data[p->pos++] - '0';
+        if (*n > BS_REGEX_MAX_REPEAT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t bs_regex_parse_repeat(Bs_Regex_Parser *p) {
+    uint32_t node = bs_regex_parse_atom(p);
+
+    while (!p->error && p->pos < p->pattern.size) {
+        uint32_t min, max;
+        switch (p->pattern.data[p->pos]) {
+        case '*':
+            min = 0;
+            max = BS_REGEX_INFINITY;
+            p->pos++;
+            break;
+
+        case '+':
+            min = 1;
+            max = BS_REGEX_INFINITY;
+            p->pos++;
+            break;
+
+        case '?':
+            min = 0;
+            max = 1;
+            p->pos++;
+            break;
+
+        case '{':
+            p->pos++;
+            if (!bs_regex_parse_number(p, &min)) {
+                return bs_regex_fail(p);
+            }
+
+            max = min;
+            if (bs_regex_peek(p, ',')) {
+                p->pos++;
+                max = BS_REGEX_INFINITY;
+                if (!bs_regex_peek(p, '}') && (!bs_regex_parse_number(p, &max) || max < min)) {
+                    return bs_regex_fail(p);
+                }
+            }
+
+            if (!bs_regex_peek(p, '}')) {
+                return bs_regex_fail(p);
+            }
+            p->pos++;
+            break;
+
+        default:
+            return node;
+        }
+
+        node = bs_regex_node(p, BS_REGEX_NODE_REPEAT, node, 0);
+        p->nodes.data[node].min = min;
+        p->nodes.data[node].max = max;
+    }
+
+    return node;
+}
+
+static uint32_t bs_regex_parse_cat(Bs_Regex_Parser *p) {
+    const uint32_t node = bs_regex_node(p, BS_REGEX_NODE_CAT, BS_REGEX_NIL, 0);
+
+    uint32_t last = BS_REGEX_NIL;
+    while (!p->error && p->pos < p->pattern.size && !bs_regex_peek(p, '|') &&
+           !bs_regex_peek(p, ')')) {
+        const uint32_t child = bs_regex_parse_repeat(p);
+        if (p->error) {
+            break;
+        }
+
+        if (last == BS_REGEX_NIL) {
+            p->nodes.data[node].a = child;
+        } else {
+            p->nodes.data[last].next = child;
+        }
+        last = child;
+    }
+
+    return node;
+}
+
+static uint32_t bs_regex_parse_alt(Bs_Regex_Parser *p) {
+    uint32_t       last = bs_regex_parse_cat(p);
+    const uint32_t node = bs_regex_node(p, BS_REGEX_NODE_ALT, last, 0);
+
+    while (!p->error && bs_regex_peek(p, '|')) {
+        p->pos++;
+
+        const uint32_t child = bs_regex_parse_cat(p);
+        p->nodes.data[last].next = child;
+        last = child;
+    }
+
+    return node;
+}
+
+// Compiler
+static uint32_t bs_regex_emit(Bs_Regex_Parser *p, Bs_Regex_Op op, uint32_t x, uint32_t y) {
+    Bs_Regex_Insts *insts = &p->regex->insts;
+    if (insts->count >= BS_REGEX_MAX_INSTS) {
+        p->error = true;
+        return 0;
+    }
+
+    const Bs_Regex_Inst inst = {.op = op, .x = x, .y = y};
+    bs_da_push(p->regex->bs, insts, inst);
+    return insts->count - 1;
+}
+
+// Jumps which go to the same place are chained through their targets until it is known
+static void bs_regex_patch(Bs_Regex_Parser *p, uint32_t chain, bool y) {
+    Bs_Regex_Insts *insts = &p->regex->insts;
+    while (chain != BS_REGEX_NIL) {
+        uint32_t *target = y ? &insts->data[chain].y : &insts->data[chain].x;
+        chain = *target;
+        *target = insts->count;
+    }
+}
+
+static void bs_regex_compile(Bs_Regex_Parser *p, uint32_t index) {
+    if (p->error) {
+        return;
+    }
+
+    const Bs_Regex_Node node = p->nodes.data[index];
+    switch (node.kind) {
+    case BS_REGEX_NODE_SET:
+        bs_regex_emit(p, BS_REGEX_CLASS, node.a, 0);
+        break;
+
+    case BS_REGEX_NODE_ASSERT:
+        bs_regex_emit(p, BS_REGEX_ASSERT, node.a, 0);
+        break;
+
+    case BS_REGEX_NODE_CAT:
+        for (uint32_t i = node.a; i != BS_REGEX_NIL; i = p->nodes.data[i].next) {
+            bs_regex_compile(p, i);
+        }
+        break;
+
+    case BS_REGEX_NODE_ALT: {
+        uint32_t jumps = BS_REGEX_NIL;
+        for (uint32_t i = node.a; i != BS_REGEX_NIL; i = p->nodes.data[i].next) {
+            if (p->nodes.data[i].next == BS_REGEX_NIL) {
+                bs_regex_compile(p, i);
+                break;
+            }
+
+            const uint32_t split = bs_regex_emit(p, BS_REGEX_SPLIT, p->regex->insts.count + 1, 0);
+            bs_regex_compile(p, i);
+            jumps = bs_regex_emit(p, BS_REGEX_JUMP, jumps, 0);
+            if (p->error) {
+                return;
+            }
+            p->regex->insts.data[split].y = p->regex->insts.count;
+        }
+
+        if (!p->error) {
+            bs_regex_patch(p, jumps, false);
+        }
+    } break;
+
+    case BS_REGEX_NODE_REPEAT:
+        for (uint32_t i = 0; i < node.min; i++) {
+            bs_regex_compile(p, node.a);
+        }
+
+        if (node.max == BS_REGEX_INFINITY) {
+            const uint32_t loop = bs_regex_emit(p, BS_REGEX_SPLIT, p->regex->insts.count + 1, 0);
+            bs_regex_compile(p, node.a);
+            bs_regex_emit(p, BS_REGEX_JUMP, loop, 0);
+            if (!p->error) {
+                p->regex->insts.data[loop].y = p->regex->insts.count;
+            }
+        } else {
+            // Each optional copy skips all of the ones after it
+            uint32_t splits = BS_REGEX_NIL;
+            for (uint32_t i = node.min; i < node.max && !p->error; i++) {
+                splits = bs_regex_emit(p, BS_REGEX_SPLIT, p->regex->insts.count + 1, splits);
+                bs_regex_compile(p, node.a);
+            }
+
+            if (!p->error) {
+                bs_regex_patch(p, splits, true);
+            }
+        }
+        break;
+
+    case BS_REGEX_NODE_GROUP:
+        bs_regex_emit(p, BS_REGEX_SAVE, node.b * 2, 0);
+        bs_regex_compile(p, node.a);
+        bs_regex_emit(p, BS_REGEX_SAVE, node.b * 2 + 1, 0);
+        break;
+
+    default:
+        assert(false && "unreachable");
+    }
+}
+
+// Follows the empty transitions from `pc` and adds everything it reaches to `pcs`. Assertions are
+// checked against the context if there is one, and otherwise kept in the set to be checked later
+static void bs_regex_closure(
+    Bs_Regex *regex, Bs_Regex_Pcs *pcs, uint32_t pc, const Bs_Regex_Context *context) {
+    uint32_t *stack = regex->stack;
+    size_t    count = 0;
+
+    stack[count++] = pc;
+    while (count) {
+        pc = stack[--count];
+        if (bs_regex_pcs_has(pcs, pc)) {
+            continue;
+        }
+        bs_regex_pcs_add(pcs, pc);
+
+        const Bs_Regex_Inst inst = regex->insts.data[pc];
+        switch (inst.op) {
+        case BS_REGEX_SPLIT:
+            stack[count++] = inst.y;
+            stack[count++] = inst.x;
+            break;
+
+        case BS_REGEX_JUMP:
+            stack[count++] = inst.x;
+            break;
+
+        case BS_REGEX_SAVE:
+            stack[count++] = pc + 1;
+            break;
+
+        case BS_REGEX_ASSERT:
+            if (context && bs_regex_holds(inst.x, context)) {
+                stack[count++] = pc + 1;
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+}
+
+static void bs_regex_prepare(Bs_Regex *regex) {
+    Bs          *bs = regex->bs;
+    const size_t n = regex->insts.count;
+    const size_t slots = regex->groups * 2;
+
+    for (size_t i = 0; i < bs_c_array_size(regex->closure); i++) {
+        regex->closure[i].dense = bs_realloc(bs, NULL, 0, n * sizeof(uint32_t));
+        regex->closure[i].sparse = bs_realloc(bs, NULL, 0, n * sizeof(uint32_t));
+    }
+
+    for (size_t i = 0; i < bs_c_array_size(regex->threads); i++) {
+        Bs_Regex_Threads *t = &regex->threads[i];
+        t->visited.dense = bs_realloc(bs, NULL, 0, n * sizeof(uint32_t));
+        t->visited.sparse = bs_realloc(bs, NULL, 0, n * sizeof(uint32_t));
+        t->pcs = bs_realloc(bs, NULL, 0, n * sizeof(uint32_t));
+        t->slots = bs_realloc(bs, NULL, 0, n * slots * sizeof(size_t));
+    }
+
+    // Every instruction pushes at most two frames, and only the first time it is reached
+    regex->stack = bs_realloc(bs, NULL, 0, (2 * n + 1) * sizeof(uint32_t));
+    regex->frames = bs_realloc(bs, NULL, 0, (2 * n + 1) * sizeof(Bs_Regex_Frame));
+    regex->key = bs_realloc(bs, NULL, 0, n * sizeof(uint32_t));
+    regex->slots = bs_realloc(bs, NULL, 0, slots * sizeof(size_t));
+    regex->best = bs_realloc(bs, NULL, 0, slots * sizeof(size_t));
+
+    for (size_t i = 0; i < bs_c_array_size(regex->initial); i++) {
+        regex->initial[i] = BS_REGEX_UNKNOWN;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        const Bs_Regex_Inst inst = regex->insts.data[i];
+        if (inst.op == BS_REGEX_ASSERT) {
+            if (inst.x == BS_REGEX_BEGIN) {
+                regex->tracked |= BS_REGEX_AT_BEGIN;
+            } else if (inst.x != BS_REGEX_END) {
+                regex->tracked |= BS_REGEX_PREV_WORD;
+            }
+        }
+    }
+
+    // Anchored if nothing but a ^ can be reached without consuming anything
+    Bs_Regex_Pcs *pcs = &regex->closure[0];
+    pcs->count = 0;
+    bs_regex_closure(regex, pcs, 0, NULL);
+
+    regex->anchored = true;
+    for (size_t i = 0; i < pcs->count; i++) {
+        const Bs_Regex_Inst inst = regex->insts.data[pcs->dense[i]];
+        if (inst.op == BS_REGEX_CLASS || inst.op == BS_REGEX_MATCH ||
+            (inst.op == BS_REGEX_ASSERT && inst.x != BS_REGEX_BEGIN)) {
+            regex->anchored = false;
+            break;
+        }
+    }
+}
+
+Bs_Regex *bs_regex_new(Bs *bs, Bs_Sv pattern) {
+    Bs_Regex *regex = bs_realloc(bs, NULL, 0, sizeof(*regex));
+    memset(regex, 0, sizeof(*regex));
+    regex->bs = bs;
+    regex->groups = 1;
+
+    Bs_Regex_Parser p = {.regex = regex, .pattern = pattern};
+
+    const uint32_t root = bs_regex_parse_alt(&p);
+    if (p.pos != pattern.size) {
+        p.error = true;
+    }
+
+    bs_regex_emit(&p, BS_REGEX_SAVE, 0, 0);
+    bs_regex_compile(&p, root);
+    bs_regex_emit(&p, BS_REGEX_SAVE, 1, 0);
+    bs_regex_emit(&p, BS_REGEX_MATCH, 0, 0);
+    bs_da_free(bs, &p.nodes);
+
+    if (p.error) {
+        bs_regex_free(regex);
+        return NULL;
+    }
+
+    bs_regex_prepare(regex);
+    return regex;
+}
+
+static void bs_regex_states_clear(Bs_Regex *regex) {
+    for (size_t i = 0; i < regex->states.count; i++) {
+        Bs_Regex_State *state = regex->states.data[i];
+        bs_realloc(regex->bs, state, sizeof(*state) + state->count * sizeof(uint32_t), 0);
+    }
+    regex->states.count = 0;
+
+    for (size_t i = 0; i < regex->table_capacity; i++) {
+        regex->table[i] = BS_REGEX_UNKNOWN;
+    }
+
+    for (size_t i = 0; i < bs_c_array_size(regex->initial); i++) {
+        regex->initial[i] = BS_REGEX_UNKNOWN;
+    }
+
+    regex->generation++;
+}
+
+void bs_regex_free(Bs_Regex *regex) {
+    Bs          *bs = regex->bs;
+    const size_t n = regex->insts.count;
+    const size_t slots = regex->groups * 2;
+
+    if (regex->stack) {
+        for (size_t i = 0; i < bs_c_array_size(regex->closure); i++) {
+            bs_realloc(bs, regex->closure[i].dense, n * sizeof(uint32_t), 0);
+            bs_realloc(bs, regex->closure[i].sparse, n * sizeof(uint32_t), 0);
+        }
+
+        for (size_t i = 0; i < bs_c_array_size(regex->threads); i++) {
+            Bs_Regex_Threads *t = &regex->threads[i];
+            bs_realloc(bs, t->visited.dense, n * sizeof(uint32_t), 0);
+            bs_realloc(bs, t->visited.sparse, n * sizeof(uint32_t), 0);
+            bs_realloc(bs, t->pcs, n * sizeof(uint32_t), 0);
+            bs_realloc(bs, t->slots, n * slots * sizeof(size_t), 0);
+        }
+
+        bs_realloc(bs, regex->stack, (2 * n + 1) * sizeof(uint32_t), 0);
+        bs_realloc(bs, regex->frames, (2 * n + 1) * sizeof(Bs_Regex_Frame), 0);
+        bs_realloc(bs, regex->key, n * sizeof(uint32_t), 0);
+        bs_realloc(bs, regex->slots, slots * sizeof(size_t), 0);
+        bs_realloc(bs, regex->best, slots * sizeof(size_t), 0);
+    }
+
+    bs_regex_states_clear(regex);
+    bs_da_free(bs, &regex->states);
+    bs_realloc(bs, regex->table, regex->table_capacity * sizeof(int32_t), 0);
+
+    bs_da_free(bs, &regex->insts);
+    bs_da_free(bs, &regex->sets);
+    bs_realloc(bs, regex, sizeof(*regex), 0);
+}
+
+size_t bs_regex_groups(const Bs_Regex *regex) {
+    return regex->groups;
+}
+
+static int bs_regex_pc_compare(const void *a, const void *b) {
+    const uint32_t x = *(const uint32_t *) a;
+    const uint32_t y = *(const uint32_t *) b;
+    return (x > y) - (x < y);
+}
+
+static void bs_regex_table_insert(Bs_Regex *regex, uint32_t hash, int32_t index) {
+    size_t i = hash & (regex->table_capacity - 1);
+    while (regex->table[i] != BS_REGEX_UNKNOWN) {
+        i = (i + 1) & (regex->table_capacity - 1);
+    }
+    regex->table[i] = index;
+}
+
+// Returns the index of the state made of the instructions in `pcs` which need to be kept around,
+// adding it if there is none yet. This can throw away every other state
+static int32_t bs_regex_state(Bs_Regex *regex, const Bs_Regex_Pcs *pcs, uint32_t flags) {
+    size_t count = 0;
+    for (size_t i = 0; i < pcs->count; i++) {
+        const uint32_t pc = pcs->dense[i];
+        switch (regex->insts.data[pc].op) {
+        case BS_REGEX_CLASS:
+        case BS_REGEX_ASSERT:
+        case BS_REGEX_MATCH:
+            regex->key[count++] = pc;
+            break;
+
+        default:
+            break;
+        }
+    }
+    qsort(regex->key, count, sizeof(*regex->key), bs_regex_pc_compare);
+
+    const uint32_t hash = bs_hash_bytes(regex->key, count * sizeof(*regex->key)) ^ (flags * 0x9e3779b9);
+
+    if (regex->table_capacity) {
+        size_t i = hash & (regex->table_capacity - 1);
+        while (regex->table[i] != BS_REGEX_UNKNOWN) {
+            const Bs_Regex_State *state = regex->states.data[regex->table[i]];
+            if (state->hash == hash && state->flags == flags && state->count == count &&
+                !memcmp(state->pcs, regex->key, count * sizeof(*regex->key))) {
+                return regex->table[i];
+            }
+            i = (i + 1) & (regex->table_capacity - 1);
+        }
+    }
+
+    if (regex->states.count >= BS_REGEX_MAX_STATES) {
+        bs_regex_states_clear(regex);
+    }
+
+    // Keep the table at most half full
+    if ((regex->states.count + 1) * 2 > regex->table_capacity) {
+        const size_t old_capacity = regex->table_capacity;
+        regex->table_capacity = old_capacity ? old_capacity * 2 : 64;
+        regex->table = bs_realloc(
+            regex->bs,
+            regex->table,
+            old_capacity * sizeof(int32_t),
+            regex->table_capacity * sizeof(int32_t));
+
+        for (size_t i = 0; i < regex->table_capacity; i++) {
+            regex->table[i] = BS_REGEX_UNKNOWN;
+        }
+
+        for (size_t i = 0; i < regex->states.count; i++) {
+            bs_regex_table_insert(regex, regex->states.data[i]->hash, i);
+        }
+    }
+
+    Bs_Regex_State *state =
+        bs_realloc(regex->bs, NULL, 0, sizeof(*state) + count * sizeof(*regex->key));
+
+    state->hash = hash;
+    state->flags = flags;
+    state->count = count;
+    memcpy(state->pcs, regex->key, count * sizeof(*regex->key));
+
+    for (size_t i = 0; i < bs_c_array_size(state->next); i++) {
+        state->next[i] = BS_REGEX_UNKNOWN;
+    }
+
+    const int32_t index = regex->states.count;
+    bs_da_push(regex->bs, &regex->states, state);
+    bs_regex_table_insert(regex, hash, index);
+    return index;
+}
+
+static int32_t bs_regex_initial(Bs_Regex *regex, Bs_Sv text, size_t offset) {
+    uint32_t flags = BS_REGEX_QUIET;
+    if (!offset) {
+        flags |= BS_REGEX_AT_BEGIN;
+    } else if (bs_regex_isword(text.data[offset - 1])) {
+        flags |= BS_REGEX_PREV_WORD;
+    }
+    flags &= regex->tracked | BS_REGEX_QUIET;
+
+    int32_t *initial = &regex->initial[flags & (BS_REGEX_AT_BEGIN | BS_REGEX_PREV_WORD)];
+    if (*initial == BS_REGEX_UNKNOWN) {
+        Bs_Regex_Pcs *pcs = &regex->closure[0];
+        pcs->count = 0;
+        bs_regex_closure(regex, pcs, 0, NULL);
+        *initial = bs_regex_state(regex, pcs, flags);
+    }
+    return *initial;
+}
+
+// Computes the transition of the state on the byte `ch`, or BS_REGEX_EOT
+static int32_t bs_regex_step(Bs_Regex *regex, int32_t index, uint32_t ch) {
+    const Bs_Regex_State *state = regex->states.data[index];
+
+    const Bs_Regex_Context context = {
+        .begin = state->flags & BS_REGEX_AT_BEGIN,
+        .end = ch == BS_REGEX_EOT,
+        .prev_word = state->flags & BS_REGEX_PREV_WORD,
+        .next_word = ch != BS_REGEX_EOT && bs_regex_isword(ch),
+    };
+
+    // Now that the next byte is known, the assertions can be followed
+    Bs_Regex_Pcs *now = &regex->closure[0];
+    now->count = 0;
+    for (size_t i = 0; i < state->count; i++) {
+        bs_regex_closure(regex, now, state->pcs[i], &context);
+    }
+
+    int32_t result = 0;
+    for (size_t i = 0; i < now->count; i++) {
+        if (regex->insts.data[now->dense[i]].op == BS_REGEX_MATCH) {
+            result |= BS_REGEX_MATCHED;
+            break;
+        }
+    }
+
+    if (ch != BS_REGEX_EOT) {
+        Bs_Regex_Pcs *next = &regex->closure[1];
+        next->count = 0;
+        for (size_t i = 0; i < now->count; i++) {
+            const Bs_Regex_Inst inst = regex->insts.data[now->dense[i]];
+            if (inst.op == BS_REGEX_CLASS && bs_regex_set_has(&regex->sets.data[inst.x], ch)) {
+                bs_regex_closure(regex, next, now->dense[i] + 1, NULL);
+            }
+        }
+
+        uint32_t flags = 0;
+        if (!next->count) {
+            flags |= BS_REGEX_QUIET;
+        }
+
+        if (context.next_word) {
+            flags |= BS_REGEX_PREV_WORD & regex->tracked;
+        }
+
+        // A new thread starts at every position
+        if (!regex->anchored) {
+            bs_regex_closure(regex, next, 0, NULL);
+        }
+
+        if (!next->count) {
+            result |= BS_REGEX_DEAD;
+        }
+
+        const size_t generation = regex->generation;
+        result |= bs_regex_state(regex, next, flags) << 2;
+
+        // Unless the state itself was just thrown away
+        if (generation != regex->generation) {
+            return result;
+        }
+    }
+
+    regex->states.data[index]->next[ch] = result;
+    return result;
+}
+
+// Adds a thread at `pc` with the given slots, along with everything reachable from it without
+// consuming a byte. The slots are left as they were
+static void bs_regex_thread_add(
+    Bs_Regex                *regex,
+    Bs_Regex_Threads        *threads,
+    uint32_t                 pc,
+    size_t                  *slots,
+    size_t                   at,
+    const Bs_Regex_Context *context) {
+
+    const size_t    count = regex->groups * 2;
+    Bs_Regex_Frame *stack = regex->frames;
+    size_t          depth = 0;
+
+    stack[depth++] = (Bs_Regex_Frame){.pc = pc};
+    while (depth) {
+        const Bs_Regex_Frame frame = stack[--depth];
+        if (frame.pc == BS_REGEX_RESTORE) {
+            slots[frame.slot] = frame.value;
+            continue;
+        }
+
+        if (bs_regex_pcs_has(&threads->visited, frame.pc)) {
+            continue;
+        }
+        bs_regex_pcs_add(&threads->visited, frame.pc);
+
+        const Bs_Regex_Inst inst = regex->insts.data[frame.pc];
+        switch (inst.op) {
+        case BS_REGEX_SPLIT:
+            stack[depth++] = (Bs_Regex_Frame){.pc = inst.y};
+            stack[depth++] = (Bs_Regex_Frame){.pc = inst.x};
+            break;
+
+        case BS_REGEX_JUMP:
+            stack[depth++] = (Bs_Regex_Frame){.pc = inst.x};
+            break;
+
+        case BS_REGEX_SAVE:
+            stack[depth++] =
+                (Bs_Regex_Frame){.pc = BS_REGEX_RESTORE, .slot = inst.x, .value = slots[inst.x]};
+            stack[depth++] = (Bs_Regex_Frame){.pc = frame.pc + 1};
+            slots[inst.x] = at;
+            break;
+
+        case BS_REGEX_ASSERT:
+            if (bs_regex_holds(inst.x, context)) {
+                stack[depth++] = (Bs_Regex_Frame){.pc = frame.pc + 1};
+            }
+            break;
+
+        case BS_REGEX_CLASS:
+        case BS_REGEX_MATCH:
+            threads->pcs[threads->count] = frame.pc;
+            memcpy(&threads->slots[threads->count * count], slots, count * sizeof(*slots));
+            threads->count++;
+            break;
+        }
+    }
+}
+
+// Runs the threads in lockstep from `from`, which no match may begin before. Threads are kept in
+// order of where they started, so when two reach the same instruction the one to the left wins
+static void bs_regex_pike(Bs_Regex *regex, Bs_Sv text, size_t from) {
+    const size_t count = regex->groups * 2;
+    size_t      *slots = regex->slots;
+    size_t      *best = regex->best;
+    bool         found = false;
+
+    Bs_Regex_Threads *now = &regex->threads[0];
+    Bs_Regex_Threads *next = &regex->threads[1];
+    now->count = 0;
+    now->visited.count = 0;
+
+    Bs_Regex_Context context = bs_regex_context(text, from);
+    for (size_t at = from;; at++) {
+        // New threads are only worth starting until there is a match to the left of them
+        if (!found) {
+            for (size_t i = 0; i < count; i++) {
+                slots[i] = BS_REGEX_NONE;
+            }
+            bs_regex_thread_add(regex, now, 0, slots, at, &context);
+        }
+
+        if (!now->count && found) {
+            break;
+        }
+
+        next->count = 0;
+        next->visited.count = 0;
+
+        const bool more = at < text.size;
+        if (more) {
+            context = bs_regex_context(text, at + 1);
+        }
+
+        for (size_t i = 0; i < now->count; i++) {
+            const size_t       *thread = &now->slots[i * count];
+            const Bs_Regex_Inst inst = regex->insts.data[now->pcs[i]];
+
+            // Earlier starts win, then longer matches
+            if (inst.op == BS_REGEX_MATCH) {
+                if (!found || thread[0] < best[0] || (thread[0] == best[0] && thread[1] > best[1])) {
+                    memcpy(best, thread, count * sizeof(*best));
+                    found = true;
+                }
+                continue;
+            }
+
+            if (found && thread[0] > best[0]) {
+                continue;
+            }
+
+            if (more && bs_regex_set_has(&regex->sets.data[inst.x], text.data[at])) {
+                memcpy(slots, thread, count * sizeof(*slots));
+                bs_regex_thread_add(regex, next, now->pcs[i] + 1, slots, at + 1, &context);
+            }
+        }
+
+        Bs_Regex_Threads *t = now;
+        now = next;
+        next = t;
+
+        if (!more) {
+            break;
+        }
+    }
+
+    assert(found);
+}
+
+bool bs_regex_find(Bs_Regex *regex, Bs_Sv text, size_t offset, Bs_Regex_Span *spans, size_t count) {
+    if (offset > text.size || (regex->anchored && offset)) {
+        return false;
+    }
+
+    // The DFA finds out whether there is a match, and the last position before its end where no
+    // thread was alive, before which it cannot begin
+    int32_t index = bs_regex_initial(regex, text, offset);
+    size_t  from = offset;
+
+    for (size_t at = offset;; at++) {
+        const Bs_Regex_State *state = regex->states.data[index];
+        if (state->flags & BS_REGEX_QUIET) {
+            from = at;
+        }
+
+        const uint32_t ch = at < text.size ? (uint8_t) text.data[at] : BS_REGEX_EOT;
+
+        int32_t next = state->next[ch];
+        if (next == BS_REGEX_UNKNOWN) {
+            next = bs_regex_step(regex, index, ch);
+        }
+
+        if (next & BS_REGEX_MATCHED) {
+            break;
+        }
+
+        if ((next & BS_REGEX_DEAD) || ch == BS_REGEX_EOT) {
+            return false;
+        }
+
+        index = next >> 2;
+    }
+
+    bs_regex_pike(regex, text, from);
+
+    for (size_t i = 0; i < count; i++) {
+        if (i < regex->groups && regex->best[i * 2] != BS_REGEX_NONE &&
+            regex->best[i * 2 + 1] != BS_REGEX_NONE) {
+            spans[i] = (Bs_Regex_Span){regex->best[i * 2], regex->best[i * 2 + 1]};
+        } else {
+            spans[i] = (Bs_Regex_Span){BS_REGEX_NONE, BS_REGEX_NONE};
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,645 @@
+#include <math.h>
+
+#include "bs/map.h"
+#include "bs/object.h"
+#include "bs/serial.h"
+
+#define BS_SERIAL_MAGIC   "BSV"
+#define BS_SERIAL_VERSION 1
+
+typedef enum {
+    BS_SERIAL_NIL,
+    BS_SERIAL_FALSE,
+    BS_SERIAL_TRUE,
+    BS_SERIAL_INT,   // Zigzag varint
+    BS_SERIAL_NUM,   // IEEE 754 double, little endian
+    BS_SERIAL_STR,   // Varint index into the strings
+    BS_SERIAL_ARRAY, // Varint count, then the elements
+    BS_SERIAL_TABLE, // Varint count, then the keys and values
+    BS_SERIAL_REF,   // Varint index of an array or table which came before
+
+    // Whole numbers from 0 to 127, in the tag itself
+    BS_SERIAL_SMALL = 0x80,
+} Bs_Serial_Tag;
+
+// The largest magnitude below which every whole number is exact in a double
+#define BS_SERIAL_INT_MAX 9007199254740992.0
+
+typedef struct {
+    const Bs_Object *object;
+
+    // The next element, or the next entry of a table
+    size_t index;
+
+    // Whether the key of the entry at `index` is out, and its value is due
+    bool value;
+} Bs_Serial_Frame;
+
+typedef struct {
+    Bs_Serial_Frame *data;
+    size_t           count;
+    size_t           capacity;
+} Bs_Serial_Frames;
+
+// Writer
+typedef struct {
+    const Bs_Str **data;
+    size_t         count;
+    size_t         capacity;
+} Bs_Serial_Strs;
+
+// Objects by identity, as maps compare arrays and tables by their contents
+typedef struct {
+    const Bs_Object *object;
+    size_t           index;
+} Bs_Serial_Slot;
+
+typedef struct {
+    Bs_Serial_Slot *data;
+    size_t          count;
+    size_t          capacity;
+} Bs_Serial_Seen;
+
+typedef struct {
+    Bs *bs;
+
+    // The value is written here first, as the header depends on it
+    Bs_Buffer body;
+
+    // Index of every string and every container seen so far
+    Bs_Serial_Seen seen;
+    Bs_Serial_Strs strs;
+    size_t         objects;
+
+    Bs_Serial_Frames frames;
+
+    // The first value which cannot be serialized, the error is raised once everything is freed
+    bool     failed;
+    Bs_Value invalid;
+} Bs_Serializer;
+
+static void bs_serial_write_varint(Bs *bs, Bs_Buffer *b, uint64_t n) {
+    uint8_t data[10];
+    size_t  size = 0;
+    while (n >= 0x80) {
+        data[size++] = (n & 0x7f) | 0x80;
+        n >>= 7;
+    }
+    data[size++] = n;
+
+    bs_da_push_many(bs, b, data, size);
+}
+
+static void bs_serial_write_tag(Bs_Serializer *s, uint8_t tag) {
+    bs_da_push(s->bs, &s->body, tag);
+}
+
+static void bs_serial_write_number(Bs_Serializer *s, double number) {
+    if (number == trunc(number) && fabs(number) < BS_SERIAL_INT_MAX && !signbit(number)) {
+        if (number < 0x80) {
+            bs_serial_write_tag(s, BS_SERIAL_SMALL | (uint8_t) number);
+            return;
+        }
+
+        bs_serial_write_tag(s, BS_SERIAL_INT);
+        bs_serial_write_varint(s->bs, &s->body, (uint64_t) number << 1);
+        return;
+    }
+
+    if (number == trunc(number) && fabs(number) < BS_SERIAL_INT_MAX && number != 0) {
+        bs_serial_write_tag(s, BS_SERIAL_INT);
+        bs_serial_write_varint(s->bs, &s->body, ((uint64_t) -(int64_t) number << 1) - 1);
+        return;
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+
+    uint8_t data[8];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = bits >> (i * 8);
+    }
+
+    bs_serial_write_tag(s, BS_SERIAL_NUM);
+    bs_da_push_many(s->bs, &s->body, data, sizeof(data));
+}
+
+static Bs_Serial_Slot *
+bs_serial_slot(Bs_Serial_Slot *data, size_t capacity, const Bs_Object *object) {
+    size_t i = bs_hash_uint64((uintptr_t) object) & (capacity - 1);
+    while (data[i].object && data[i].object != object) {
+        i = (i + 1) & (capacity - 1);
+    }
+    return &data[i];
+}
+
+// Writes the index of the object if it was seen before, and records it otherwise
+static bool bs_serial_seen(Bs_Serializer *s, const Bs_Object *object, size_t index, uint8_t tag) {
+    Bs_Serial_Seen *seen = &s->seen;
+    if (seen->count) {
+        const Bs_Serial_Slot *slot = bs_serial_slot(seen->data, seen->capacity, object);
+        if (slot->object) {
+            bs_serial_write_tag(s, tag);
+            bs_serial_write_varint(s->bs, &s->body, slot->index);
+            return true;
+        }
+    }
+
+    if ((seen->count + 1) * 4 > seen->capacity * 3) {
+        const size_t    capacity = seen->capacity ? seen->capacity * 2 : BS_DA_INIT_CAP;
+        Bs_Serial_Slot *data = bs_realloc(s->bs, NULL, 0, capacity * sizeof(*data));
+        memset(data, 0, capacity * sizeof(*data));
+
+        for (size_t i = 0; i < seen->capacity; i++) {
+            if (seen->data[i].object) {
+                *bs_serial_slot(data, capacity, seen->data[i].object) = seen->data[i];
+            }
+        }
+
+        bs_realloc(s->bs, seen->data, seen->capacity * sizeof(*seen->data), 0);
+        seen->data = data;
+        seen->capacity = capacity;
+    }
+
+    *bs_serial_slot(seen->data, seen->capacity, object) = (Bs_Serial_Slot){object, index};
+    seen->count++;
+    return false;
+}
+
+// Containers only get their header written here, the elements follow as the frame is walked
+static void bs_serial_write_value(Bs_Serializer *s, Bs_Value value) {
+    switch (value.type) {
+    case BS_VALUE_NIL:
+        bs_serial_write_tag(s, BS_SERIAL_NIL);
+        return;
+
+    case BS_VALUE_NUM:
+        bs_serial_write_number(s, value.as.number);
+        return;
+
+    case BS_VALUE_BOOL:
+        bs_serial_write_tag(s, value.as.boolean ? BS_SERIAL_TRUE : BS_SERIAL_FALSE);
+        return;
+
+    case BS_VALUE_OBJECT:
+        switch (value.as.object->type) {
+        case BS_OBJECT_STR:
+            if (!bs_serial_seen(s, value.as.object, s->strs.count, BS_SERIAL_STR)) {
+                bs_da_push(s->bs, &s->strs, (const Bs_Str *) value.as.object);
+
+                bs_serial_write_tag(s, BS_SERIAL_STR);
+                bs_serial_write_varint(s->bs, &s->body, s->strs.count - 1);
+            }
+            return;
+
+        case BS_OBJECT_ARRAY:
+            if (!bs_serial_seen(s, value.as.object, s->objects, BS_SERIAL_REF)) {
+                s->objects++;
+
+                bs_serial_write_tag(s, BS_SERIAL_ARRAY);
+                bs_serial_write_varint(
+                    s->bs, &s->body, ((const Bs_Array *) value.as.object)->count);
+
+                const Bs_Serial_Frame frame = {.object = value.as.object};
+                bs_da_push(s->bs, &s->frames, frame);
+            }
+            return;
+
+        case BS_OBJECT_TABLE:
+            if (!bs_serial_seen(s, value.as.object, s->objects, BS_SERIAL_REF)) {
+                s->objects++;
+
+                bs_serial_write_tag(s, BS_SERIAL_TABLE);
+                bs_serial_write_varint(
+                    s->bs, &s->body, ((const Bs_Table *) value.as.object)->map.length);
+
+                const Bs_Serial_Frame frame = {.object = value.as.object};
+                bs_da_push(s->bs, &s->frames, frame);
+            }
+            return;
+
+        default:
+            break;
+        }
+        break;
+    }
+
+    s->failed = true;
+    s->invalid = value;
+}
+
+// Writes out the next item of the innermost container, or leaves it if there are none
+static void bs_serial_write_step(Bs_Serializer *s) {
+    Bs_Serial_Frame *frame = &s->frames.data[s->frames.count - 1];
+
+    if (frame->object->type == BS_OBJECT_ARRAY) {
+        const Bs_Array *array = (const Bs_Array *) frame->object;
+        if (frame->index == array->count) {
+            s->frames.count--;
+        } else {
+            bs_serial_write_value(s, array->data[frame->index++]);
+        }
+        return;
+    }
+
+    const Bs_Map *map = &((const Bs_Table *) frame->object)->map;
+    if (frame->value) {
+        frame->value = false;
+        bs_serial_write_value(s, map->data[frame->index++].value);
+        return;
+    }
+
+    while (frame->index < map->capacity && map->data[frame->index].key.type == BS_VALUE_NIL) {
+        frame->index++;
+    }
+
+    if (frame->index == map->capacity) {
+        s->frames.count--;
+    } else {
+        frame->value = true;
+        bs_serial_write_value(s, map->data[frame->index].key);
+    }
+}
+
+static void bs_serial_free(Bs_Serializer *s) {
+    bs_da_free(s->bs, &s->body);
+    bs_da_free(s->bs, &s->seen);
+    bs_da_free(s->bs, &s->strs);
+    bs_da_free(s->bs, &s->frames);
+}
+
+void bs_serialize(Bs *bs, Bs_Writer *writer, Bs_Value value) {
+    Bs_Serializer s = {.bs = bs};
+
+    bs_serial_write_value(&s, value);
+    while (!s.failed && s.frames.count) {
+        bs_serial_write_step(&s);
+    }
+
+    if (s.failed) {
+        bs_serial_free(&s);
+
+        const Bs_Sv sv = bs_value_type_name_full(s.invalid);
+        bs_error(bs, "cannot serialize " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
+    }
+
+    Bs_Buffer header = {.bs = bs};
+    bs_da_push_many(bs, &header, BS_SERIAL_MAGIC, sizeof(BS_SERIAL_MAGIC) - 1);
+    bs_da_push(bs, &header, BS_SERIAL_VERSION);
+    bs_serial_write_varint(bs, &header, s.strs.count);
+    bs_serial_write_varint(bs, &header, s.objects);
+    writer->write(writer, Bs_Sv(header.data, header.count));
+
+    for (size_t i = 0; i < s.strs.count; i++) {
+        const Bs_Str *str = s.strs.data[i];
+
+        header.count = 0;
+        bs_serial_write_varint(bs, &header, str->size);
+        writer->write(writer, Bs_Sv(header.data, header.count));
+        writer->write(writer, Bs_Sv(str->data, str->size));
+    }
+
+    writer->write(writer, Bs_Sv(s.body.data, s.body.count));
+
+    bs_da_free(bs, &header);
+    bs_serial_free(&s);
+}
+
+// Reader
+typedef struct {
+    Bs_Value *data;
+    size_t    count;
+    size_t    capacity;
+} Bs_Serial_Values;
+
+typedef struct {
+    Bs *bs;
+
+    const uint8_t *begin;
+    const uint8_t *p;
+    const uint8_t *end;
+
+    // The collector does not see these, everything in them has a handle instead. That includes the
+    // strings which were interned already
+    Bs_Serial_Values strs;
+    Bs_Serial_Values objects;
+    size_t           objects_total;
+
+    // The frames of tables keep the pending key alongside
+    Bs_Serial_Frames frames;
+    Bs_Serial_Values keys;
+
+    Bs_Serial_Error *error;
+} Bs_Deserializer;
+
+static bool bs_serial_fail(Bs_Deserializer *d, const uint8_t *at, const char *message) {
+    d->error->offset = at - d->begin;
+    d->error->message = message;
+    return false;
+}
+
+static bool bs_serial_read_varint(Bs_Deserializer *d, uint64_t *n) {
+    const uint8_t *start = d->p;
+
+    *n = 0;
+    for (size_t shift = 0; shift < 64; shift += 7) {
+        if (d->p >= d->end) {
+            return bs_serial_fail(d, d->p, "unexpected end of input");
+        }
+
+        const uint8_t byte = *d->p++;
+        *n |= (uint64_t) (byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+
+    return bs_serial_fail(d, start, "varint too long");
+}
+
+// Reads a count of items which take at least `size` bytes each, so that a corrupt count cannot
+// make the reader allocate more than the input could possibly hold
+static bool bs_serial_read_count(Bs_Deserializer *d, size_t size, size_t *count) {
+    const uint8_t *start = d->p;
+
+    uint64_t n;
+    if (!bs_serial_read_varint(d, &n)) {
+        return false;
+    }
+
+    if (n > (uint64_t) (d->end - d->p) / size) {
+        return bs_serial_fail(d, start, "count exceeds input");
+    }
+
+    *count = n;
+    return true;
+}
+
+static bool bs_serial_read_index(Bs_Deserializer *d, size_t count, size_t *index) {
+    const uint8_t *start = d->p;
+
+    uint64_t n;
+    if (!bs_serial_read_varint(d, &n)) {
+        return false;
+    }
+
+    if (n >= count) {
+        return bs_serial_fail(d, start, "index out of range");
+    }
+
+    *index = n;
+    return true;
+}
+
+static bool bs_serial_read_object(Bs_Deserializer *d, const uint8_t *at, Bs_Object *object) {
+    if (d->objects.count == d->objects_total) {
+        return bs_serial_fail(d, at, "more arrays and tables than declared");
+    }
+
+    d->objects.data[d->objects.count++] = bs_value_object(object);
+
+    const Bs_Serial_Frame frame = {.object = object};
+    bs_da_push(d->bs, &d->frames, frame);
+    bs_da_push(d->bs, &d->keys, bs_value_nil);
+    return true;
+}
+
+// Containers are created empty and filled in as the frame is walked
+static bool bs_serial_read_value(Bs_Deserializer *d, Bs_Value *value) {
+    Bs *bs = d->bs;
+    if (d->p >= d->end) {
+        return bs_serial_fail(d, d->p, "unexpected end of input");
+    }
+
+    const uint8_t *start = d->p;
+    const uint8_t  tag = *d->p++;
+    if (tag & BS_SERIAL_SMALL) {
+        *value = bs_value_num(tag & ~BS_SERIAL_SMALL);
+        return true;
+    }
+
+    switch (tag) {
+    case BS_SERIAL_NIL:
+        *value = bs_value_nil;
+        return true;
+
+    case BS_SERIAL_FALSE:
+        *value = bs_value_bool(false);
+        return true;
+
+    case BS_SERIAL_TRUE:
+        *value = bs_value_bool(true);
+        return true;
+
+    case BS_SERIAL_INT: {
+        uint64_t n;
+        if (!bs_serial_read_varint(d, &n)) {
+            return false;
+        }
+
+        const double magnitude = (double) (n >> 1) + (n & 1);
+        *value = bs_value_num((n & 1) ? -magnitude : magnitude);
+        return true;
+    }
+
+    case BS_SERIAL_NUM: {
+        if (d->end - d->p < 8) {
+            return bs_serial_fail(d, d->p, "unexpected end of input");
+        }
+
+        uint64_t bits = 0;
+        for (size_t i = 0; i < 8; i++) {
+            bits |= (uint64_t) d->p[i] << (i * 8);
+        }
+        d->p += 8;
+
+        double number;
+        memcpy(&number, &bits, sizeof(number));
+        *value = bs_value_num(number);
+        return true;
+    }
+
+    case BS_SERIAL_STR: {
+        size_t index;
+        if (!bs_serial_read_index(d, d->strs.count, &index)) {
+            return false;
+        }
+
+        *value = d->strs.data[index];
+        return true;
+    }
+
+    case BS_SERIAL_ARRAY: {
+        size_t count;
+        if (!bs_serial_read_count(d, 1, &count)) {
+            return false;
+        }
+
+        Bs_Array *array = bs_array_new(bs);
+        if (count) {
+            array->data = bs_realloc(bs, NULL, 0, count * sizeof(*array->data));
+            array->capacity = count;
+            for (size_t i = 0; i < count; i++) {
+                array->data[i] = bs_value_nil;
+            }
+            array->count = count;
+        }
+
+        *value = bs_value_object(array);
+        return bs_serial_read_object(d, start, (Bs_Object *) array);
+    }
+
+    case BS_SERIAL_TABLE: {
+        size_t count;
+        if (!bs_serial_read_count(d, 2, &count)) {
+            return false;
+        }
+
+        Bs_Table *table = bs_table_new(bs);
+        bs_map_reserve(bs, &table->map, count);
+
+        // The entries left are counted down in the index
+        *value = bs_value_object(table);
+        if (!bs_serial_read_object(d, start, (Bs_Object *) table)) {
+            return false;
+        }
+
+        d->frames.data[d->frames.count - 1].index = count;
+        return true;
+    }
+
+    case BS_SERIAL_REF: {
+        size_t index;
+        if (!bs_serial_read_index(d, d->objects.count, &index)) {
+            return false;
+        }
+
+        *value = d->objects.data[index];
+        return true;
+    }
+
+    default:
+        return bs_serial_fail(d, start, "invalid tag");
+    }
+}
+
+// Reads the next item of the innermost container, or leaves it if it is complete
+static bool bs_serial_read_step(Bs_Deserializer *d) {
+    const size_t     top = d->frames.count - 1;
+    Bs_Serial_Frame *frame = &d->frames.data[top];
+
+    if (frame->object->type == BS_OBJECT_ARRAY) {
+        Bs_Array *array = (Bs_Array *) frame->object;
+        if (frame->index == array->count) {
+            d->frames.count--;
+            d->keys.count--;
+            return true;
+        }
+
+        // The frame can move as containers get pushed
+        const size_t index = frame->index++;
+        return bs_serial_read_value(d, &array->data[index]);
+    }
+
+    Bs_Table *table = (Bs_Table *) frame->object;
+    if (!frame->index) {
+        d->frames.count--;
+        d->keys.count--;
+        return true;
+    }
+
+    const uint8_t *start = d->p;
+
+    Bs_Value value;
+    if (!frame->value) {
+        frame->value = true;
+        if (!bs_serial_read_value(d, &value)) {
+            return false;
+        }
+
+        if (value.type == BS_VALUE_NIL) {
+            return bs_serial_fail(d, start, "table key cannot be nil");
+        }
+
+        d->keys.data[top] = value;
+        return true;
+    }
+
+    frame->value = false;
+    frame->index--;
+    if (!bs_serial_read_value(d, &value)) {
+        return false;
+    }
+
+    bs_map_set(d->bs, &table->map, d->keys.data[top], value);
+    return true;
+}
+
+static bool bs_serial_read_header(Bs_Deserializer *d) {
+    const size_t size = sizeof(BS_SERIAL_MAGIC) - 1;
+    if ((size_t) (d->end - d->p) < size + 1 || memcmp(d->p, BS_SERIAL_MAGIC, size)) {
+        return bs_serial_fail(d, d->p, "not serialized data");
+    }
+    d->p += size;
+
+    if (*d->p != BS_SERIAL_VERSION) {
+        return bs_serial_fail(d, d->p, "unsupported version");
+    }
+    d->p++;
+
+    size_t count;
+    if (!bs_serial_read_count(d, 1, &count)) {
+        return false;
+    }
+
+    if (!bs_serial_read_count(d, 2, &d->objects_total)) {
+        return false;
+    }
+
+    d->objects.data = bs_realloc(d->bs, NULL, 0, d->objects_total * sizeof(*d->objects.data));
+    d->objects.capacity = d->objects_total;
+
+    d->strs.data = bs_realloc(d->bs, NULL, 0, count * sizeof(*d->strs.data));
+    d->strs.capacity = count;
+    for (size_t i = 0; i < count; i++) {
+        size_t size;
+        if (!bs_serial_read_count(d, 1, &size)) {
+            return false;
+        }
+
+        const Bs_Sv sv = Bs_Sv((const char *) d->p, size);
+        d->strs.data[d->strs.count++] = bs_value_object(bs_str_new(d->bs, sv));
+        d->p += size;
+    }
+
+    return true;
+}
+
+bool bs_deserialize(Bs *bs, Bs_Sv input, Bs_Value *value, Bs_Serial_Error *error) {
+    Bs_Deserializer d = {
+        .bs = bs,
+        .begin = (const uint8_t *) input.data,
+        .p = (const uint8_t *) input.data,
+        .end = (const uint8_t *) input.data + input.size,
+        .error = error,
+    };
+
+    bool ok = bs_serial_read_header(&d) && bs_serial_read_value(&d, value);
+    while (ok && d.frames.count) {
+        ok = bs_serial_read_step(&d);
+    }
+
+    if (ok && d.objects.count != d.objects_total) {
+        ok = bs_serial_fail(&d, d.p, "fewer arrays and tables than declared");
+    }
+
+    if (ok && d.p < d.end) {
+        ok = bs_serial_fail(&d, d.p, "expected end of input");
+    }
+
+    bs_da_free(bs, &d.strs);
+    bs_da_free(bs, &d.objects);
+    bs_da_free(bs, &d.frames);
+    bs_da_free(bs, &d.keys);
+    return ok;
+}
@@ -9,6 +9,7 @@
 #    define bs_issep(c) ((c) == '/' || (c) == '\\')
 #else
 #    include <dlfcn.h>
+#    include <sys/mman.h>
 #    include <unistd.h>
 
 #    define bs_issep(c) ((c) == '/')
@@ -16,6 +17,7 @@
 
 #include "bs/compiler.h"
 #include "bs/core.h"
+#include "bs/jit.h"
 
 // #define BS_GC_DEBUG_LOG
 // #define BS_GC_DEBUG_STRESS
@@ -26,6 +28,11 @@
 #    include "bs/debug.h"
 #endif // BS_STEP_DEBUG
 
+// Counts the pairs and triples of ops dispatched by the interpreter and reports the most frequent
+// ones in bs_free(). Used for picking the sequences worth fusing into superinstructions
+// #define BS_OP_PROFILE
+#define BS_OP_PROFILE_TOP 32
+
 typedef struct {
     Bs_Value      *base;
     const uint8_t *ip;
@@ -41,11 +48,45 @@ typedef struct {
 typedef struct {
     Bs_Frame *data;
     size_t    count;
+    size_t    capacity;
 } Bs_Frames;
 
+// The variadic arguments of a running call, passed as an array which points into the stack rather
+// than owning its data. See bs_compile_variadic_view()
+typedef struct {
+    Bs_Array *array;
+    size_t    frame;
+    size_t    origin;
+} Bs_View;
+
+typedef struct {
+    Bs_View *data;
+    size_t   count;
+    size_t   capacity;
+} Bs_Views;
+
+// A call deferred until a frame returns. Either a closure, or a method invoked on a local of the
+// frame without arguments, in which case `fn` is the name of the method. The local is captured into
+// `receiver` the same way the closure would have captured it, either as a copy or as an upvalue
+typedef struct {
+    Bs_Value fn;
+    Bs_Value receiver;
+    size_t   frame;
+    size_t   ip;
+    bool     invoke;
+    bool     running;
+} Bs_Defer;
+
+typedef struct {
+    Bs_Defer *data;
+    size_t    count;
+    size_t    capacity;
+} Bs_Defers;
+
 typedef struct {
     size_t *data;
     size_t  count;
+    size_t  capacity;
 } Bs_Bases;
 
 typedef struct {
@@ -98,8 +139,61 @@ static bool bs_modules_find(Bs_Modules *modules, Bs_Sv name, size_t *index) {
 typedef struct {
     Bs_Value *data;
     size_t    count;
+    size_t    capacity;
 } Bs_Stack;
 
+// The stacks reserve address space for their maximum size up front and commit it as they grow.
+// Since they never move, pointers into them (frame bases, open upvalues, native arguments) stay
+// valid, and a VM which never recurses deeply only pays for the few pages it touched
+static void *bs_stack_reserve(size_t size) {
+#if defined(_WIN32) || defined(_WIN64)
+    void *data = VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void *data = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        data = NULL;
+    }
+#endif // _WIN32
+
+    assert(data);
+    return data;
+}
+
+static void bs_stack_release(void *data, size_t size) {
+#if defined(_WIN32) || defined(_WIN64)
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    munmap(data, size);
+#endif // _WIN32
+}
+
+// Commits enough of the reservation to hold at least `count` items of `size` bytes. Returns false
+// once the reservation is exhausted
+static bool bs_stack_commit(void *data, size_t *capacity, size_t count, size_t max, size_t size) {
+    if (count > max) {
+        return false;
+    }
+
+    size_t next = *capacity ? *capacity : BS_STACK_COMMIT_BYTES / size;
+    while (next < count) {
+        next *= 2;
+    }
+
+    if (next > max) {
+        next = max;
+    }
+
+#if defined(_WIN32) || defined(_WIN64)
+    const bool ok = VirtualAlloc(data, next * size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    const bool ok = mprotect(data, next * size, PROT_READ | PROT_WRITE) == 0;
+#endif // _WIN32
+
+    assert(ok);
+    *capacity = next;
+    return true;
+}
+
 typedef struct {
     Bs_Object **data;
     size_t      count;
@@ -124,6 +218,17 @@ struct Bs {
     Bs_Frame *frame;
     Bs_Frames frames;
 
+    // Nesting of bs_call(), which recurses on the C stack rather than the frames
+    size_t calls;
+
+    // The arrays lent to variadic arguments are never collected, and reused once the call which
+    // borrowed them returns
+    Bs_Views       views;
+    Bs_Object_List views_pool;
+
+    // The deferred calls of every frame, innermost last
+    Bs_Defers defers;
+
     // Filesystem
     Bs_Buffer  paths;
     Bs_Modules modules;
@@ -158,8 +263,73 @@ struct Bs {
 
     // Exit
     bool running;
+
+#ifdef BS_OP_PROFILE
+    size_t  profile_count;
+    Bs_Op   profile_last[2];
+    size_t  profile_pairs[BS_COUNT_OPS * BS_COUNT_OPS];
+    size_t *profile_triples;
+#endif // BS_OP_PROFILE
 };
 
+// Variadic views
+// Lends an array to the `count` variadic arguments at the top of the stack, which belong to a call
+// whose frame will be pushed next and whose result goes in `origin`
+static Bs_Array *bs_views_borrow(Bs *bs, size_t origin, size_t count) {
+    if (bs->views.count >= bs->views_pool.count) {
+        bs_object_list_push(&bs->views_pool, (Bs_Object *) bs_array_new(bs));
+    }
+
+    if (bs->views.count >= bs->views.capacity) {
+        bs->views.capacity = bs->views.capacity ? bs->views.capacity * 2 : BS_DA_INIT_CAP;
+        bs->views.data = realloc(bs->views.data, bs->views.capacity * sizeof(*bs->views.data));
+        assert(bs->views.data);
+    }
+
+    Bs_Array *array = (Bs_Array *) bs->views_pool.data[bs->views.count];
+    array->data = &bs->stack.data[bs->stack.count - count];
+    array->count = count;
+
+    bs->views.data[bs->views.count++] = (Bs_View) {
+        .array = array,
+        .frame = bs->frames.count,
+        .origin = origin,
+    };
+    return array;
+}
+
+// Gives back the arrays lent to the calls after the first `count`. Their data is owned by the
+// stack, so it must never be freed or marked once the calls are gone
+static void bs_views_release(Bs *bs, size_t count) {
+    while (bs->views.count > count) {
+        Bs_Array *array = bs->views.data[--bs->views.count].array;
+        array->data = NULL;
+        array->count = 0;
+    }
+}
+
+// Deferred calls
+static void bs_defers_push(Bs *bs, Bs_Defer defer) {
+    if (bs->defers.count >= bs->defers.capacity) {
+        bs->defers.capacity = bs->defers.capacity ? bs->defers.capacity * 2 : BS_DA_INIT_CAP;
+        bs->defers.data = realloc(bs->defers.data, bs->defers.capacity * sizeof(*bs->defers.data));
+        assert(bs->defers.data);
+    }
+
+    bs->defers.data[bs->defers.count++] = defer;
+}
+
+// The innermost deferred call of the frame at `frame`, if any is left
+static Bs_Defer *bs_defers_top(Bs *bs, size_t frame) {
+    for (size_t i = bs->defers.count; i > 0 && bs->defers.data[i - 1].frame >= frame; i--) {
+        if (bs->defers.data[i - 1].frame == frame) {
+            return &bs->defers.data[i - 1];
+        }
+    }
+
+    return NULL;
+}
+
 // Garbage collector
 static_assert(BS_COUNT_OBJECTS == 13, "Update bs_free_object()");
 static void bs_free_object(Bs *bs, Bs_Object *object) {
@@ -170,6 +340,9 @@ static void bs_free_object(Bs *bs, Bs_Object *object) {
     switch (object->type) {
     case BS_OBJECT_FN: {
         Bs_Fn *fn = (Bs_Fn *) object;
+        if (fn->jit) {
+            bs_jit_free(bs, fn->jit);
+        }
         bs_chunk_free(bs, &fn->chunk);
         bs_realloc(bs, fn, sizeof(*fn), 0);
     } break;
@@ -192,8 +365,7 @@ static void bs_free_object(Bs *bs, Bs_Object *object) {
 
     case BS_OBJECT_CLOSURE: {
         Bs_Closure *closure = (Bs_Closure *) object;
-        bs_da_free(bs, &closure->defers);
-        bs_realloc(bs, closure, sizeof(*closure) + sizeof(Bs_Upvalue *) * closure->upvalues, 0);
+        bs_realloc(bs, closure, sizeof(*closure) + sizeof(Bs_Value) * closure->upvalues, 0);
     } break;
 
     case BS_OBJECT_UPVALUE:
@@ -252,7 +424,7 @@ static void bs_free_object(Bs *bs, Bs_Object *object) {
     }
 }
 
-static void bs_mark_value(Bs *bs, Bs_Value value) {
+void bs_mark_value(Bs *bs, Bs_Value value) {
     if (value.type == BS_VALUE_OBJECT) {
         bs_mark(bs, value.as.object);
     }
@@ -279,6 +451,7 @@ static void bs_blacken_object(Bs *bs, Bs_Object *object) {
         Bs_Fn *fn = (Bs_Fn *) object;
         bs_mark(bs, (Bs_Object *) fn->name);
         bs_mark(bs, (Bs_Object *) fn->source);
+        bs_mark(bs, (Bs_Object *) fn->closure);
 
         for (size_t i = 0; i < fn->chunk.constants.count; i++) {
             bs_mark_value(bs, fn->chunk.constants.data[i]);
@@ -305,12 +478,8 @@ static void bs_blacken_object(Bs *bs, Bs_Object *object) {
         Bs_Closure *closure = (Bs_Closure *) object;
         bs_mark(bs, (Bs_Object *) closure->fn);
 
-        for (size_t i = 0; i < closure->defers.count; i++) {
-            bs_mark(bs, (Bs_Object *) closure->defers.data[i]);
-        }
-
         for (size_t i = 0; i < closure->upvalues; i++) {
-            bs_mark(bs, (Bs_Object *) closure->data[i]);
+            bs_mark_value(bs, closure->data[i]);
         }
     } break;
 
@@ -335,6 +504,7 @@ static void bs_blacken_object(Bs *bs, Bs_Object *object) {
         Bs_C_Class *class = (Bs_C_Class *) object;
         bs_mark(bs, (Bs_Object *) class->init);
         bs_mark_map(bs, &class->methods);
+        bs_mark_value(bs, class->shared);
     } break;
 
     case BS_OBJECT_C_INSTANCE: {
@@ -382,6 +552,15 @@ static void bs_collect(Bs *bs) {
 
     bs_mark(bs, (Bs_Object *) bs->config.cwd);
 
+    for (size_t i = 0; i < bs->views_pool.count; i++) {
+        bs_mark(bs, bs->views_pool.data[i]);
+    }
+
+    for (size_t i = 0; i < bs->defers.count; i++) {
+        bs_mark_value(bs, bs->defers.data[i].fn);
+        bs_mark_value(bs, bs->defers.data[i].receiver);
+    }
+
     for (size_t i = 0; i < bs->modules.count; i++) {
         Bs_Module *m = &bs->modules.data[i];
         bs_mark(bs, (Bs_Object *) m->name);
@@ -457,6 +636,61 @@ static void bs_collect(Bs *bs) {
     bs->gc_on = gc_on_save;
 }
 
+#ifdef BS_OP_PROFILE
+// Op profiler
+static void bs_op_profile(Bs *bs, Bs_Op op) {
+    if (bs->profile_count >= 1) {
+        bs->profile_pairs[bs->profile_last[1] * BS_COUNT_OPS + op]++;
+    }
+
+    if (bs->profile_count >= 2) {
+        const size_t prefix = bs->profile_last[0] * BS_COUNT_OPS + bs->profile_last[1];
+        bs->profile_triples[prefix * BS_COUNT_OPS + op]++;
+    }
+
+    bs->profile_count++;
+    bs->profile_last[0] = bs->profile_last[1];
+    bs->profile_last[1] = op;
+}
+
+typedef struct {
+    size_t count;
+    size_t index;
+} Bs_Op_Profile_Entry;
+
+static int bs_op_profile_entry_compare(const void *a, const void *b) {
+    const Bs_Op_Profile_Entry *p = a;
+    const Bs_Op_Profile_Entry *q = b;
+    return (p->count < q->count) - (p->count > q->count);
+}
+
+static void bs_op_profile_report(Bs *bs, const size_t *counts, size_t length, size_t width) {
+    Bs_Op_Profile_Entry *entries = malloc(length * sizeof(*entries));
+    assert(entries);
+
+    for (size_t i = 0; i < length; i++) {
+        entries[i] = (Bs_Op_Profile_Entry) {.count = counts[i], .index = i};
+    }
+    qsort(entries, length, sizeof(*entries), bs_op_profile_entry_compare);
+
+    Bs_Writer *w = &bs->config.log;
+    for (size_t i = 0; i < length && i < BS_OP_PROFILE_TOP && entries[i].count; i++) {
+        Bs_Op ops[3];
+        for (size_t j = width, index = entries[i].index; j > 0; j--, index /= BS_COUNT_OPS) {
+            ops[j - 1] = index % BS_COUNT_OPS;
+        }
+
+        bs_fmt(w, "%12zu  ", entries[i].count);
+        for (size_t j = 0; j < width; j++) {
+            bs_fmt(w, "%s%s", j ? " " : "", bs_op_name(ops[j]));
+        }
+        bs_fmt(w, "\n");
+    }
+
+    free(entries);
+}
+#endif // BS_OP_PROFILE
+
 // Interface
 void bs_buffer_write(Bs_Writer *w, Bs_Sv sv) {
     Bs_Buffer *b = w->data;
@@ -467,22 +701,31 @@ Bs *bs_new(int argc, char **argv) {
     Bs *bs = calloc(1, sizeof(Bs));
     assert(bs);
 
-    bs->stack.data = malloc(BS_STACK_CAPACITY * sizeof(*bs->stack.data));
-    assert(bs->stack.data);
+    bs->stack.data = bs_stack_reserve(BS_STACK_CAPACITY * sizeof(*bs->stack.data));
+    bs_stack_commit(
+        bs->stack.data, &bs->stack.capacity, 1, BS_STACK_CAPACITY, sizeof(*bs->stack.data));
 
-    bs->bases.data = malloc(BS_FRAMES_CAPACITY * sizeof(*bs->bases.data));
-    assert(bs->bases.data);
+    bs->bases.data = bs_stack_reserve(BS_FRAMES_CAPACITY * sizeof(*bs->bases.data));
+    bs_stack_commit(
+        bs->bases.data, &bs->bases.capacity, 1, BS_FRAMES_CAPACITY, sizeof(*bs->bases.data));
 
-    bs->frames.data = malloc(BS_FRAMES_CAPACITY * sizeof(*bs->frames.data));
-    assert(bs->frames.data);
+    bs->frames.data = bs_stack_reserve(BS_FRAMES_CAPACITY * sizeof(*bs->frames.data));
+    bs_stack_commit(
+        bs->frames.data, &bs->frames.capacity, 1, BS_FRAMES_CAPACITY, sizeof(*bs->frames.data));
 
     bs->gc_max = 1024 * 1024;
 
+#ifdef BS_OP_PROFILE
+    bs->profile_triples = calloc(BS_COUNT_OPS * BS_COUNT_OPS * BS_COUNT_OPS, sizeof(size_t));
+    assert(bs->profile_triples);
+#endif // BS_OP_PROFILE
+
     bs->paths.bs = bs;
     bs->config.buffer.bs = bs;
 
     bs->config.log = bs_file_writer(stdout);
     bs->config.error.write = bs_error_write_default;
+    bs->config.jit = true;
 
     bs_update_cwd(bs);
     bs_core_init(bs, argc, argv);
@@ -493,13 +736,23 @@ Bs *bs_new(int argc, char **argv) {
 }
 
 void bs_free(Bs *bs) {
-    free(bs->stack.data);
+#ifdef BS_OP_PROFILE
+    bs_fmt(&bs->config.log, "\nOp pairs:\n");
+    bs_op_profile_report(bs, bs->profile_pairs, bs_c_array_size(bs->profile_pairs), 2);
+
+    bs_fmt(&bs->config.log, "\nOp triples:\n");
+    bs_op_profile_report(
+        bs, bs->profile_triples, BS_COUNT_OPS * BS_COUNT_OPS * BS_COUNT_OPS, 3);
+    free(bs->profile_triples);
+#endif // BS_OP_PROFILE
+
+    bs_stack_release(bs->stack.data, BS_STACK_CAPACITY * sizeof(*bs->stack.data));
     memset(&bs->stack, 0, sizeof(bs->stack));
 
-    free(bs->bases.data);
+    bs_stack_release(bs->bases.data, BS_FRAMES_CAPACITY * sizeof(*bs->bases.data));
     memset(&bs->bases, 0, sizeof(bs->bases));
 
-    free(bs->frames.data);
+    bs_stack_release(bs->frames.data, BS_FRAMES_CAPACITY * sizeof(*bs->frames.data));
     memset(&bs->frames, 0, sizeof(bs->frames));
 
     bs_modules_free(bs, &bs->modules);
@@ -521,6 +774,9 @@ void bs_free(Bs *bs) {
     }
     free(bs->grays.data);
     free(bs->handles.data);
+    free(bs->views_pool.data);
+    free(bs->views.data);
+    free(bs->defers.data);
 
     bs_da_free(bs, &bs->paths);
     bs_da_free(bs, &bs->config.buffer);
@@ -590,6 +846,10 @@ Bs_Str *bs_str_new(Bs *bs, Bs_Sv sv) {
     const uint32_t hash = bs_hash_bytes(sv.data, sv.size);
     Bs_Entry      *entry = bs_entries_find_sv(bs->strings.data, bs->strings.capacity, sv, hash);
     if (entry && entry->key.type != BS_VALUE_NIL) {
+        // The string may only be reachable from garbage, so it needs a handle just like a new one
+        if (bs->handles_on) {
+            bs_object_list_push(&bs->handles, entry->key.as.object);
+        }
         return (Bs_Str *) entry->key.as.object;
     }
 
@@ -819,6 +1079,9 @@ Bs_Unwind bs_unwind_save(Bs *bs) {
     u.stack_count = bs->stack.count;
     u.bases_count = bs->bases.count;
     u.frames_count = bs->frames.count;
+    u.calls = bs->calls;
+    u.views_count = bs->views.count;
+    u.defers_count = bs->defers.count;
     return u;
 }
 
@@ -827,6 +1090,9 @@ void bs_unwind_restore(Bs *bs, const Bs_Unwind *u) {
     bs->stack.count = u->stack_count;
     bs->bases.count = u->bases_count;
     bs->frames.count = u->frames_count;
+    bs->calls = u->calls;
+    bs_views_release(bs, u->views_count);
+    bs->defers.count = u->defers_count;
     bs->frame = bs->frames.count ? &bs->frames.data[bs->frames.count - 1] : NULL;
 }
 
@@ -871,6 +1137,19 @@ static Bs_Op_Loc *bs_chunk_get_op_loc(const Bs_Chunk *c, size_t op_index) {
     assert(false && "unreachable");
 }
 
+// The locations of the op a frame is at. A frame which is running one of its deferred calls sits
+// on its RET, so the locations of the DEFER which scheduled the call are used instead
+static const Bs_Op_Loc *bs_frame_get_op_loc(Bs *bs, const Bs_Frame *frame) {
+    const Bs_Chunk *chunk = &frame->closure->fn->chunk;
+
+    const Bs_Defer *defer = bs_defers_top(bs, frame - bs->frames.data);
+    if (defer && defer->running) {
+        return bs_chunk_get_op_loc(chunk, defer->ip);
+    }
+
+    return bs_chunk_get_op_loc(chunk, frame->ip - chunk->data);
+}
+
 void bs_unwind(Bs *bs, unsigned char exit) {
     bs->config.unwind.exit = exit;
     longjmp(bs->config.unwind.point, 1);
@@ -908,16 +1187,13 @@ Bs_Error bs_error_begin_at(Bs *bs, size_t location) {
     };
 
     if (bs->frame->ip) {
-        const Bs_Op_Loc *oploc = bs_chunk_get_op_loc(
-            &bs->frame->closure->fn->chunk, bs->frame->ip - bs->frame->closure->fn->chunk.data);
-
+        const Bs_Op_Loc *oploc = bs_frame_get_op_loc(bs, bs->frame);
         error.loc = oploc[location].loc;
     } else {
         error.native = true;
         if (bs->frames.data[bs->frames.count - 2].ip) {
             const Bs_Frame  *prev = &bs->frames.data[bs->frames.count - 2];
-            const Bs_Op_Loc *oploc = bs_chunk_get_op_loc(
-                &prev->closure->fn->chunk, prev->ip - prev->closure->fn->chunk.data);
+            const Bs_Op_Loc *oploc = bs_frame_get_op_loc(bs, prev);
 
             error.native = false;
             error.loc = oploc[location + bs->frame->locations_offset].loc;
@@ -949,8 +1225,7 @@ void bs_error_end_at(Bs *bs, size_t location, bool native) {
         Bs_Error error = {.type = BS_ERROR_TRACE};
 
         if (caller->ip) {
-            const Bs_Fn     *fn = caller->closure->fn;
-            const Bs_Op_Loc *oploc = bs_chunk_get_op_loc(&fn->chunk, caller->ip - fn->chunk.data);
+            const Bs_Op_Loc *oploc = bs_frame_get_op_loc(bs, caller);
             if (native) {
                 oploc += location;
             }
@@ -1279,16 +1554,32 @@ void bs_check_ascii_code_at(Bs *bs, size_t location, Bs_Value value, const char
 }
 
 // Interpreter
-static void bs_stack_push(Bs *bs, Bs_Value value) {
-    if (bs->stack.count >= BS_STACK_CAPACITY) {
+// Makes sure the stack can hold `count` values. Functions reserve their whole stack size when they
+// are called, so nothing pushed by the interpreter itself needs to be checked
+static void bs_stack_ensure(Bs *bs, size_t count) {
+    if (count > bs->stack.capacity &&
+        !bs_stack_commit(
+            bs->stack.data,
+            &bs->stack.capacity,
+            count,
+            BS_STACK_CAPACITY,
+            sizeof(*bs->stack.data))) {
         bs_error_standalone_unwind(bs, "stack overflow");
     }
+}
 
+static void bs_stack_push(Bs *bs, Bs_Value value) {
     bs->stack.data[bs->stack.count++] = value;
 }
 
 static void bs_bases_push(Bs *bs, size_t base) {
-    if (bs->bases.count >= BS_FRAMES_CAPACITY) {
+    if (bs->bases.count >= bs->bases.capacity &&
+        !bs_stack_commit(
+            bs->bases.data,
+            &bs->bases.capacity,
+            bs->bases.count + 1,
+            BS_FRAMES_CAPACITY,
+            sizeof(*bs->bases.data))) {
         bs_error_standalone_unwind(bs, "stack overflow");
     }
 
@@ -1296,7 +1587,13 @@ static void bs_bases_push(Bs *bs, size_t base) {
 }
 
 static void bs_frames_push(Bs *bs, Bs_Frame frame) {
-    if (bs->frames.count >= BS_FRAMES_CAPACITY) {
+    if (bs->frames.count >= bs->frames.capacity &&
+        !bs_stack_commit(
+            bs->frames.data,
+            &bs->frames.capacity,
+            bs->frames.count + 1,
+            BS_FRAMES_CAPACITY,
+            sizeof(*bs->frames.data))) {
         bs_error_standalone_unwind(bs, "stack overflow");
     }
 
@@ -1342,6 +1639,121 @@ static void bs_binary_op(Bs *bs, Bs_Value *a, Bs_Value *b, const char *op) {
     }
 }
 
+// Quickening
+//
+// A generic op which observes the operand types one of its quickened variants is specialized for
+// rewrites itself in place. A quickened op whose guard fails rewrites itself back and rewinds the
+// instruction pointer, so that the generic op gets dispatched again (and reports any errors)
+static void bs_quicken(uint8_t *site, Bs_Op op) {
+    *site = op;
+}
+
+static void bs_dequicken(Bs *bs, uint8_t *site) {
+    *site = bs_op_generic(*site);
+    bs->frame->ip = site;
+}
+
+static bool bs_binary_op_num(Bs *bs, uint8_t *site, double *a, double *b) {
+    const Bs_Value y = bs_stack_peek(bs, 0);
+    const Bs_Value x = bs_stack_peek(bs, 1);
+
+    if (x.type != BS_VALUE_NUM || y.type != BS_VALUE_NUM) {
+        bs_dequicken(bs, site);
+        return false;
+    }
+
+    bs->stack.count -= 2;
+    *a = x.as.number;
+    *b = y.as.number;
+    return true;
+}
+
+// Register forms
+//
+// The operands are read straight from the frame or the constants. When they do not suit the fast
+// path, a register form gives up before changing anything and lets the stack code it was laid over
+// run instead, which takes care of everything else including the errors
+static Bs_Value bs_register_read(Bs *bs) {
+    const Bs_Op op = *bs->frame->ip++;
+    if (op == BS_OP_CONST) {
+        return bs_chunk_read_const(bs);
+    }
+
+    // An LGET, or a superinstruction laid over it
+    return bs->frame->base[bs_chunk_read_int(bs)];
+}
+
+// Inlined into every register form, so that each one dispatches on the operator by itself
+static inline bool bs_register_binary(Bs_Op op, Bs_Value a, Bs_Value b, Bs_Value *result) {
+    if (op == BS_OP_EQ || op == BS_OP_NE) {
+        *result = bs_value_bool(bs_value_equal(a, b) == (op == BS_OP_EQ));
+        return true;
+    }
+
+    if (a.type != BS_VALUE_NUM || b.type != BS_VALUE_NUM) {
+        return false;
+    }
+
+    const double x = a.as.number;
+    const double y = b.as.number;
+
+    // The op in the sequence gets quickened whenever the fallback runs it
+    switch (op) {
+    case BS_OP_ADD:
+    case BS_OP_ADD_NUM:
+        *result = bs_value_num(x + y);
+        break;
+
+    case BS_OP_SUB:
+    case BS_OP_SUB_NUM:
+        *result = bs_value_num(x - y);
+        break;
+
+    case BS_OP_MUL:
+    case BS_OP_MUL_NUM:
+        *result = bs_value_num(x * y);
+        break;
+
+    case BS_OP_DIV:
+    case BS_OP_DIV_NUM:
+        *result = bs_value_num(x / y);
+        break;
+
+    case BS_OP_MOD: {
+        double mod = fmod(x, y);
+        if (mod < 0) {
+            mod += fabs(y);
+        }
+        *result = bs_value_num(mod);
+    } break;
+
+    case BS_OP_GT:
+    case BS_OP_GT_NUM:
+        *result = bs_value_bool(x > y);
+        break;
+
+    case BS_OP_GE:
+    case BS_OP_GE_NUM:
+        *result = bs_value_bool(x >= y);
+        break;
+
+    case BS_OP_LT:
+    case BS_OP_LT_NUM:
+        *result = bs_value_bool(x < y);
+        break;
+
+    case BS_OP_LE:
+    case BS_OP_LE_NUM:
+        *result = bs_value_bool(x <= y);
+        break;
+
+    default:
+        assert(false && "unreachable");
+    }
+
+    return true;
+}
+
 static void bs_call_c_fn(Bs *bs, size_t offset, const Bs_C_Fn *native, size_t arity) {
     const Bs_Frame frame = {
         .base = &bs->stack.data[bs->stack.count - arity],
@@ -1360,9 +1772,53 @@ static void bs_call_c_fn(Bs *bs, size_t offset, const Bs_C_Fn *native, size_t ar
     bs->stack.data[bs->stack.count - 1] = value;
 }
 
+// Runs the machine code of the current frame from its current op, if it has been compiled
+static void bs_jit_enter(Bs *bs) {
+    Bs_Frame  *frame = bs->frame;
+    Bs_Chunk  *chunk = &frame->closure->fn->chunk;
+    Bs_Value  *top = &bs->stack.data[bs->stack.count];
+    const size_t offset = frame->ip - chunk->data;
+
+    frame->ip = chunk->data + bs_jit_run(frame->closure->fn->jit, offset, frame->base, &top);
+    bs->stack.count = top - bs->stack.data;
+}
+
+// Function entries and loop back edges count towards compiling the current function
+static void bs_jit_tick(Bs *bs) {
+    Bs_Fn *fn = bs->frame->closure->fn;
+    if (!fn->jit) {
+        if (!bs->config.jit || ++fn->hotness != BS_JIT_THRESHOLD) {
+            return;
+        }
+
+        fn->jit = bs_jit_compile(bs, fn);
+        if (!fn->jit) {
+            return;
+        }
+    }
+
+    bs_jit_enter(bs);
+}
+
+// Pushes the frame of a closure whose receiver and arguments are already on the stack from `base`
+static void bs_call_closure_frame(Bs *bs, size_t location, Bs_Closure *closure, size_t base) {
+    bs_stack_ensure(bs, base + closure->fn->stack_size);
+
+    const Bs_Frame frame = {
+        .base = &bs->stack.data[base],
+        .ip = closure->fn->chunk.data,
+        .closure = closure,
+        .locations_offset = location,
+    };
+
+    bs_frames_push(bs, frame);
+    bs->frame = &bs->frames.data[bs->frames.count - 1];
+    bs_jit_tick(bs);
+}
+
 static void bs_call_closure(Bs *bs, size_t location, Bs_Closure *closure, size_t arity) {
     // Preserve the frame base before the variadic resolution
-    const size_t base = bs->stack.count - arity - 1;
+    size_t base = bs->stack.count - arity - 1;
 
     if (closure->fn->variadic) {
         const size_t minimum = closure->fn->arity - 1;
@@ -1376,35 +1832,38 @@ static void bs_call_closure(Bs *bs, size_t location, Bs_Closure *closure, size_t
                 arity);
         }
 
-        const bool   handles_on_save = bs->handles_on;
-        const size_t handles_count_save = bs->handles.count;
-        bs->handles_on = true;
+        if (closure->fn->variadic_view) {
+            // Leave the variadic arguments where they are, and start the frame right above them
+            // with a copy of the receiver and the other arguments
+            const size_t origin = base;
+            base = bs->stack.count;
+            bs_stack_ensure(bs, base + closure->fn->stack_size);
+
+            const Bs_Array *args = bs_views_borrow(bs, origin, arity - minimum);
+            memcpy(&bs->stack.data[base], &bs->stack.data[origin], (minimum + 1) * sizeof(Bs_Value));
+            bs->stack.count += minimum + 1;
+            bs_stack_push(bs, bs_value_object(args));
+        } else {
+            const bool   handles_on_save = bs->handles_on;
+            const size_t handles_count_save = bs->handles.count;
+            bs->handles_on = true;
 
-        Bs_Array *args = bs_array_new(bs);
-        for (size_t i = base + minimum + 1; i < bs->stack.count; i++) {
-            bs_array_set(bs, args, args->count, bs->stack.data[i]);
-        }
+            Bs_Array *args = bs_array_new(bs);
+            for (size_t i = base + minimum + 1; i < bs->stack.count; i++) {
+                bs_array_set(bs, args, args->count, bs->stack.data[i]);
+            }
 
-        bs->stack.count = base + minimum + 1;
-        bs_stack_push(bs, bs_value_object(args));
+            bs->stack.count = base + minimum + 1;
+            bs_stack_push(bs, bs_value_object(args));
 
-        bs->handles_on = handles_on_save;
-        bs->handles.count = handles_count_save;
+            bs->handles_on = handles_on_save;
+            bs->handles.count = handles_count_save;
+        }
     } else {
         bs_check_arity_at(bs, location, arity, closure->fn->arity);
     }
 
-    const Bs_Frame frame = {
-        .base = &bs->stack.data[base],
-        .ip = closure->fn->chunk.data,
-        .closure = closure,
-        .locations_offset = location,
-    };
-
-    bs_frames_push(bs, frame);
-    bs->frame = &bs->frames.data[bs->frames.count - 1];
-
-    closure->defer_started = false;
+    bs_call_closure_frame(bs, location, closure, base);
 }
 
 static_assert(BS_COUNT_OBJECTS == 13, "Update bs_call_value()");
@@ -1521,21 +1980,60 @@ static void bs_close_upvalues(Bs *bs, Bs_Value *last) {
     }
 }
 
-const Bs_Closure *bs_compile_module(Bs *bs, Bs_Sv path, Bs_Sv input, bool is_main, bool is_repl) {
+// Replaces the frame of the caller with the one that was just pushed for the callee, which reuses
+// the stack window of the caller. The caller must have nothing left to do once the call returns
+static void bs_tail_call_collapse(Bs *bs) {
+    Bs_Frame *caller = &bs->frames.data[bs->frames.count - 2];
+    Bs_Frame  callee = bs->frames.data[bs->frames.count - 1];
+
+    bs_close_upvalues(bs, caller->base);
+
+    const size_t size = &bs->stack.data[bs->stack.count] - callee.base;
+    memmove(caller->base, callee.base, size * sizeof(*callee.base));
+    bs->stack.count = caller->base - bs->stack.data + size;
+
+    callee.base = caller->base;
+    callee.locations_offset = caller->locations_offset;
+    *caller = callee;
+
+    bs->frames.count--;
+    bs->frame = caller;
+}
+
+static Bs_Module bs_module_new(Bs *bs, Bs_Sv path) {
     Bs_Module module = {
         .name = bs_str_new(bs, path),
         .length = path.size,
     };
 
+    if (bs_sv_suffix(path, Bs_Sv_Static(".bs"))) {
+        module.length -= 3;
+    }
+
+    return module;
+}
+
+static void bs_module_push(Bs *bs, Bs_Module module) {
+    Bs_Sv dir = Bs_Sv(module.name->data, module.name->size);
+    for (size_t i = dir.size; i > 0; i--) {
+        if (bs_issep(dir.data[i - 1])) {
+            dir.size = bs_max(i - 1, 1);
+            module.parent_dir = dir;
+            break;
+        }
+    }
+
+    bs_modules_push(bs, &bs->modules, module);
+}
+
+const Bs_Closure *bs_compile_module(Bs *bs, Bs_Sv path, Bs_Sv input, bool is_main, bool is_repl) {
+    Bs_Module module = bs_module_new(bs, path);
+
     // The main and repl contents are owned outside of BS. Don't take ownership over those
     if (!is_main && !is_repl) {
         module.source = input.data;
     }
 
-    if (bs_sv_suffix(path, Bs_Sv_Static(".bs"))) {
-        module.length -= 3;
-    }
-
     // Do not use the paramater 'path' directly as the same buffer is being written into
     const Bs_Sv relative = bs_buffer_relative_path(
         &bs->paths, Bs_Sv(module.name->data, module.name->size), (Bs_Sv) {0});
@@ -1549,16 +2047,7 @@ const Bs_Closure *bs_compile_module(Bs *bs, Bs_Sv path, Bs_Sv input, bool is_mai
     if (is_repl) {
         bs->modules.data[0] = module;
     } else {
-        Bs_Sv dir = Bs_Sv(module.name->data, module.name->size);
-        for (size_t i = dir.size; i > 0; i--) {
-            if (bs_issep(dir.data[i - 1])) {
-                dir.size = bs_max(i - 1, 1);
-                module.parent_dir = dir;
-                break;
-            }
-        }
-
-        bs_modules_push(bs, &bs->modules, module);
+        bs_module_push(bs, module);
     }
     return closure;
 }
@@ -1722,6 +2211,23 @@ bs_check_map_get(Bs *bs, size_t location, Bs_Map *map, Bs_Value index, const cha
     return value;
 }
 
+// Native classes with get and set hooks are indexed just like arrays
+static size_t bs_c_instance_index(Bs *bs, const Bs_C_Instance *instance, Bs_Value index) {
+    bs_check_whole_number_at(bs, 1, index, "index");
+
+    const size_t at = index.as.number;
+    const size_t count = instance->class->count(instance->data);
+    if (at >= count) {
+        bs_error(
+            bs,
+            "cannot access index %zu in " Bs_Sv_Fmt " of length %zu",
+            at,
+            Bs_Sv_Arg(instance->class->name),
+            count);
+    }
+    return at;
+}
+
 static Bs_Value bs_container_get(Bs *bs, Bs_Value container, Bs_Value index) {
     if (container.type == BS_VALUE_NIL || container.type == BS_VALUE_BOOL) {
         const Bs_Sv sv = bs_value_type_name_full(container);
@@ -1831,6 +2337,11 @@ static Bs_Value bs_container_get(Bs *bs, Bs_Value container, Bs_Value index) {
 
     case BS_OBJECT_C_INSTANCE: {
         Bs_C_Instance *instance = (Bs_C_Instance *) container.as.object;
+        if (index.type == BS_VALUE_NUM && instance->class->get) {
+            const size_t at = bs_c_instance_index(bs, instance, index);
+            return instance->class->get(bs, instance->data, at);
+        }
+
         return bs_value_object(bs_bound_method_new(
             bs,
             container,
@@ -1869,43 +2380,283 @@ static void bs_container_set(Bs *bs, Bs_Value container, Bs_Value index, Bs_Valu
     } else if (container.as.object->type == BS_OBJECT_INSTANCE) {
         bs_check_index_valid_type(bs, 1, index, "instance property");
         bs_map_set(bs, &((Bs_Instance *) container.as.object)->properties, index, value);
+    } else if (
+        container.as.object->type == BS_OBJECT_C_INSTANCE &&
+        ((Bs_C_Instance *) container.as.object)->class->set) {
+        Bs_C_Instance *instance = (Bs_C_Instance *) container.as.object;
+        const size_t   at = bs_c_instance_index(bs, instance, index);
+        instance->class->set(bs, instance->data, at, value);
     } else {
         const Bs_Sv sv = bs_value_type_name_full(container);
         bs_error(bs, "cannot take mutable index into " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
     }
 }
 
-static void bs_iter_map(Bs *bs, size_t offset, const Bs_Map *map, Bs_Value iterator) {
-    size_t index;
-    if (iterator.type == BS_VALUE_NIL) {
-        index = 0;
-    } else {
-        index = iterator.as.number + 1;
-    }
-
-    while (index < map->capacity && map->data[index].key.type == BS_VALUE_NIL) {
-        index++;
-    }
-
-    if (index >= map->capacity) {
-        bs->frame->ip += offset;
+static Bs_Value
+bs_invoke_instance_method(Bs *bs, Bs_Instance *instance, Bs_Value name, size_t arity) {
+    Bs_Value method;
+    if (bs_map_get(bs, &instance->properties, name, &method)) {
+        bs_stack_set(bs, arity, method);
     } else {
-        const Bs_Entry entry = map->data[index];
-        bs_stack_set(bs, 0, bs_value_num(index)); // Iterator
-        bs_stack_push(bs, entry.key);             // Key
-        bs_stack_push(bs, entry.value);           // Value
+        method =
+            bs_check_map_get(bs, 1, &instance->class->methods, name, "instance property or method");
     }
+    return method;
 }
 
-static_assert(BS_COUNT_OPS == 77, "Update bs_interpret()");
-static void bs_interpret(Bs *bs, Bs_Value *output) {
-    const bool   gc_on_save = bs->gc_on;
-    const bool   handles_on_save = bs->handles_on;
-    const size_t frames_count_save = bs->frames.count;
+// Invokes the method `name` on the receiver below the `arity` arguments at the top of the stack.
+// Returns whether the receiver was an instance, in which case the site can be quickened
+static bool bs_invoke(Bs *bs, Bs_Value name, size_t arity) {
+    const Bs_Value this = bs_stack_peek(bs, arity);
+
+    Bs_Value method;
+    bool     quicken = false;
+    if (this.type == BS_VALUE_NUM) {
+        method = bs_check_map_get(bs, 1, bs_builtin_number_methods_map(bs), name, "method");
+    } else if (this.type == BS_VALUE_OBJECT) {
+        switch (this.as.object->type) {
+        case BS_OBJECT_STR:
+        case BS_OBJECT_ARRAY:
+            method = bs_check_map_get(
+                bs,
+                1,
+                bs_builtin_object_methods_map(bs, this.as.object->type),
+                name,
+                "method");
+            break;
 
-    bs->gc_on = true;
-    bs->handles_on = false;
-    while (true) {
+        case BS_OBJECT_TABLE: {
+            Bs_Table *table = (Bs_Table *) this.as.object;
+            if (bs_map_get(bs, &table->map, name, &method)) {
+                bs_stack_set(bs, arity, method);
+            } else {
+                method = bs_check_map_get(
+                    bs,
+                    1,
+                    bs_builtin_object_methods_map(bs, this.as.object->type),
+                    name,
+                    "table key");
+            }
+        } break;
+
+        case BS_OBJECT_INSTANCE:
+            method = bs_invoke_instance_method(bs, (Bs_Instance *) this.as.object, name, arity);
+            quicken = true;
+            break;
+
+        case BS_OBJECT_C_INSTANCE: {
+            Bs_C_Instance *instance = (Bs_C_Instance *) this.as.object;
+            method =
+                bs_check_map_get(bs, 1, &instance->class->methods, name, "instance property or method");
+        } break;
+
+        case BS_OBJECT_C_LIB: {
+            Bs_C_Lib *library = (Bs_C_Lib *) this.as.object;
+            method = bs_check_map_get(bs, 1, &library->map, name, "library symbol");
+            bs_stack_set(bs, arity, method);
+        } break;
+
+        default: {
+            const Bs_Sv sv = bs_value_type_name_full(this);
+            bs_error_at(bs, 0, "cannot invoke or index into " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
+        } break;
+        }
+    } else {
+        const Bs_Sv sv = bs_value_type_name_full(this);
+        bs_error_at(bs, 0, "cannot invoke or index into " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
+    }
+
+    bs_call_value(bs, 2, method, arity);
+    return quicken;
+}
+
+// Number of iterations of a range with integral bounds, or nil when the loop has to compare the
+// counter against the end on every iteration instead. The bounds are limited to where doubles
+// still represent every integer, so that stepping the counter never rounds
+static Bs_Value bs_range_count(double start, double end, double step, bool inclusive) {
+    const double limit = 1ll << 52;
+    if (step == 0 || fabs(start) > limit || fabs(end) > limit || fabs(step) > limit ||
+        start != floor(start) || end != floor(end) || step != floor(step)) {
+        return bs_value_nil;
+    }
+
+    int64_t distance = (int64_t) end - (int64_t) start;
+    int64_t stride = step;
+    if (stride < 0) {
+        distance = -distance;
+        stride = -stride;
+    }
+
+    int64_t count;
+    if (inclusive) {
+        count = distance < 0 ? 0 : distance / stride + 1;
+    } else {
+        count = distance <= 0 ? 0 : (distance + stride - 1) / stride;
+    }
+
+    return bs_value_num(count);
+}
+
+// Looks up the jump offset of a constant match case, see bs_compile_match_table()
+static bool bs_match_table_get(Bs *bs, Bs_Value table, Bs_Value value, Bs_Value *offset) {
+    if (value.type == BS_VALUE_NUM && value.as.number == 0) {
+        value = bs_value_num(0); // Negative zero matches zero
+    }
+
+    if (table.as.object->type == BS_OBJECT_ARRAY) {
+        const Bs_Array *array = (const Bs_Array *) table.as.object;
+        if (value.type != BS_VALUE_NUM) {
+            return false;
+        }
+
+        const double at = value.as.number;
+        if (!(at >= 0 && at < array->count) || at != (size_t) at) {
+            return false;
+        }
+
+        *offset = array->data[(size_t) at];
+        return offset->type != BS_VALUE_NIL;
+    }
+
+    return bs_map_get(bs, &((Bs_Table *) table.as.object)->map, value, offset);
+}
+
+// Iteration
+//
+// The hidden iterator local of a for loop is a cursor to the position the next element is searched
+// from. The key and value are only fetched if the loop body actually refers to them
+static size_t bs_iter_read(Bs *bs, Bs_Iter_Bindings *bindings, size_t *cursor) {
+    *bindings = *bs->frame->ip++;
+    *cursor = bs_stack_peek(bs, 0).as.number;
+    return bs_chunk_read_int(bs);
+}
+
+static void bs_iter_next(Bs *bs, size_t cursor, Bs_Value key, Bs_Value value) {
+    bs_stack_set(bs, 0, bs_value_num(cursor)); // Cursor
+    bs_stack_push(bs, key);                    // Key
+    bs_stack_push(bs, value);                  // Value
+}
+
+static void bs_iter_array(
+    Bs *bs, Bs_Iter_Bindings bindings, size_t offset, const Bs_Array *array, size_t cursor) {
+    if (cursor >= array->count) {
+        bs->frame->ip += offset;
+        return;
+    }
+
+    bs_iter_next(
+        bs,
+        cursor + 1,
+        (bindings & BS_ITER_KEY) ? bs_value_num(cursor) : bs_value_nil,
+        (bindings & BS_ITER_VALUE) ? array->data[cursor] : bs_value_nil);
+}
+
+static void
+bs_iter_str(Bs *bs, Bs_Iter_Bindings bindings, size_t offset, const Bs_Str *str, size_t cursor) {
+    if (cursor >= str->size) {
+        bs->frame->ip += offset;
+        return;
+    }
+
+    Bs_Value value = bs_value_nil;
+    if (bindings & BS_ITER_VALUE) {
+        value = bs_value_object(bs_str_new(bs, Bs_Sv(&str->data[cursor], 1)));
+    }
+
+    bs_iter_next(
+        bs, cursor + 1, (bindings & BS_ITER_KEY) ? bs_value_num(cursor) : bs_value_nil, value);
+}
+
+static void
+bs_iter_map(Bs *bs, Bs_Iter_Bindings bindings, size_t offset, const Bs_Map *map, size_t cursor) {
+    while (cursor < map->capacity && map->data[cursor].key.type == BS_VALUE_NIL) {
+        cursor++;
+    }
+
+    if (cursor >= map->capacity) {
+        bs->frame->ip += offset;
+        return;
+    }
+
+    const Bs_Entry *entry = &map->data[cursor];
+    bs_iter_next(
+        bs,
+        cursor + 1,
+        (bindings & BS_ITER_KEY) ? entry->key : bs_value_nil,
+        (bindings & BS_ITER_VALUE) ? entry->value : bs_value_nil);
+}
+
+static const Bs_Map *bs_iter_map_of(Bs_Value container) {
+    if (container.type == BS_VALUE_OBJECT) {
+        if (container.as.object->type == BS_OBJECT_TABLE) {
+            return &((const Bs_Table *) container.as.object)->map;
+        }
+
+        if (container.as.object->type == BS_OBJECT_INSTANCE) {
+            return &((const Bs_Instance *) container.as.object)->properties;
+        }
+    }
+
+    return NULL;
+}
+
+static const Bs_C_Instance *bs_iter_c_instance_of(Bs_Value container) {
+    if (container.type == BS_VALUE_OBJECT && container.as.object->type == BS_OBJECT_C_INSTANCE) {
+        const Bs_C_Instance *instance = (const Bs_C_Instance *) container.as.object;
+        if (instance->class->next || (instance->class->count && instance->class->get)) {
+            return instance;
+        }
+    }
+
+    return NULL;
+}
+
+// Native iterators produce their values one at a time, the key is simply the count so far. Like a
+// native function, the hook may allocate and call back into the VM, so whatever it allocates is kept
+// as a handle until the value is on the stack
+static void bs_iter_c_instance(
+    Bs *bs, Bs_Iter_Bindings bindings, size_t offset, Bs_Value container, size_t cursor) {
+    Bs_C_Instance *instance = (Bs_C_Instance *) container.as.object;
+
+    const bool   handles_on_save = bs->handles_on;
+    const size_t handles_count_save = bs->handles.count;
+    bs->handles_on = true;
+
+    // Indexable ones are iterated like arrays
+    Bs_Value value = bs_value_nil;
+    bool     more;
+    if (instance->class->next) {
+        more = instance->class->next(bs, instance->data, &value);
+    } else {
+        more = cursor < instance->class->count(instance->data);
+        if (more && (bindings & BS_ITER_VALUE)) {
+            value = instance->class->get(bs, instance->data, cursor);
+        }
+    }
+
+    if (more) {
+        bs_iter_next(
+            bs,
+            cursor + 1,
+            (bindings & BS_ITER_KEY) ? bs_value_num(cursor) : bs_value_nil,
+            (bindings & BS_ITER_VALUE) ? value : bs_value_nil);
+    } else {
+        bs->frame->ip += offset;
+    }
+
+    bs->handles_on = handles_on_save;
+    bs->handles.count = handles_count_save;
+}
+
+static_assert(BS_COUNT_OPS == 105, "Update bs_interpret()");
+static void bs_interpret(Bs *bs, Bs_Value *output) {
+    const bool   gc_on_save = bs->gc_on;
+    const bool   handles_on_save = bs->handles_on;
+    const size_t frames_count_save = bs->frames.count;
+
+    bs->gc_on = true;
+    bs->handles_on = false;
+    while (true) {
 #ifdef BS_STEP_DEBUG
         Bs_Writer *w = &bs->config.log;
         bs_fmt(w, "\n----------------------------------------\n");
@@ -1934,26 +2685,51 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
         getchar();
 #endif // BS_STEP_DEBUG
 
+        uint8_t    *site = (uint8_t *) bs->frame->ip;
         const Bs_Op op = *bs->frame->ip++;
+#ifdef BS_OP_PROFILE
+        bs_op_profile(bs, op);
+#endif // BS_OP_PROFILE
+
         switch (op) {
-        case BS_OP_RET:
-            if (bs->frame->closure->defer_started) {
+        case BS_OP_RET: {
+            Bs_Defer *defer = bs_defers_top(bs, bs->frames.count - 1);
+            if (defer && defer->running) {
                 bs->stack.count--; // Drop the result of the previous deferred call
+                bs->defers.count--;
+                defer = bs_defers_top(bs, bs->frames.count - 1);
             }
 
-            if (bs->frame->closure->defers.count) {
+            if (defer) {
                 bs->frame->ip--; // Not ready to return yet!
-                bs->frame->closure->defer_started = true;
+                defer->running = true;
 
-                Bs_Closure *closure =
-                    bs->frame->closure->defers.data[--bs->frame->closure->defers.count];
-                bs_stack_push(bs, bs_value_object(closure));
-                bs_call_stack_top(bs, 0);
+                if (defer->invoke) {
+                    Bs_Value receiver = defer->receiver;
+                    if (receiver.type == BS_VALUE_OBJECT &&
+                        receiver.as.object->type == BS_OBJECT_UPVALUE) {
+                        receiver = *((Bs_Upvalue *) receiver.as.object)->value;
+                    }
+
+                    bs_stack_push(bs, receiver);
+                    bs_invoke(bs, defer->fn, 0);
+                } else {
+                    bs_stack_push(bs, defer->fn);
+                    bs_call_stack_top(bs, 0);
+                }
             } else {
                 const Bs_Value value = bs_stack_pop(bs);
                 bs_close_upvalues(bs, bs->frame->base);
                 bs->frames.count--;
 
+                // The result of a call with borrowed variadic arguments goes below them
+                size_t origin = bs->frame->base - bs->stack.data;
+                if (bs->views.count &&
+                    bs->views.data[bs->views.count - 1].frame == bs->frames.count) {
+                    origin = bs->views.data[bs->views.count - 1].origin;
+                    bs_views_release(bs, bs->views.count - 1);
+                }
+
                 if (bs->frames.count + 1 == frames_count_save) {
                     if (output) {
                         *output = value;
@@ -1965,7 +2741,7 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
                 }
 
                 const Bs_Frame *frame = &bs->frames.data[bs->frames.count];
-                bs->stack.count = bs->frame->base - bs->stack.data;
+                bs->stack.count = origin;
                 bs_stack_push(bs, value);
 
                 bs->frame = &bs->frames.data[bs->frames.count - 1];
@@ -1974,44 +2750,122 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
                     m->done = true;
                     m->result = value;
                 }
+
+                // Carry on with the machine code of the caller, if any, right after the call
+                if (bs->frame->closure->fn->jit) {
+                    bs_jit_enter(bs);
+                }
             }
-            break;
+        } break;
 
         case BS_OP_CALL:
             assert(bs->bases.count);
             bs_call_stack_top(bs, bs->stack.count - bs->bases.data[--bs->bases.count]);
             break;
 
+        case BS_OP_TAIL_CALL: {
+            assert(bs->bases.count);
+            const size_t   arity = bs->stack.count - bs->bases.data[--bs->bases.count];
+            const Bs_Value value = bs_stack_peek(bs, arity);
+
+            // The current frame can only be given up if it has no deferred calls left to run, no
+            // module result to record once the call returns, and neither frame has borrowed
+            // variadic arguments which live below it
+            const Bs_Closure *caller = bs->frame->closure;
+            const bool        tail = value.type == BS_VALUE_OBJECT &&
+                              value.as.object->type == BS_OBJECT_CLOSURE &&
+                              !((Bs_Closure *) value.as.object)->fn->variadic_view &&
+                              !bs_defers_top(bs, bs->frames.count - 1) && !caller->fn->module &&
+                              !caller->fn->variadic_view;
+
+            bs_call_value(bs, 0, value, arity);
+            if (tail) {
+                bs_tail_call_collapse(bs);
+            }
+        } break;
+
         case BS_OP_DEFER: {
             const Bs_Value value = bs_stack_peek(bs, 0);
             assert(value.type == BS_VALUE_OBJECT && value.as.object->type == BS_OBJECT_CLOSURE);
 
-            bs_da_push(bs, &bs->frame->closure->defers, (Bs_Closure *) value.as.object);
+            bs_defers_push(
+                bs,
+                (Bs_Defer) {
+                    .fn = value,
+                    .frame = bs->frames.count - 1,
+                    .ip = bs->frame->ip - bs->frame->closure->fn->chunk.data,
+                });
             bs->stack.count--; // Make sure the deferred closure survives the GC
         } break;
 
+        case BS_OP_DEFER_INVOKE: {
+            const Bs_Value   name = bs_chunk_read_const(bs);
+            const Bs_Capture capture = *bs->frame->ip++;
+            const size_t     index = bs_chunk_read_int(bs);
+
+            // See BS_OP_CLOSURE. Values in locals are never upvalues, so the two can be told apart
+            Bs_Value receiver = bs->frame->base[index];
+            if (capture == BS_CAPTURE_LOCAL) {
+                receiver = bs_value_object(bs_capture_upvalue(bs, bs->frame->base + index));
+            }
+
+            bs_defers_push(
+                bs,
+                (Bs_Defer) {
+                    .fn = name,
+                    .receiver = receiver,
+                    .frame = bs->frames.count - 1,
+                    .ip = bs->frame->ip - bs->frame->closure->fn->chunk.data,
+                    .invoke = true,
+                });
+        } break;
+
         case BS_OP_SPREAD: {
             const Bs_Value value = bs_stack_pop(bs);
             bs_check_object_type(bs, value, BS_OBJECT_ARRAY, "spread value");
 
+            // The values are not part of the stack size of the function, so the rest of it has to
+            // be reserved again on top of them
             const Bs_Array *array = (const Bs_Array *) value.as.object;
+            bs_stack_ensure(
+                bs, bs->stack.count + array->count + bs->frame->closure->fn->stack_size);
+
             for (size_t i = 0; i < array->count; i++) {
                 bs_stack_push(bs, array->data[i]);
             }
         } break;
 
         case BS_OP_CLOSURE: {
-            Bs_Closure *closure = bs_closure_new(bs, (Bs_Fn *) bs_chunk_read_const(bs).as.object);
+            Bs_Fn *fn = (Bs_Fn *) bs_chunk_read_const(bs).as.object;
+            if (!fn->upvalues) {
+                if (!fn->closure) {
+                    fn->closure = bs_closure_new(bs, fn);
+                }
+
+                bs_stack_push(bs, bs_value_object(fn->closure));
+                break;
+            }
+
+            Bs_Closure *closure = bs_closure_new(bs, fn);
             bs_stack_push(bs, bs_value_object(closure));
 
             for (size_t i = 0; i < closure->upvalues; i++) {
-                const bool   local = *bs->frame->ip++;
-                const size_t index = bs_chunk_read_int(bs);
+                const Bs_Capture capture = *bs->frame->ip++;
+                const size_t     index = bs_chunk_read_int(bs);
 
-                if (local) {
-                    closure->data[i] = bs_capture_upvalue(bs, bs->frame->base + index);
-                } else {
+                switch (capture) {
+                case BS_CAPTURE_UPVALUE:
                     closure->data[i] = bs->frame->closure->data[index];
+                    break;
+
+                case BS_CAPTURE_LOCAL:
+                    closure->data[i] =
+                        bs_value_object(bs_capture_upvalue(bs, bs->frame->base + index));
+                    break;
+
+                case BS_CAPTURE_VALUE:
+                    closure->data[i] = bs->frame->base[index];
+                    break;
                 }
             }
         } break;
@@ -2068,71 +2922,9 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
 
             assert(bs->bases.count);
             const size_t arity = bs->stack.count - bs->bases.data[--bs->bases.count];
-
-            const Bs_Value this = bs_stack_peek(bs, arity);
-
-            Bs_Value method;
-            if (this.type == BS_VALUE_NUM) {
-                method = bs_check_map_get(bs, 1, bs_builtin_number_methods_map(bs), name, "method");
-            } else if (this.type == BS_VALUE_OBJECT) {
-                switch (this.as.object->type) {
-                case BS_OBJECT_STR:
-                case BS_OBJECT_ARRAY:
-                    method = bs_check_map_get(
-                        bs,
-                        1,
-                        bs_builtin_object_methods_map(bs, this.as.object->type),
-                        name,
-                        "method");
-                    break;
-
-                case BS_OBJECT_TABLE: {
-                    Bs_Table *table = (Bs_Table *) this.as.object;
-                    if (bs_map_get(bs, &table->map, name, &method)) {
-                        bs_stack_set(bs, arity, method);
-                    } else {
-                        method = bs_check_map_get(
-                            bs,
-                            1,
-                            bs_builtin_object_methods_map(bs, this.as.object->type),
-                            name,
-                            "table key");
-                    }
-                } break;
-
-                case BS_OBJECT_INSTANCE: {
-                    Bs_Instance *instance = (Bs_Instance *) this.as.object;
-                    if (bs_map_get(bs, &instance->properties, name, &method)) {
-                        bs_stack_set(bs, arity, method);
-                    } else {
-                        method = bs_check_map_get(
-                            bs, 1, &instance->class->methods, name, "instance property or method");
-                    }
-                } break;
-
-                case BS_OBJECT_C_INSTANCE: {
-                    Bs_C_Instance *instance = (Bs_C_Instance *) this.as.object;
-                    method = bs_check_map_get(
-                        bs, 1, &instance->class->methods, name, "instance property or method");
-                } break;
-
-                case BS_OBJECT_C_LIB: {
-                    Bs_C_Lib *library = (Bs_C_Lib *) this.as.object;
-                    method = bs_check_map_get(bs, 1, &library->map, name, "library symbol");
-                    bs_stack_set(bs, arity, method);
-                } break;
-
-                default: {
-                    const Bs_Sv sv = bs_value_type_name_full(this);
-                    bs_error_at(bs, 0, "cannot invoke or index into " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
-                } break;
-                }
-            } else {
-                const Bs_Sv sv = bs_value_type_name_full(this);
-                bs_error_at(bs, 0, "cannot invoke or index into " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
+            if (bs_invoke(bs, name, arity)) {
+                bs_quicken(site, BS_OP_INVOKE_INSTANCE);
             }
-
-            bs_call_value(bs, 2, method, arity);
         } break;
 
         case BS_OP_METHOD: {
@@ -2263,24 +3055,28 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
             }
 
             bs_stack_push(bs, bs_value_num(a.as.number + b.as.number));
+            bs_quicken(site, BS_OP_ADD_NUM);
         } break;
 
         case BS_OP_SUB: {
             Bs_Value a, b;
             bs_binary_op(bs, &a, &b, "-");
             bs_stack_push(bs, bs_value_num(a.as.number - b.as.number));
+            bs_quicken(site, BS_OP_SUB_NUM);
         } break;
 
         case BS_OP_MUL: {
             Bs_Value a, b;
             bs_binary_op(bs, &a, &b, "*");
             bs_stack_push(bs, bs_value_num(a.as.number * b.as.number));
+            bs_quicken(site, BS_OP_MUL_NUM);
         } break;
 
         case BS_OP_DIV: {
             Bs_Value a, b;
             bs_binary_op(bs, &a, &b, "/");
             bs_stack_push(bs, bs_value_num(a.as.number / b.as.number));
+            bs_quicken(site, BS_OP_DIV_NUM);
         } break;
 
         case BS_OP_MOD: {
@@ -2375,24 +3171,28 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
             Bs_Value a, b;
             bs_binary_op(bs, &a, &b, ">");
             bs_stack_push(bs, bs_value_bool(a.as.number > b.as.number));
+            bs_quicken(site, BS_OP_GT_NUM);
         } break;
 
         case BS_OP_GE: {
             Bs_Value a, b;
             bs_binary_op(bs, &a, &b, ">=");
             bs_stack_push(bs, bs_value_bool(a.as.number >= b.as.number));
+            bs_quicken(site, BS_OP_GE_NUM);
         } break;
 
         case BS_OP_LT: {
             Bs_Value a, b;
             bs_binary_op(bs, &a, &b, "<");
             bs_stack_push(bs, bs_value_bool(a.as.number < b.as.number));
+            bs_quicken(site, BS_OP_LT_NUM);
         } break;
 
         case BS_OP_LE: {
             Bs_Value a, b;
             bs_binary_op(bs, &a, &b, "<=");
             bs_stack_push(bs, bs_value_bool(a.as.number <= b.as.number));
+            bs_quicken(site, BS_OP_LE_NUM);
         } break;
 
         case BS_OP_EQ: {
@@ -2426,15 +3226,9 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
                 const Bs_Str *str = (Bs_Str *) container.as.object;
                 const Bs_Str *sub = (Bs_Str *) key.as.object;
 
-                bool found = false;
-                if (sub->size) {
-                    for (size_t i = 0; i + sub->size <= str->size; i++) {
-                        if (!memcmp(&str->data[i], sub->data, sub->size)) {
-                            found = true;
-                            break;
-                        }
-                    }
-                }
+                const bool found =
+                    sub->size &&
+                    bs_sv_find_sv(Bs_Sv(str->data, str->size), Bs_Sv(sub->data, sub->size), NULL);
 
                 bs_stack_push(bs, bs_value_bool(found));
             } break;
@@ -2551,6 +3345,16 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
                 size = ((Bs_Table *) a.as.object)->map.length;
                 break;
 
+            case BS_OBJECT_C_INSTANCE: {
+                const Bs_C_Instance *instance = (const Bs_C_Instance *) a.as.object;
+                if (!instance->class->count) {
+                    const Bs_Sv sv = bs_value_type_name_full(a);
+                    bs_error(bs, "cannot get length of " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
+                }
+
+                size = instance->class->count(instance->data);
+            } break;
+
             default: {
                 const Bs_Sv sv = bs_value_type_name_full(a);
                 bs_error(bs, "cannot get length of " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
@@ -2885,20 +3689,34 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
 
         case BS_OP_UGET:
         case BS_OP_URECEIVER: {
-            Bs_Upvalue *upvalue = bs->frame->closure->data[bs_chunk_read_int(bs)];
-            bs_stack_push(bs, *upvalue->value);
+            // User values are never upvalues, so the captures which were copied can be told apart
+            const Bs_Value value = bs->frame->closure->data[bs_chunk_read_int(bs)];
+            if (value.type == BS_VALUE_OBJECT && value.as.object->type == BS_OBJECT_UPVALUE) {
+                bs_stack_push(bs, *((Bs_Upvalue *) value.as.object)->value);
+            } else {
+                bs_stack_push(bs, value);
+            }
         } break;
 
         case BS_OP_USET: {
             const Bs_Value value = bs_stack_peek(bs, 0);
-            Bs_Upvalue    *upvalue = bs->frame->closure->data[bs_chunk_read_int(bs)];
-            *upvalue->value = value;
+            const Bs_Value upvalue = bs->frame->closure->data[bs_chunk_read_int(bs)];
+            assert(upvalue.type == BS_VALUE_OBJECT && upvalue.as.object->type == BS_OBJECT_UPVALUE);
+            *((Bs_Upvalue *) upvalue.as.object)->value = value;
         } break;
 
         case BS_OP_IGET: {
-            const Bs_Value value = bs_container_get(bs, bs_stack_peek(bs, 1), bs_stack_peek(bs, 0));
+            const Bs_Value index = bs_stack_peek(bs, 0);
+            const Bs_Value container = bs_stack_peek(bs, 1);
+
+            const Bs_Value value = bs_container_get(bs, container, index);
             bs->stack.count -= 2;
             bs_stack_push(bs, value);
+
+            if (container.type == BS_VALUE_OBJECT &&
+                container.as.object->type == BS_OBJECT_ARRAY && index.type == BS_VALUE_NUM) {
+                bs_quicken(site, BS_OP_IGET_ARRAY_INDEX);
+            }
         } break;
 
         case BS_OP_IGET_CONST: {
@@ -2922,9 +3740,15 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
             bs->stack.count--;
             break;
 
-        case BS_OP_JUMP:
-            bs->frame->ip += bs_chunk_read_int(bs);
-            break;
+        case BS_OP_JUMP: {
+            const size_t offset = bs_chunk_read_int(bs);
+            bs->frame->ip += offset;
+
+            // Jumping backwards closes a loop
+            if ((int64_t) offset < 0) {
+                bs_jit_tick(bs);
+            }
+        } break;
 
         case BS_OP_ELSE: {
             const size_t offset = bs_chunk_read_int(bs);
@@ -2955,58 +3779,40 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
             }
         } break;
 
+        case BS_OP_MATCH_TABLE: {
+            const Bs_Value table = bs_chunk_read_const(bs);
+
+            Bs_Value offset;
+            if (bs_match_table_get(bs, table, bs_stack_peek(bs, 0), &offset)) {
+                bs->frame->ip += (size_t) offset.as.number;
+            }
+        } break;
+
         case BS_OP_ITER: {
-            const size_t offset = bs_chunk_read_int(bs);
+            Bs_Iter_Bindings bindings;
+            size_t           cursor;
+            const size_t     offset = bs_iter_read(bs, &bindings, &cursor);
 
-            const Bs_Value iterator = bs_stack_peek(bs, 0);
             const Bs_Value container = bs_stack_peek(bs, 1);
-
             if (container.type != BS_VALUE_OBJECT) {
                 const Bs_Sv sv = bs_value_type_name_full(container);
                 bs_error(bs, "cannot iterate over " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
             }
 
+            const Bs_Map *map = bs_iter_map_of(container);
             if (container.as.object->type == BS_OBJECT_ARRAY) {
                 const Bs_Array *array = (const Bs_Array *) container.as.object;
-
-                size_t index;
-                if (iterator.type == BS_VALUE_NIL) {
-                    index = 0;
-                } else {
-                    index = iterator.as.number + 1;
-                }
-
-                if (index >= array->count) {
-                    bs->frame->ip += offset;
-                } else {
-                    bs_stack_set(bs, 0, bs_value_num(index)); // Iterator
-                    bs_stack_push(bs, bs_value_num(index));   // Key
-                    bs_stack_push(bs, array->data[index]);    // Value
-                }
+                bs_iter_array(bs, bindings, offset, array, cursor);
+                bs_quicken(site, BS_OP_ITER_ARRAY);
             } else if (container.as.object->type == BS_OBJECT_STR) {
                 const Bs_Str *str = (const Bs_Str *) container.as.object;
-
-                size_t index;
-                if (iterator.type == BS_VALUE_NIL) {
-                    index = 0;
-                } else {
-                    index = iterator.as.number + 1;
-                }
-
-                if (index >= str->size) {
-                    bs->frame->ip += offset;
-                } else {
-                    bs_stack_set(bs, 0, bs_value_num(index)); // Iterator
-                    bs_stack_push(bs, bs_value_num(index));   // Key
-                    bs_stack_push(
-                        bs, bs_value_object(bs_str_new(bs, Bs_Sv(&str->data[index], 1)))); // Value
-                }
-            } else if (container.as.object->type == BS_OBJECT_TABLE) {
-                const Bs_Table *table = (const Bs_Table *) container.as.object;
-                bs_iter_map(bs, offset, &table->map, iterator);
-            } else if (container.as.object->type == BS_OBJECT_INSTANCE) {
-                const Bs_Instance *instance = (const Bs_Instance *) container.as.object;
-                bs_iter_map(bs, offset, &instance->properties, iterator);
+                bs_iter_str(bs, bindings, offset, str, cursor);
+                bs_quicken(site, BS_OP_ITER_STR);
+            } else if (map) {
+                bs_iter_map(bs, bindings, offset, map, cursor);
+                bs_quicken(site, BS_OP_ITER_MAP);
+            } else if (bs_iter_c_instance_of(container)) {
+                bs_iter_c_instance(bs, bindings, offset, container, cursor);
             } else {
                 const Bs_Sv sv = bs_value_type_name_full(container);
                 bs_error(bs, "cannot iterate over " Bs_Sv_Fmt, Bs_Sv_Arg(sv));
@@ -3015,8 +3821,39 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
 
         case BS_OP_RANGE:
         case BS_OP_IRANGE: {
+            // The bounds were already checked by BS_OP_RANGE_INIT
             const size_t offset = bs_chunk_read_int(bs);
 
+            Bs_Value *count = &bs->stack.data[bs->stack.count - 1];
+            Bs_Value *step = count - 1;
+            Bs_Value *end = count - 2;
+            Bs_Value *start = count - 3;
+
+            bool over;
+            if (count->type == BS_VALUE_NUM) {
+                over = count->as.number == 0;
+                count->as.number--;
+            } else if (op == BS_OP_RANGE) {
+                over = step->as.number > 0 ? (start->as.number >= end->as.number)
+                                           : (start->as.number <= end->as.number);
+            } else {
+                // Inclusive
+                over = step->as.number > 0 ? (start->as.number > end->as.number)
+                                           : (start->as.number < end->as.number);
+            }
+
+            if (over) {
+                bs->frame->ip += offset;
+            } else {
+                const Bs_Value key = *start;
+                start->as.number += step->as.number;
+                bs_stack_push(bs, key);
+            }
+        } break;
+
+        case BS_OP_RANGE_INIT: {
+            const bool inclusive = *bs->frame->ip++;
+
             const Bs_Value start = bs_stack_peek(bs, 2);
             bs_check_value_type_at(bs, 0, start, BS_VALUE_NUM, "range start");
 
@@ -3030,24 +3867,284 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
             }
             bs_check_value_type_at(bs, 2, step, BS_VALUE_NUM, "range step");
 
-            bool over;
-            if (op == BS_OP_RANGE) {
-                over = step.as.number > 0 ? (start.as.number >= end.as.number)
-                                          : (start.as.number <= end.as.number);
-            } else {
-                // Inclusive
-                over = step.as.number > 0 ? (start.as.number > end.as.number)
-                                          : (start.as.number < end.as.number);
+            bs_stack_push(
+                bs, bs_range_count(start.as.number, end.as.number, step.as.number, inclusive));
+        } break;
+
+        case BS_OP_ADD_NUM: {
+            double a, b;
+            if (bs_binary_op_num(bs, site, &a, &b)) {
+                bs_stack_push(bs, bs_value_num(a + b));
             }
+        } break;
 
-            if (over) {
+        case BS_OP_SUB_NUM: {
+            double a, b;
+            if (bs_binary_op_num(bs, site, &a, &b)) {
+                bs_stack_push(bs, bs_value_num(a - b));
+            }
+        } break;
+
+        case BS_OP_MUL_NUM: {
+            double a, b;
+            if (bs_binary_op_num(bs, site, &a, &b)) {
+                bs_stack_push(bs, bs_value_num(a * b));
+            }
+        } break;
+
+        case BS_OP_DIV_NUM: {
+            double a, b;
+            if (bs_binary_op_num(bs, site, &a, &b)) {
+                bs_stack_push(bs, bs_value_num(a / b));
+            }
+        } break;
+
+        case BS_OP_GT_NUM: {
+            double a, b;
+            if (bs_binary_op_num(bs, site, &a, &b)) {
+                bs_stack_push(bs, bs_value_bool(a > b));
+            }
+        } break;
+
+        case BS_OP_GE_NUM: {
+            double a, b;
+            if (bs_binary_op_num(bs, site, &a, &b)) {
+                bs_stack_push(bs, bs_value_bool(a >= b));
+            }
+        } break;
+
+        case BS_OP_LT_NUM: {
+            double a, b;
+            if (bs_binary_op_num(bs, site, &a, &b)) {
+                bs_stack_push(bs, bs_value_bool(a < b));
+            }
+        } break;
+
+        case BS_OP_LE_NUM: {
+            double a, b;
+            if (bs_binary_op_num(bs, site, &a, &b)) {
+                bs_stack_push(bs, bs_value_bool(a <= b));
+            }
+        } break;
+
+        case BS_OP_IGET_ARRAY_INDEX: {
+            const Bs_Value index = bs_stack_peek(bs, 0);
+            const Bs_Value container = bs_stack_peek(bs, 1);
+
+            // Anything other than an in bounds array access is handled by the generic op
+            if (container.type != BS_VALUE_OBJECT ||
+                container.as.object->type != BS_OBJECT_ARRAY || index.type != BS_VALUE_NUM) {
+                bs_dequicken(bs, site);
+                break;
+            }
+
+            const Bs_Array *array = (const Bs_Array *) container.as.object;
+            const double    at = index.as.number;
+            if (!(at >= 0 && at < array->count) || at != (size_t) at) {
+                bs_dequicken(bs, site);
+                break;
+            }
+
+            bs->stack.count--;
+            bs_stack_set(bs, 0, array->data[(size_t) at]);
+        } break;
+
+        case BS_OP_ITER_ARRAY: {
+            Bs_Iter_Bindings bindings;
+            size_t           cursor;
+            const size_t     offset = bs_iter_read(bs, &bindings, &cursor);
+
+            const Bs_Value container = bs_stack_peek(bs, 1);
+            if (container.type != BS_VALUE_OBJECT ||
+                container.as.object->type != BS_OBJECT_ARRAY) {
+                bs_dequicken(bs, site);
+                break;
+            }
+
+            bs_iter_array(bs, bindings, offset, (const Bs_Array *) container.as.object, cursor);
+        } break;
+
+        case BS_OP_ITER_STR: {
+            Bs_Iter_Bindings bindings;
+            size_t           cursor;
+            const size_t     offset = bs_iter_read(bs, &bindings, &cursor);
+
+            const Bs_Value container = bs_stack_peek(bs, 1);
+            if (container.type != BS_VALUE_OBJECT || container.as.object->type != BS_OBJECT_STR) {
+                bs_dequicken(bs, site);
+                break;
+            }
+
+            bs_iter_str(bs, bindings, offset, (const Bs_Str *) container.as.object, cursor);
+        } break;
+
+        case BS_OP_ITER_MAP: {
+            Bs_Iter_Bindings bindings;
+            size_t           cursor;
+            const size_t     offset = bs_iter_read(bs, &bindings, &cursor);
+
+            const Bs_Map *map = bs_iter_map_of(bs_stack_peek(bs, 1));
+            if (!map) {
+                bs_dequicken(bs, site);
+                break;
+            }
+
+            bs_iter_map(bs, bindings, offset, map, cursor);
+        } break;
+
+        case BS_OP_INVOKE_INSTANCE: {
+            const Bs_Value name = bs_chunk_read_const(bs);
+
+            assert(bs->bases.count);
+            const size_t arity = bs->stack.count - bs->bases.data[bs->bases.count - 1];
+
+            const Bs_Value this = bs_stack_peek(bs, arity);
+            if (this.type != BS_VALUE_OBJECT || this.as.object->type != BS_OBJECT_INSTANCE) {
+                bs_dequicken(bs, site);
+                break;
+            }
+            bs->bases.count--;
+
+            const Bs_Value method =
+                bs_invoke_instance_method(bs, (Bs_Instance *) this.as.object, name, arity);
+
+            bs_call_value(bs, 2, method, arity);
+        } break;
+
+        // Superinstructions skip over the original ops that follow them, except when a guard
+        // fails, in which case they behave like the leading LGET and let those ops run
+        case BS_OP_LGET_LGET_ADD: {
+            const Bs_Value a = bs->frame->base[bs_chunk_read_int(bs)];
+            const uint8_t *next = bs->frame->ip;
+
+            bs->frame->ip++; // LGET
+            const Bs_Value b = bs->frame->base[bs_chunk_read_int(bs)];
+            if (a.type != BS_VALUE_NUM || b.type != BS_VALUE_NUM) {
+                bs->frame->ip = next;
+                bs_stack_push(bs, a);
+                break;
+            }
+
+            bs->frame->ip++; // ADD
+            bs_stack_push(bs, bs_value_num(a.as.number + b.as.number));
+        } break;
+
+        case BS_OP_LGET_CONST_LT_ELSE: {
+            const Bs_Value a = bs->frame->base[bs_chunk_read_int(bs)];
+            if (a.type != BS_VALUE_NUM) {
+                bs_stack_push(bs, a);
+                break;
+            }
+
+            bs->frame->ip++; // CONST
+            const Bs_Value b = bs_chunk_read_const(bs);
+
+            bs->frame->ip += 2; // LT, ELSE
+            const size_t offset = bs_chunk_read_int(bs);
+
+            const bool condition = a.as.number < b.as.number;
+            bs_stack_push(bs, bs_value_bool(condition));
+            if (!condition) {
+                bs->frame->ip += offset;
+            }
+        } break;
+
+        case BS_OP_LGET_IGET_CONST: {
+            const Bs_Value container = bs->frame->base[bs_chunk_read_int(bs)];
+
+            bs->frame->ip++; // IGET_CONST
+            bs_stack_push(bs, bs_container_get(bs, container, bs_chunk_read_const(bs)));
+        } break;
+
+        case BS_OP_INCR_LOCAL: {
+            Bs_Value *local = &bs->frame->base[bs_chunk_read_int(bs)];
+            if (local->type != BS_VALUE_NUM) {
+                bs_stack_push(bs, *local);
+                break;
+            }
+
+            bs->frame->ip++; // CONST
+            local->as.number += bs_chunk_read_const(bs).as.number;
+
+            bs->frame->ip += 1 + (1 + sizeof(size_t)) + 1; // ADD, LSET, DROP
+        } break;
+
+        case BS_OP_REG_BINARY:
+        case BS_OP_REG_BINARY_SET:
+        case BS_OP_REG_BINARY_ELSE: {
+            const Bs_Value a = bs->frame->base[bs_chunk_read_int(bs)];
+            const uint8_t *next = bs->frame->ip;
+            const Bs_Value b = bs_register_read(bs);
+
+            Bs_Value result;
+            if (!bs_register_binary(*bs->frame->ip++, a, b, &result)) {
+                bs->frame->ip = next;
+                bs_stack_push(bs, a);
+                break;
+            }
+
+            if (op == BS_OP_REG_BINARY_SET) {
+                bs->frame->ip++; // LSET
+                bs->frame->base[bs_chunk_read_int(bs)] = result;
+                bs->frame->ip++; // DROP
+                break;
+            }
+
+            if (op == BS_OP_REG_BINARY) {
+                bs_stack_push(bs, result);
+                break;
+            }
+
+            // The condition only needs to be pushed for the code at the target of the ELSE, as
+            // the DROP which follows it gets skipped
+            bs->frame->ip++; // ELSE
+            const size_t offset = bs_chunk_read_int(bs);
+            if (bs_value_is_falsey(result)) {
+                bs_stack_push(bs, result);
                 bs->frame->ip += offset;
             } else {
-                bs_stack_set(bs, 2, bs_value_num(start.as.number + step.as.number));
-                bs_stack_push(bs, start);
+                bs->frame->ip++; // DROP
+            }
+        } break;
+
+        case BS_OP_REG_TOP:
+        case BS_OP_REG_TOP_SET: {
+            const Bs_Value a = bs_stack_peek(bs, 0);
+            const Bs_Value b = bs->frame->base[bs_chunk_read_int(bs)];
+
+            Bs_Value result;
+            if (!bs_register_binary(*bs->frame->ip, a, b, &result)) {
+                bs_stack_push(bs, b);
+                break;
+            }
+            bs->frame->ip++; // <binary>
+
+            if (op == BS_OP_REG_TOP_SET) {
+                bs->frame->ip++; // LSET
+                bs->frame->base[bs_chunk_read_int(bs)] = result;
+                bs->frame->ip++; // DROP
+                bs->stack.count--;
+            } else {
+                bs_stack_set(bs, 0, result);
             }
         } break;
 
+        case BS_OP_REG_MOVE: {
+            const Bs_Value value = bs->frame->base[bs_chunk_read_int(bs)];
+
+            bs->frame->ip++; // LSET
+            bs->frame->base[bs_chunk_read_int(bs)] = value;
+            bs->frame->ip++; // DROP
+        } break;
+
+        case BS_OP_REG_LOAD: {
+            const Bs_Value value = bs_chunk_read_const(bs);
+
+            bs->frame->ip++; // LSET
+            bs->frame->base[bs_chunk_read_int(bs)] = value;
+            bs->frame->ip++; // DROP
+        } break;
+
         default:
             bs_error(
                 bs,
@@ -3058,17 +4155,47 @@ static void bs_interpret(Bs *bs, Bs_Value *output) {
     }
 }
 
-Bs_Result bs_run(Bs *bs, Bs_Sv path, Bs_Sv input, bool is_repl) {
+static void bs_run_begin(Bs *bs) {
     bs->config.unwind.ok = true;
     bs->running = true;
     bs->config.unwind.exit = -1;
+}
+
+static Bs_Result bs_run_end(Bs *bs, Bs_Value value) {
+    bs_views_release(bs, 0);
+    bs->defers.count = 0;
+    bs->stack.count = 0;
+    bs->bases.count = 0;
+
+    bs->frame = NULL;
+    bs->frames.count = 0;
+
+    bs->upvalues = NULL;
+    bs->gc_on = false;
+    bs->handles_on = false;
+
+    bs->running = false;
+
+#ifdef BS_STEP_DEBUG
+    bs_fmt(
+        &bs->config.log,
+        "Stopping BS with exit code %d\n",
+        (bs->config.unwind.exit == -1) ? 0 : bs->config.unwind.exit);
+#endif // BS_STEP_DEBUG
 
+    return (Bs_Result) {
+        .ok = bs->config.unwind.ok,
+        .exit = bs->config.unwind.exit,
+        .value = value,
+    };
+}
+
+Bs_Result bs_run(Bs *bs, Bs_Sv path, Bs_Sv input, bool is_repl) {
+    bs_run_begin(bs);
     if (setjmp(bs->config.unwind.point)) {
-        goto end;
+        return bs_run_end(bs, bs_value_nil);
     }
 
-    Bs_Result result = {0};
-
     Bs_Buffer   *b = &bs->paths;
     const size_t start = b->count;
 
@@ -3096,30 +4223,49 @@ Bs_Result bs_run(Bs *bs, Bs_Sv path, Bs_Sv input, bool is_repl) {
     bs_debug_chunk(bs_pretty_printer(bs, &bs->config.log), &closure->fn->chunk);
 #endif // BS_STEP_DEBUG
 
-    result.value = bs_call(bs, bs_value_object(closure), NULL, 0);
+    return bs_run_end(bs, bs_call(bs, bs_value_object(closure), NULL, 0));
+}
 
-end:
-    bs->stack.count = 0;
-    bs->bases.count = 0;
+static void bs_fn_set_module(Bs_Fn *fn, size_t module) {
+    fn->compiled_in_module = module;
+    for (size_t i = 0; i < fn->chunk.constants.count; i++) {
+        const Bs_Value value = fn->chunk.constants.data[i];
+        if (value.type == BS_VALUE_OBJECT && value.as.object->type == BS_OBJECT_FN) {
+            bs_fn_set_module((Bs_Fn *) value.as.object, module);
+        }
+    }
+}
 
-    bs->frame = NULL;
-    bs->frames.count = 0;
+Bs_Result bs_run_fn(Bs *bs, Bs_Sv path, Bs_Fn *fn) {
+    bs_run_begin(bs);
+    if (setjmp(bs->config.unwind.point)) {
+        return bs_run_end(bs, bs_value_nil);
+    }
 
-    bs->upvalues = NULL;
-    bs->gc_on = false;
-    bs->handles_on = false;
+    Bs_Buffer   *b = &bs->paths;
+    const size_t start = b->count;
 
-    bs->running = false;
+    bs_buffer_absolute_path(b, path, (Bs_Sv) {0});
+    bs_module_push(bs, bs_module_new(bs, bs_buffer_reset(b, start)));
 
-#ifdef BS_STEP_DEBUG
-    bs_fmt(
-        &bs->config.log,
-        "Stopping BS with exit code %d\n",
-        (bs->config.unwind.exit == -1) ? 0 : bs->config.unwind.exit);
-#endif // BS_STEP_DEBUG
+    fn->module = bs->modules.count;
+    bs_fn_set_module(fn, fn->module);
+    return bs_run_end(bs, bs_call(bs, bs_value_object(bs_closure_new(bs, fn)), NULL, 0));
+}
+
+static Bs_Value bs_call_end(
+    Bs *bs, size_t stack_count, size_t bases_count, size_t frames_count, Bs_Value result) {
+    bs->stack.count = stack_count;
+    bs->bases.count = bases_count;
+    bs->frames.count = frames_count;
+    bs->frame = bs->frames.count ? &bs->frames.data[bs->frames.count - 1] : NULL;
+    bs->calls--;
 
-    result.ok = bs->config.unwind.ok;
-    result.exit = bs->config.unwind.exit;
+    // The result is no longer on the stack, so a native function which goes on to allocate (say
+    // array.map() storing it) would otherwise lose it to the GC
+    if (bs->handles_on && result.type == BS_VALUE_OBJECT) {
+        bs_object_list_push(&bs->handles, result.as.object);
+    }
     return result;
 }
 
@@ -3130,33 +4276,82 @@ Bs_Value bs_call(Bs *bs, Bs_Value fn, const Bs_Value *args, size_t arity) {
         return bs_value_nil;
     }
 
+    if (bs->calls >= BS_CALLS_CAPACITY) {
+        bs_error_standalone_unwind(bs, "stack overflow");
+    }
+
     const size_t stack_count_save = bs->stack.count;
     const size_t bases_count_save = bs->bases.count;
     const size_t frames_count_save = bs->frames.count;
+    bs->calls++;
 
+    bs_stack_ensure(bs, bs->stack.count + arity + 1);
     bs_stack_push(bs, fn);
     for (size_t i = 0; i < arity; i++) {
         bs_stack_push(bs, args[i]);
     }
     bs_call_stack_top(bs, arity);
 
+    // Only calls which ended up in a closure (including bound methods and class initializers) have
+    // anything left to run, everything else already left its result on the stack
     Bs_Value result;
-    if (fn.as.object->type == BS_OBJECT_CLOSURE) {
+    if (bs->frames.count > frames_count_save) {
         bs_interpret(bs, &result);
-    } else if (fn.as.object->type == BS_OBJECT_CLASS) {
-        Bs_Class *class = (Bs_Class *) fn.as.object;
-        if (class->init) {
-            bs_interpret(bs, &result);
-        } else {
-            result = bs_stack_peek(bs, 0);
-        }
     } else {
         result = bs_stack_peek(bs, 0);
     }
 
-    bs->stack.count = stack_count_save;
-    bs->bases.count = bases_count_save;
-    bs->frames.count = frames_count_save;
-    bs->frame = bs->frames.count ? &bs->frames.data[bs->frames.count - 1] : NULL;
-    return result;
+    return bs_call_end(bs, stack_count_save, bases_count_save, frames_count_save, result);
+}
+
+Bs_Call bs_call_prepare(Bs *bs, Bs_Value fn, size_t arity) {
+    Bs_Call call = {.bs = bs, .fn = fn, .arity = arity, .this = fn};
+    if (fn.type != BS_VALUE_OBJECT) {
+        return call;
+    }
+
+    Bs_Value callee = fn;
+    if (fn.as.object->type == BS_OBJECT_BOUND_METHOD) {
+        const Bs_Bound_Method *method = (const Bs_Bound_Method *) fn.as.object;
+        call.this = method->this;
+        callee = method->fn;
+    }
+
+    // Arity mismatches and variadics are left to bs_call(), which reports or resolves them
+    if (callee.type == BS_VALUE_OBJECT && callee.as.object->type == BS_OBJECT_CLOSURE) {
+        Bs_Closure *closure = (Bs_Closure *) callee.as.object;
+        if (!closure->fn->variadic && closure->fn->arity == arity) {
+            call.closure = closure;
+        }
+    }
+
+    return call;
+}
+
+Bs_Value bs_call_invoke(const Bs_Call *call, const Bs_Value *args) {
+    Bs *bs = call->bs;
+    if (!call->closure || !bs->running) {
+        return bs_call(bs, call->fn, args, call->arity);
+    }
+
+    if (bs->calls >= BS_CALLS_CAPACITY) {
+        bs_error_standalone_unwind(bs, "stack overflow");
+    }
+
+    const size_t stack_count_save = bs->stack.count;
+    const size_t bases_count_save = bs->bases.count;
+    const size_t frames_count_save = bs->frames.count;
+    bs->calls++;
+
+    const size_t base = bs->stack.count;
+    bs_stack_ensure(bs, base + call->arity + 1);
+    bs->stack.data[base] = call->this;
+    memcpy(&bs->stack.data[base + 1], args, call->arity * sizeof(*args));
+    bs->stack.count += call->arity + 1;
+
+    bs_call_closure_frame(bs, 0, call->closure, base);
+
+    Bs_Value result;
+    bs_interpret(bs, &result);
+    return bs_call_end(bs, stack_count_save, bases_count_save, frames_count_save, result);
 }